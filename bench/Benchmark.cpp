@@ -0,0 +1,234 @@
+#include "Benchmark.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<std::uint64_t> gAllocations(0);
+    std::atomic<std::uint64_t> gAllocatedBytes(0);
+}
+
+// Every allocation in the benchmark binary goes through here so it can be
+// counted. Allocations made by TBB's own allocator are not seen.
+void* operator new(std::size_t size)
+{
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    gAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace bench
+{
+    AllocationCount getAllocationCount()
+    {
+        return { gAllocations.load(std::memory_order_relaxed),
+            gAllocatedBytes.load(std::memory_order_relaxed) };
+    }
+
+    State::State(std::uint64_t iterations) :
+        mIterations(iterations),
+        mItems(0),
+        mBytes(0),
+        mRunning(false),
+        mElapsed(0.0),
+        mStart({ 0, 0 }),
+        mAllocations({ 0, 0 })
+    {
+        resumeTiming();
+    }
+
+    std::uint64_t State::iterations() const
+    {
+        return mIterations;
+    }
+
+    void State::pauseTiming()
+    {
+        if (!mRunning)
+        {
+            return;
+        }
+
+        mElapsed += mTimer.elapsed();
+        auto now = getAllocationCount();
+        mAllocations.allocations += now.allocations - mStart.allocations;
+        mAllocations.bytes += now.bytes - mStart.bytes;
+        mRunning = false;
+    }
+
+    void State::resumeTiming()
+    {
+        if (mRunning)
+        {
+            return;
+        }
+
+        mStart = getAllocationCount();
+        mRunning = true;
+        mTimer.start();
+    }
+
+    void State::setItemsProcessed(std::uint64_t items)
+    {
+        mItems = items;
+    }
+
+    void State::setBytesProcessed(std::uint64_t bytes)
+    {
+        mBytes = bytes;
+    }
+
+    double State::elapsed() const
+    {
+        return mElapsed;
+    }
+
+    std::uint64_t State::itemsProcessed() const
+    {
+        return mItems;
+    }
+
+    std::uint64_t State::bytesProcessed() const
+    {
+        return mBytes;
+    }
+
+    AllocationCount State::allocations() const
+    {
+        return mAllocations;
+    }
+
+    Suite::Suite(double minTime) :
+        mMinTime(minTime)
+    { }
+
+    void Suite::add(std::string const& name, BenchmarkFn const& fn)
+    {
+        mEntries.push_back({ name, fn });
+    }
+
+    std::vector<Result> Suite::run(std::string const& filter) const
+    {
+        std::vector<Result> results;
+        for (auto& entry : mEntries)
+        {
+            if (entry.name.find(filter) == std::string::npos)
+            {
+                continue;
+            }
+
+            INFO_LOG_V("Running %s.", entry.name.c_str());
+            results.push_back(runOne(entry));
+        }
+
+        return results;
+    }
+
+    Result Suite::runOne(Entry const& entry) const
+    {
+        static constexpr std::uint64_t maxIterations = 1000000000;
+
+        std::uint64_t iterations = 1;
+        while (true)
+        {
+            State state(iterations);
+            entry.fn(state);
+            state.pauseTiming();
+
+            double elapsed = state.elapsed();
+            if (elapsed >= mMinTime || iterations >= maxIterations)
+            {
+                double ops = static_cast<double>(iterations);
+                auto allocations = state.allocations();
+
+                Result result;
+                result.name = entry.name;
+                result.iterations = iterations;
+                result.nsPerOp = elapsed * 1e9 / ops;
+                result.itemsPerSecond = (elapsed > 0.0) ?
+                    state.itemsProcessed() / elapsed : 0.0;
+                result.bytesPerSecond = (elapsed > 0.0) ?
+                    state.bytesProcessed() / elapsed : 0.0;
+                result.allocationsPerOp = allocations.allocations / ops;
+                result.allocatedBytesPerOp = allocations.bytes / ops;
+                return result;
+            }
+
+            // Aim a little past the minimum time, but never grow by more
+            // than 10x at once in case the first runs were not
+            // representative.
+            double scale = (elapsed > 0.0) ? 1.4 * mMinTime / elapsed : 10.0;
+            scale = std::min(std::max(scale, 2.0), 10.0);
+            iterations = std::min(maxIterations,
+                static_cast<std::uint64_t>(iterations * scale));
+        }
+    }
+
+    void printResults(std::vector<Result> const& results, std::ostream& out)
+    {
+        auto formatRate = [](double rate)
+        {
+            static const char* suffixes[] = { "", "k", "M", "G", "T" };
+            int suffix = 0;
+            while (rate >= 1000.0 && suffix < 4)
+            {
+                rate /= 1000.0;
+                ++suffix;
+            }
+
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.2f%s", rate,
+                suffixes[suffix]);
+            return std::string(buffer);
+        };
+
+        std::size_t width = 9;
+        for (auto& result : results)
+        {
+            width = std::max(width, result.name.size());
+        }
+
+        char line[256];
+        std::snprintf(line, sizeof(line),
+            "%-*s %12s %14s %12s %12s %12s %14s\n", static_cast<int>(width),
+            "Benchmark", "Iterations", "ns/op", "items/s", "bytes/s",
+            "allocs/op", "alloc bytes/op");
+        out << line;
+        out << std::string(width + 84, '-') << "\n";
+
+        for (auto& result : results)
+        {
+            std::snprintf(line, sizeof(line),
+                "%-*s %12llu %14.1f %12s %12s %12.2f %14.1f\n",
+                static_cast<int>(width), result.name.c_str(),
+                static_cast<unsigned long long>(result.iterations),
+                result.nsPerOp, formatRate(result.itemsPerSecond).c_str(),
+                formatRate(result.bytesPerSecond).c_str(),
+                result.allocationsPerOp, result.allocatedBytesPerOp);
+            out << line;
+        }
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef BSOID_BENCH_BENCHMARK_HPP
+#define BSOID_BENCH_BENCHMARK_HPP
+
+#pragma once
+
+#include <atlas/core/Timer.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+    // Number of heap allocations made through the global operator new since
+    // the program started, across all threads.
+    struct AllocationCount
+    {
+        std::uint64_t allocations;
+        std::uint64_t bytes;
+    };
+
+    AllocationCount getAllocationCount();
+
+    // Keeps the compiler from discarding a value that is computed but never
+    // used.
+    template <typename T>
+    inline void doNotOptimize(T const& value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "g"(&value) : "memory");
+#else
+        static void const* volatile sink;
+        sink = &value;
+#endif
+    }
+
+    // Passed to every benchmark, which has to run its operation
+    // iterations() times. Anything done between pauseTiming and resumeTiming
+    // is left out of both the time and the allocation count.
+    class State
+    {
+    public:
+        State(std::uint64_t iterations);
+
+        std::uint64_t iterations() const;
+
+        void pauseTiming();
+        void resumeTiming();
+
+        void setItemsProcessed(std::uint64_t items);
+        void setBytesProcessed(std::uint64_t bytes);
+
+        double elapsed() const;
+        std::uint64_t itemsProcessed() const;
+        std::uint64_t bytesProcessed() const;
+        AllocationCount allocations() const;
+
+    private:
+        std::uint64_t mIterations;
+        std::uint64_t mItems, mBytes;
+        bool mRunning;
+
+        atlas::core::Timer<double> mTimer;
+        double mElapsed;
+
+        AllocationCount mStart, mAllocations;
+    };
+
+    struct Result
+    {
+        std::string name;
+        std::uint64_t iterations;
+        double nsPerOp;
+        double itemsPerSecond;
+        double bytesPerSecond;
+        double allocationsPerOp;
+        double allocatedBytesPerOp;
+    };
+
+    using BenchmarkFn = std::function<void(State&)>;
+
+    // A list of named benchmarks. Each one is run with a growing number of
+    // iterations until a single run takes at least the minimum time, and the
+    // last run is reported.
+    class Suite
+    {
+    public:
+        Suite(double minTime = 0.5);
+
+        void add(std::string const& name, BenchmarkFn const& fn);
+
+        // Runs the benchmarks whose name contains the filter.
+        std::vector<Result> run(std::string const& filter = "") const;
+
+    private:
+        struct Entry
+        {
+            std::string name;
+            BenchmarkFn fn;
+        };
+
+        Result runOne(Entry const& entry) const;
+
+        double mMinTime;
+        std::vector<Entry> mEntries;
+    };
+
+    void printResults(std::vector<Result> const& results, std::ostream& out);
+}
+
+#endif
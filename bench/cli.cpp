@@ -0,0 +1,7 @@
+#include "bsoid/driver/Driver.hpp"
+
+// Headless driver that is built even when the main executable has the GUI.
+int main(int argc, char** argv)
+{
+    return bsoid::driver::run(argc, argv);
+}
@@ -0,0 +1,486 @@
+#include "Benchmark.hpp"
+
+#include "bsoid/Bsoid.hpp"
+#include "bsoid/models/Models.hpp"
+#include "bsoid/polygonizer/Hash.hpp"
+#include "bsoid/polygonizer/MeshSink.hpp"
+#include "bsoid/polygonizer/Tables.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+
+namespace bsoid
+{
+    namespace polygonizer
+    {
+        struct BenchmarkAccess
+        {
+            static void makeVoxels(Bsoid& soid)
+            {
+                soid.makeVoxels();
+            }
+
+            static VoxelList const& getVoxels(Bsoid const& soid)
+            {
+                return soid.mVoxels;
+            }
+
+            static float getIsoValue(Bsoid const& soid)
+            {
+                return soid.mMagic;
+            }
+
+            static void clearVoxelPoints(Bsoid& soid)
+            {
+                soid.mSeenPoints.clear();
+            }
+
+            static void clearLinePoints(Bsoid& soid)
+            {
+                soid.mComputedPoints.clear();
+            }
+
+            static FieldPoint findVoxelPoint(Bsoid& soid, PointId const& id)
+            {
+                return soid.findVoxelPoint(id);
+            }
+
+            static void fillVoxel(Bsoid& soid, Voxel& v)
+            {
+                soid.fillVoxel(v);
+            }
+
+            static FieldPoint generateLinePoint(Bsoid& soid, PointId const& p1,
+                PointId const& p2, FieldPoint const& fp1, FieldPoint const& fp2)
+            {
+                return soid.generateLinePoint(p1, p2, fp1, fp2).point;
+            }
+
+            static void constructGrid(MarchingCubes& mc)
+            {
+                mc.constructGrid();
+            }
+
+            static std::size_t createTriangles(MarchingCubes& mc,
+                MeshSink& sink)
+            {
+                return mc.createTriangles(sink);
+            }
+        };
+    }
+}
+
+namespace
+{
+    using bench::State;
+    using bench::doNotOptimize;
+    using bsoid::polygonizer::BenchmarkAccess;
+
+    // Every random input is drawn from generators seeded with this value so
+    // runs can be compared against each other.
+    constexpr std::uint32_t Seed = 2018;
+    constexpr std::size_t NumSamples = 4096;
+
+    // Resolutions of the polygonizer benchmarks. The particles model is used
+    // throughout since it has the most fields per super-voxel.
+    const bsoid::models::Resolution SurfaceResolution = { 128, 32 };
+    constexpr std::uint32_t GridResolution = 64;
+
+    // Built the first time a benchmark that needs it runs, so filtered runs
+    // skip the setup of everything else. The setup is not timed.
+    template <typename T>
+    class Fixture
+    {
+    public:
+        Fixture(std::function<std::unique_ptr<T>()> const& make) :
+            mMake(make)
+        { }
+
+        T& get(State& state)
+        {
+            if (!mValue)
+            {
+                state.pauseTiming();
+                mValue = mMake();
+                state.resumeTiming();
+            }
+            return *mValue;
+        }
+
+    private:
+        std::function<std::unique_ptr<T>()> mMake;
+        std::unique_ptr<T> mValue;
+    };
+
+    template <typename T>
+    using FixturePtr = std::shared_ptr<Fixture<T>>;
+
+    template <typename T>
+    FixturePtr<T> makeFixture(std::function<std::unique_ptr<T>()> const& make)
+    {
+        return std::make_shared<Fixture<T>>(make);
+    }
+
+    struct Edge
+    {
+        bsoid::polygonizer::PointId p1, p2;
+        bsoid::polygonizer::FieldPoint fp1, fp2;
+    };
+
+    // A polygonizer that has gone through the surface march, along with the
+    // distinct voxel corners and surface edges that it visited.
+    struct Surface
+    {
+        Surface() :
+            soid(bsoid::models::makeParticles(SurfaceResolution))
+        { }
+
+        bsoid::polygonizer::Bsoid soid;
+        std::vector<bsoid::polygonizer::VoxelId> voxels;
+        std::vector<bsoid::polygonizer::PointId> points;
+        std::vector<Edge> edges;
+    };
+
+    std::unique_ptr<Surface> makeSurface()
+    {
+        using bsoid::polygonizer::BsoidHash64;
+        using bsoid::polygonizer::VoxelDecals;
+        using bsoid::polygonizer::EdgeDecals;
+
+        auto surface = std::make_unique<Surface>();
+        BenchmarkAccess::makeVoxels(surface->soid);
+        auto const& voxels = BenchmarkAccess::getVoxels(surface->soid);
+        float iso = BenchmarkAccess::getIsoValue(surface->soid);
+
+        std::set<std::uint64_t> seenPoints;
+        std::set<std::pair<std::uint64_t, std::uint64_t>> seenEdges;
+        for (auto& voxel : voxels)
+        {
+            surface->voxels.push_back(voxel.id);
+            for (auto& decal : VoxelDecals)
+            {
+                auto id = voxel.id + decal;
+                auto hash = BsoidHash64::hash(id.x, id.y, id.z);
+                if (seenPoints.insert(hash).second)
+                {
+                    surface->points.push_back(id);
+                }
+            }
+
+            for (auto& edge : EdgeDecals)
+            {
+                auto const& fp1 = voxel.points[edge.x];
+                auto const& fp2 = voxel.points[edge.y];
+                if ((fp1.value.w < iso) == (fp2.value.w < iso))
+                {
+                    continue;
+                }
+
+                auto p1 = voxel.id + VoxelDecals[edge.x];
+                auto p2 = voxel.id + VoxelDecals[edge.y];
+                auto h1 = BsoidHash64::hash(p1.x, p1.y, p1.z);
+                auto h2 = BsoidHash64::hash(p2.x, p2.y, p2.z);
+                auto key = std::make_pair(std::min(h1, h2), std::max(h1, h2));
+                if (seenEdges.insert(key).second)
+                {
+                    surface->edges.push_back({ p1, p2, fp1, fp2 });
+                }
+            }
+        }
+
+        return surface;
+    }
+
+    std::unique_ptr<bsoid::polygonizer::MarchingCubes> makeGrid()
+    {
+        auto mc = std::make_unique<bsoid::polygonizer::MarchingCubes>(
+            bsoid::models::makeMCParticles({ GridResolution, 0 }));
+        BenchmarkAccess::constructGrid(*mc);
+        return mc;
+    }
+
+    std::unique_ptr<atlas::utils::Mesh> makeMesh()
+    {
+        auto soid = bsoid::models::makeParticles(SurfaceResolution);
+        soid.polygonize();
+        return std::make_unique<atlas::utils::Mesh>(
+            std::move(soid.getMesh()));
+    }
+
+    std::vector<atlas::math::Point> makeSamples(
+        bsoid::tree::BlobTree const& tree)
+    {
+        std::mt19937 engine(Seed);
+        auto box = tree.getTreeBox();
+        std::uniform_real_distribution<float> x(box.pMin.x, box.pMax.x);
+        std::uniform_real_distribution<float> y(box.pMin.y, box.pMax.y);
+        std::uniform_real_distribution<float> z(box.pMin.z, box.pMax.z);
+
+        std::vector<atlas::math::Point> samples(NumSamples);
+        for (auto& sample : samples)
+        {
+            sample = { x(engine), y(engine), z(engine) };
+        }
+
+        return samples;
+    }
+
+    void addFieldBenchmarks(bench::Suite& suite, std::string const& name,
+        bsoid::tree::BlobTree const& tree)
+    {
+        auto samples = makeSamples(tree);
+
+        suite.add("eval/" + name, [tree, samples](State& state)
+        {
+            for (std::uint64_t i = 0; i < state.iterations(); ++i)
+            {
+                doNotOptimize(tree.eval(samples[i % NumSamples]));
+            }
+            state.setItemsProcessed(state.iterations());
+        });
+
+        suite.add("grad/" + name, [tree, samples](State& state)
+        {
+            for (std::uint64_t i = 0; i < state.iterations(); ++i)
+            {
+                doNotOptimize(tree.grad(samples[i % NumSamples]));
+            }
+            state.setItemsProcessed(state.iterations());
+        });
+    }
+
+    void addSubTreeBenchmark(bench::Suite& suite, std::string const& name,
+        bsoid::tree::BlobTree const& tree)
+    {
+        using atlas::utils::BBox;
+        using atlas::math::Point;
+
+        // One query per super-voxel of the surface resolution.
+        auto svSize = std::get<1>(SurfaceResolution);
+        auto box = tree.getTreeBox();
+        auto delta = (box.pMax - box.pMin) / static_cast<float>(svSize);
+        std::vector<BBox> cells;
+        for (std::size_t x = 0; x < svSize; ++x)
+        {
+            for (std::size_t y = 0; y < svSize; ++y)
+            {
+                for (std::size_t z = 0; z < svSize; ++z)
+                {
+                    Point pt = box.pMin + Point(x, y, z) * delta;
+                    cells.emplace_back(pt, pt + delta);
+                }
+            }
+        }
+
+        suite.add("subTree/" + name, [tree, cells](State& state)
+        {
+            for (std::uint64_t i = 0; i < state.iterations(); ++i)
+            {
+                doNotOptimize(tree.getSubTree(cells[i % cells.size()]));
+            }
+            state.setItemsProcessed(state.iterations());
+        });
+    }
+
+    void addBsoidBenchmarks(bench::Suite& suite)
+    {
+        auto surface = makeFixture<Surface>(makeSurface);
+
+        // The point caches are cleared whenever the inputs wrap around so
+        // every call takes the uncached path.
+        suite.add("bsoid/findVoxelPoint", [surface](State& state)
+        {
+            auto& s = surface->get(state);
+            std::size_t next = s.points.size();
+            for (std::uint64_t i = 0; i < state.iterations(); ++i)
+            {
+                if (next == s.points.size())
+                {
+                    state.pauseTiming();
+                    BenchmarkAccess::clearVoxelPoints(s.soid);
+                    next = 0;
+                    state.resumeTiming();
+                }
+
+                doNotOptimize(BenchmarkAccess::findVoxelPoint(s.soid,
+                    s.points[next++]));
+            }
+            state.setItemsProcessed(state.iterations());
+        });
+
+        suite.add("bsoid/generateLinePoint", [surface](State& state)
+        {
+            auto& s = surface->get(state);
+            std::size_t next = s.edges.size();
+            for (std::uint64_t i = 0; i < state.iterations(); ++i)
+            {
+                if (next == s.edges.size())
+                {
+                    state.pauseTiming();
+                    BenchmarkAccess::clearLinePoints(s.soid);
+                    next = 0;
+                    state.resumeTiming();
+                }
+
+                auto const& edge = s.edges[next++];
+                doNotOptimize(BenchmarkAccess::generateLinePoint(s.soid,
+                    edge.p1, edge.p2, edge.fp1, edge.fp2));
+            }
+            state.setItemsProcessed(state.iterations());
+        });
+
+        suite.add("bsoid/fillVoxel", [surface](State& state)
+        {
+            auto& s = surface->get(state);
+            std::size_t next = s.voxels.size();
+            for (std::uint64_t i = 0; i < state.iterations(); ++i)
+            {
+                if (next == s.voxels.size())
+                {
+                    state.pauseTiming();
+                    BenchmarkAccess::clearVoxelPoints(s.soid);
+                    next = 0;
+                    state.resumeTiming();
+                }
+
+                bsoid::polygonizer::Voxel voxel(s.voxels[next++]);
+                BenchmarkAccess::fillVoxel(s.soid, voxel);
+                doNotOptimize(voxel);
+            }
+            state.setItemsProcessed(state.iterations());
+        });
+    }
+
+    void addMarchingCubesBenchmarks(bench::Suite& suite)
+    {
+        auto grid = makeFixture<bsoid::polygonizer::MarchingCubes>(makeGrid);
+        constexpr std::uint64_t numPoints =
+            GridResolution * GridResolution * GridResolution;
+        constexpr std::uint64_t numCubes = (GridResolution - 1) *
+            (GridResolution - 1) * (GridResolution - 1);
+
+        suite.add("mc/constructGrid", [grid](State& state)
+        {
+            auto& mc = grid->get(state);
+            for (std::uint64_t i = 0; i < state.iterations(); ++i)
+            {
+                BenchmarkAccess::constructGrid(mc);
+            }
+            state.setItemsProcessed(state.iterations() * numPoints);
+        });
+
+        suite.add("mc/createTriangles", [grid](State& state)
+        {
+            auto& mc = grid->get(state);
+            for (std::uint64_t i = 0; i < state.iterations(); ++i)
+            {
+                bsoid::polygonizer::NullMeshSink sink;
+                doNotOptimize(BenchmarkAccess::createTriangles(mc, sink));
+            }
+            state.setItemsProcessed(state.iterations() * numCubes);
+        });
+    }
+
+    void addMeshBenchmarks(bench::Suite& suite)
+    {
+        using atlas::utils::Mesh;
+        using atlas::utils::MeshFormat;
+
+        auto mesh = makeFixture<Mesh>(makeMesh);
+
+        suite.add("mesh/fromTriangleSoup", [mesh](State& state)
+        {
+            auto& m = mesh->get(state);
+
+            // Unweld the mesh so every triangle has its own vertices.
+            state.pauseTiming();
+            std::vector<atlas::math::Point> vertices;
+            std::vector<atlas::math::Normal> normals;
+            std::vector<GLuint> indices;
+            for (auto index : m.indices())
+            {
+                indices.push_back(static_cast<GLuint>(vertices.size()));
+                vertices.push_back(m.vertices()[index]);
+                normals.push_back(m.normals()[index]);
+            }
+            state.resumeTiming();
+
+            for (std::uint64_t i = 0; i < state.iterations(); ++i)
+            {
+                Mesh result;
+                Mesh::fromTriangleSoup(vertices, indices, result, normals);
+                doNotOptimize(result);
+            }
+            state.setItemsProcessed(state.iterations() * indices.size() / 3);
+        });
+
+        for (auto format : { MeshFormat::OBJ, MeshFormat::PLY,
+            MeshFormat::QMESH })
+        {
+            auto extension = atlas::utils::getFormatExtension(format);
+            suite.add("mesh/saveToFile" + extension,
+                [mesh, format, extension](State& state)
+            {
+                auto& m = mesh->get(state);
+                std::string filename = "bsoid_bench_mesh" + extension;
+                for (std::uint64_t i = 0; i < state.iterations(); ++i)
+                {
+                    m.saveToFile(filename, format);
+                }
+
+                state.pauseTiming();
+                std::ifstream file(filename,
+                    std::ifstream::binary | std::ifstream::ate);
+                std::uint64_t size = static_cast<std::uint64_t>(file.tellg());
+                file.close();
+                std::remove(filename.c_str());
+                state.resumeTiming();
+
+                state.setItemsProcessed(state.iterations() *
+                    m.indices().size() / 3);
+                state.setBytesProcessed(state.iterations() * size);
+            });
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    INFO_LOG_V("Bsoid %s benchmarks.", BSOID_VERSION_STRING);
+
+    // Usage: bsoid_bench [filter] [min seconds per benchmark]
+    std::string filter = (argc > 1) ? argv[1] : "";
+    double minTime = (argc > 2) ? std::atof(argv[2]) : 0.5;
+
+    bench::Suite suite(minTime);
+
+    addFieldBenchmarks(suite, "sphere", bsoid::models::makeSphereTree());
+    addFieldBenchmarks(suite, "torus", bsoid::models::makeTorusTree());
+    addFieldBenchmarks(suite, "blend", bsoid::models::makeBlendTree());
+    addFieldBenchmarks(suite, "intersection",
+        bsoid::models::makeIntersectionTree());
+    addFieldBenchmarks(suite, "union", bsoid::models::makeUnionTree());
+    addFieldBenchmarks(suite, "transform", bsoid::models::makeTransformTree());
+    addFieldBenchmarks(suite, "butterfly", bsoid::models::makeButterflyTree());
+    addFieldBenchmarks(suite, "particles", bsoid::models::makeParticlesTree());
+
+    addSubTreeBenchmark(suite, "butterfly", bsoid::models::makeButterflyTree());
+    addSubTreeBenchmark(suite, "particles", bsoid::models::makeParticlesTree());
+
+    addBsoidBenchmarks(suite);
+    addMarchingCubesBenchmarks(suite);
+    addMeshBenchmarks(suite);
+
+    auto results = suite.run(filter);
+    bench::printResults(results, std::cout);
+
+    return 0;
+}
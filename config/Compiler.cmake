@@ -26,6 +26,10 @@ if (BSOID_PARALLEL)
     add_definitions(-DBSOID_PARALLEL)
 endif()
 
+# The utilization observer watches a single arena, which TBB 2019 only offers
+# as a preview feature.
+add_definitions(-DTBB_PREVIEW_LOCAL_OBSERVER=1)
+
 # Now set the compiler flags, notice that Windows requires a different syntax
 # for flags than Linux does, so lets handle that one first.
 if (WIN32)
@@ -12,6 +12,7 @@ source_group("include\\bsoid\\polygonizer" FILES
 source_group("include\\bsoid\\visualizer" FILES
     ${BSOID_INCLUDE_VISUALIZER_GROUP})
 source_group("include\\bsoid\\models" FILES ${BSOID_INCLUDE_MODELS_GROUP})
+source_group("include\\bsoid\\driver" FILES ${BSOID_INCLUDE_DRIVER_GROUP})
 
 source_group("source" FILES ${BSOID_SOURCE_TOP_GROUP})
 source_group("source\\bsoid" FILES)
@@ -21,6 +22,7 @@ source_group("source\\bsoid\\polygonizer" FILES
 source_group("source\\bsoid\\visualizer" FILES
     ${BSOID_SOURCE_VISUALIZER_GROUP})
 source_group("source\\bsoid\\models" FILES ${BSOID_SOURCE_MODELS_GROUP})
+source_group("source\\bsoid\\driver" FILES ${BSOID_SOURCE_DRIVER_GROUP})
 
 source_group("shader" FILES ${BSOID_SHADER_TOP_GROUP})
 source_group("shader\\bsoid" FILES)
@@ -0,0 +1,149 @@
+#ifndef BSOID_INCLUDE_BSOID_DRIVER_DRIVER_HPP
+#define BSOID_INCLUDE_BSOID_DRIVER_DRIVER_HPP
+
+#pragma once
+
+#include "bsoid/polygonizer/Stats.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bsoid
+{
+    namespace driver
+    {
+        // When the mesh of a run is simplified. Streaming simplifies every
+        // chunk as the polygonizer writes it, but the border of a chunk is
+        // kept, so it only reaches its target on large chunks. The automatic
+        // mode therefore streams the blocks of marching cubes but simplifies
+        // the whole mesh of Bsoid, whose supervoxel chunks are mostly border.
+        enum class SimplifyMode
+        {
+            Automatic,
+            Stream,
+            Mesh
+        };
+
+        // Decimation of the mesh of every run. The simplification is part of
+        // the measured time.
+        struct SimplifyOptions
+        {
+            SimplifyOptions();
+
+            // Fraction of the triangles to keep, 1 turns it off.
+            float ratio;
+
+            // Largest distance a vertex may move away from the planes of the
+            // triangles it absorbs, in model units.
+            float maxError;
+
+            SimplifyMode mode;
+        };
+
+        // Settings of a headless run. Every combination of model, algorithm,
+        // resolution and thread count is polygonized reps times, after
+        // warmup runs that are not reported.
+        struct Options
+        {
+            Options();
+
+            std::vector<std::string> models;
+            std::vector<std::string> algorithms;
+            std::vector<std::size_t> resolutions;
+
+            // Supervoxel resolutions for Bsoid. Empty means a quarter of the
+            // grid resolution.
+            std::vector<std::size_t> svResolutions;
+
+            // 0 lets TBB pick the number of threads.
+            std::vector<int> threads;
+
+            std::size_t reps;
+            std::size_t warmup;
+            bool optimize;
+
+            std::string format;
+            std::string output;
+
+            // Chrome trace of the profiler zones, only recorded when Atlas is
+            // built with ATLAS_ENABLE_PROFILING.
+            std::string trace;
+
+            // Prefix of the per-supervoxel CSV files written for Bsoid runs.
+            std::string heatmap;
+
+            // Baseline to check against instead of running the sweep, and
+            // whether to overwrite its values with the new measurements.
+            std::string baseline;
+            bool updateBaseline;
+
+            // Runs a strong or weak scaling study instead of the sweep when
+            // set to "strong" or "weak".
+            std::string scaling;
+
+            // Records per-thread busy, idle and serial time of every phase.
+            // Task bodies are timed, so this slows the runs down slightly.
+            bool utilization;
+
+            SimplifyOptions simplify;
+        };
+
+        // The measurements of a single polygonization.
+        struct RunRecord
+        {
+            RunRecord();
+
+            std::string model;
+            std::string algorithm;
+            std::size_t resolution;
+            std::size_t svResolution;
+            int threads;
+            std::size_t rep;
+
+            std::vector<polygonizer::PhaseStats> phases;
+            std::vector<std::pair<std::string, double>> sections;
+            double total;
+
+            std::uint64_t evaluations;
+            std::uint64_t vertices;
+            std::uint64_t triangles;
+
+            // Bytes held by the polygonizer's containers at the end and at
+            // most during any phase, the allocations they made, and the peak
+            // resident set size of the process.
+            std::size_t memory;
+            std::size_t peakBytes;
+            std::uint64_t allocations;
+            std::size_t peakRSS;
+
+            // Cache and traversal counters reported by the polygonizer.
+            std::vector<std::pair<std::string, std::uint64_t>> counters;
+        };
+
+        // Parses --name=value arguments. Returns false and logs the problem
+        // if an argument is not understood.
+        bool parseOptions(int argc, char** argv, Options& options);
+        void printUsage(std::ostream& out);
+
+        bool runOnce(std::string const& model, std::string const& algorithm,
+            std::size_t resolution, std::size_t svResolution, int threads,
+            bool optimize, RunRecord& record,
+            std::string const& heatmap = "",
+            SimplifyOptions const& simplify = SimplifyOptions());
+        bool runAll(Options const& options, std::vector<RunRecord>& records);
+
+        void writeCsv(std::vector<RunRecord> const& records,
+            std::ostream& out);
+        void writeJson(std::vector<RunRecord> const& records,
+            std::ostream& out);
+
+        // Entry point of the headless executable.
+        int run(int argc, char** argv);
+    }
+}
+
+#endif
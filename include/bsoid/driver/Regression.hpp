@@ -0,0 +1,91 @@
+#ifndef BSOID_INCLUDE_BSOID_DRIVER_REGRESSION_HPP
+#define BSOID_INCLUDE_BSOID_DRIVER_REGRESSION_HPP
+
+#pragma once
+
+#include "bsoid/driver/Driver.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bsoid
+{
+    namespace driver
+    {
+        // Largest growth accepted before a metric counts as a regression,
+        // as a fraction of the baseline value. Wall time depends on the
+        // machine and its load, so its band is wide and a negative value
+        // only reports it. Runs on more threads than there are cores are
+        // never gated on time. Evaluations are exact on one thread, but with
+        // more threads two of them can evaluate the same point at once, so
+        // the tolerance absorbs those redundant evaluations.
+        struct Tolerance
+        {
+            Tolerance();
+
+            double seconds;
+            double evaluations;
+            double peakBytes;
+        };
+
+        // The expected result of one configuration. Seconds is the median
+        // of the measured runs, the other values are the medians as well
+        // although they rarely change between runs.
+        struct BaselineEntry
+        {
+            BaselineEntry();
+
+            std::string model;
+            std::string algorithm;
+            std::size_t resolution;
+            std::size_t svResolution;
+            int threads;
+
+            double seconds;
+            std::uint64_t evaluations;
+            std::size_t peakBytes;
+        };
+
+        // A checked-in set of configurations together with how they are
+        // run and how much they may drift.
+        struct Baseline
+        {
+            Baseline();
+
+            std::size_t reps;
+            std::size_t warmup;
+            bool optimize;
+            Tolerance tolerance;
+            std::vector<BaselineEntry> entries;
+        };
+
+        bool loadBaseline(std::string const& filename, Baseline& baseline);
+        bool saveBaseline(std::string const& filename,
+            Baseline const& baseline);
+
+        // Collapses the repetitions of every configuration into their
+        // medians, keeping the order in which configurations first appear.
+        std::vector<BaselineEntry> summarize(
+            std::vector<RunRecord> const& records);
+
+        // Runs every configuration of the baseline and returns the medians.
+        bool measureBaseline(Baseline const& baseline,
+            std::vector<BaselineEntry>& measured);
+
+        // Writes a table comparing the measurements with the baseline.
+        // Returns false if the median time, evaluations or peak bytes are
+        // outside their tolerance or a configuration was not measured.
+        bool compareBaseline(Baseline const& baseline,
+            std::vector<BaselineEntry> const& measured, std::ostream& out);
+
+        // Runs the baseline and compares against it, or replaces its values
+        // with the new measurements if update is set. Returns the exit code
+        // of the executable.
+        int checkBaseline(std::string const& filename, bool update);
+    }
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef BSOID_INCLUDE_BSOID_DRIVER_SCALING_HPP
+#define BSOID_INCLUDE_BSOID_DRIVER_SCALING_HPP
+
+#pragma once
+
+#include "bsoid/driver/Driver.hpp"
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bsoid
+{
+    namespace driver
+    {
+        // One point of a scaling curve: the total runtime, a phase or a
+        // section of one configuration at one thread count. Every value is
+        // relative to the smallest thread count of the curve.
+        struct ScalingRecord
+        {
+            ScalingRecord();
+
+            std::string model;
+            std::string algorithm;
+            std::size_t resolution;
+            std::size_t svResolution;
+            int threads;
+            std::string component;
+
+            // Median time of the component. The speedup is T0 / Tp for
+            // strong scaling and the scaled speedup p / p0 * T0 / Tp for
+            // weak scaling, and the efficiency is the speedup divided by
+            // p / p0.
+            double seconds;
+            double speedup;
+            double efficiency;
+
+            // Serial fraction estimated from this point alone (Karp-Flatt
+            // for strong scaling, Gustafson for weak scaling) and fitted to
+            // the whole curve.
+            double serialFraction;
+            double fittedSerialFraction;
+        };
+
+        // The thread counts of a study: the given ones in increasing order,
+        // or powers of two up to the number of hardware threads if only
+        // the default was given.
+        std::vector<int> getScalingThreads(std::vector<int> const& threads);
+
+        // Grows the resolution with the thread count so that each thread
+        // keeps the same amount of work. Bsoid only visits the surface, so
+        // its work grows with the square of the resolution, whereas
+        // marching cubes visits the whole grid.
+        std::size_t getWeakResolution(std::size_t resolution,
+            std::string const& algorithm, double scale);
+
+        // Runs a strong or weak scaling study over the models, algorithms
+        // and resolutions of the options.
+        bool runScaling(Options const& options,
+            std::vector<ScalingRecord>& records);
+
+        void writeScalingCsv(std::vector<ScalingRecord> const& records,
+            std::ostream& out);
+        void writeScalingJson(std::vector<ScalingRecord> const& records,
+            std::string const& mode, std::ostream& out);
+    }
+}
+
+#endif
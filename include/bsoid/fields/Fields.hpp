@@ -5,6 +5,7 @@
 
 #include "bsoid/Bsoid.hpp"
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 
@@ -14,6 +15,18 @@ namespace bsoid
     {
         using FilterFn = std::function<float(float)>;
 
+        // Identifies the concrete type of a field. The values are stored in
+        // tree snapshots, so existing entries must never be renumbered.
+        enum class FieldType : std::uint32_t
+        {
+            Sphere = 0,
+            Torus = 1,
+            Blend = 2,
+            Union = 3,
+            Intersection = 4,
+            Transform = 5
+        };
+
         class ImplicitField;
         class Sphere;
         class Torus;
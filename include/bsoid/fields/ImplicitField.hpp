@@ -44,6 +44,7 @@ namespace bsoid
             }
 
             virtual std::vector<atlas::math::Point> getSeeds() const = 0;
+            virtual FieldType getType() const = 0;
 
             std::uint64_t getCount() const
             {
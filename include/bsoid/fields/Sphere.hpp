@@ -31,6 +31,21 @@ namespace bsoid
                 return { seed };
             }
 
+            FieldType getType() const override
+            {
+                return FieldType::Sphere;
+            }
+
+            float getRadius() const
+            {
+                return mRadius;
+            }
+
+            atlas::math::Point getCentre() const
+            {
+                return mCentre;
+            }
+
         private:
             float sdf(atlas::math::Point const& p) const override
             {
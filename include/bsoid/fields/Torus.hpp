@@ -36,6 +36,26 @@ namespace bsoid
                 return { pt };
             }
 
+            FieldType getType() const override
+            {
+                return FieldType::Torus;
+            }
+
+            float getInnerRadius() const
+            {
+                return mC;
+            }
+
+            float getOuterRadius() const
+            {
+                return mA;
+            }
+
+            atlas::math::Point getCentre() const
+            {
+                return mCentre;
+            }
+
         private:
             float sdf(atlas::math::Point const& p) const override
             {
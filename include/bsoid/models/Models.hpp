@@ -7,9 +7,12 @@
 #include "bsoid/polygonizer/MarchingCubes.hpp"
 
 #include <functional>
+#include <string>
 #include <tuple>
+#include <vector>
 
 #define MAKE_FUNCTION(name) \
+bsoid::tree::BlobTree make##name##Tree(); \
 bsoid::polygonizer::Bsoid make##name(Resolution const& res); \
 bsoid::polygonizer::MarchingCubes makeMC##name(Resolution const& res)
 
@@ -45,6 +48,12 @@ namespace bsoid
 
         MAKE_FUNCTION(Chain);
 
+        // Names accepted by makeModelTree, in the order declared above.
+        std::vector<std::string> getModelNames();
+
+        // Builds the tree of the named model. Any other name is treated as
+        // the path of a BlobTree snapshot.
+        bool makeModelTree(std::string const& name, tree::BlobTree& tree);
     }
 }
 
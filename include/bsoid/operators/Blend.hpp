@@ -30,6 +30,11 @@ namespace bsoid
                 return result;
             }
 
+            fields::FieldType getType() const override
+            {
+                return fields::FieldType::Blend;
+            }
+
         private:
             float sdf(atlas::math::Point const& p) const override
             {
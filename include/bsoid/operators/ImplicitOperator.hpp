@@ -42,6 +42,11 @@ namespace bsoid
                 }
             }
 
+            std::vector<fields::ImplicitFieldPtr> const& getFields() const
+            {
+                return mFields;
+            }
+
             float eval(atlas::math::Point const& p) const override
             {
                 return sdf(p);
@@ -32,6 +32,11 @@ namespace bsoid
                 return result;
             }
 
+            fields::FieldType getType() const override
+            {
+                return fields::FieldType::Intersection;
+            }
+
         private:
             float sdf(atlas::math::Point const& p) const override
             {
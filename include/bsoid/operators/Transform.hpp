@@ -39,6 +39,16 @@ namespace bsoid
                 return result;
             }
 
+            fields::FieldType getType() const override
+            {
+                return fields::FieldType::Transform;
+            }
+
+            atlas::math::Matrix4 getTransform() const
+            {
+                return mTransform;
+            }
+
         private:
             float sdf(atlas::math::Point const& p) const override
             {
@@ -31,6 +31,11 @@ namespace bsoid
                 return result;
             }
 
+            fields::FieldType getType() const override
+            {
+                return fields::FieldType::Union;
+            }
+
         private:
             float sdf(atlas::math::Point const& p) const override
             {
@@ -4,6 +4,10 @@
 #pragma once
 
 #include "Polygonizer.hpp"
+#include "Stats.hpp"
+#include "Utilization.hpp"
+#include "Progress.hpp"
+#include "MeshSink.hpp"
 #include "Lattice.hpp"
 #include "SuperVoxel.hpp"
 #include "uint128_t.hpp"
@@ -11,11 +15,16 @@
 
 #include <atlas/utils/Mesh.hpp>
 
+#include <tbb/enumerable_thread_specific.h>
+
+#include <memory>
 #include <sstream>
 #include <string>
 #include <cinttypes>
 #include <unordered_map>
+#include <map>
 #include <mutex>
+#include <vector>
 
 namespace bsoid
 {
@@ -39,22 +48,45 @@ namespace bsoid
 
             void constructLattice();
             void constructMesh();
+            void constructMesh(MeshSink& sink);
             void polygonize();
+            void polygonize(MeshSink& sink);
+            void optimizeMesh();
 
             Lattice const& getLattice() const;
             atlas::utils::Mesh& getMesh();
 
+            // Where every chunk of the mesh is, when the mesh was made by
+            // polygonize() or through a MemoryMeshSink that records them.
+            // optimizeMesh keeps the chunks contiguous.
+            std::vector<MeshChunkRange>& getChunks();
+
             void setName(std::string const& name);
             std::string getName() const;
 
             std::string getLog() const;
             void clearLog();
 
-            void saveMesh();
+            PolygonizerStats const& getStats() const;
+
+            // Reports how far polygonize and optimizeMesh have come, so they
+            // can run on another thread. The progress is not owned and may
+            // be null.
+            void setProgress(Progress* progress);
+
+            // Per-supervoxel work of the last polygonization, and the same
+            // written as CSV so it can be plotted as a heatmap.
+            std::vector<SuperVoxelStats> getSuperVoxelStats() const;
+            bool saveSuperVoxelHeatmap(std::string const& filename) const;
+
+            void saveMesh(atlas::utils::MeshFormat format =
+                atlas::utils::MeshFormat::OBJ);
 
             std::size_t size() const;
 
         private:
+            friend struct BenchmarkAccess;
+
             struct LinePoint
             {
                 LinePoint()
@@ -74,13 +106,14 @@ namespace bsoid
             };
 
             void makeVoxels();
-            void makeTriangles();
+            std::size_t makeTriangles(MeshSink& sink);
 
             atlas::math::Point createCellPoint(glm::u64vec3 const& p,
                 atlas::math::Point const& delta);
             atlas::math::Point createCellPoint(std::uint64_t x,
                 std::uint64_t y, std::uint64_t z, atlas::math::Point const& delta);
 
+            std::uint64_t getSuperVoxelHash(atlas::math::Point const& pt);
             FieldPoint findVoxelPoint(PointId const& id);
             void fillVoxel(Voxel& v);
             bool seenVoxel(VoxelId const& id);
@@ -93,30 +126,73 @@ namespace bsoid
             bool validVoxel(Voxel const& v);
 
             void validateVoxels();
+            void beginPhase();
+            void endPhase(std::string const& name, double seconds);
+
+            // Kept per thread so that counting never contends. Redundant
+            // points and edges were computed by two threads at once and the
+            // second result was discarded.
+            struct Counters
+            {
+                Counters() :
+                    pointHits(0), pointMisses(0), redundantPoints(0),
+                    edgeHits(0), edgeMisses(0), redundantEdges(0),
+                    voxelsVisited(0), voxelsRevisited(0), voxelsAccepted(0)
+                { }
+
+                std::uint64_t pointHits, pointMisses, redundantPoints;
+                std::uint64_t edgeHits, edgeMisses, redundantEdges;
+                std::uint64_t voxelsVisited, voxelsRevisited, voxelsAccepted;
+
+                // Indexed by SuperVoxel::index and sized on first use, so
+                // counting an evaluation is a plain increment.
+                std::vector<std::uint64_t> svEvaluations;
+            };
+
+            void countEvaluation(Counters& counters, SuperVoxel const& sv);
+            void recordCounters();
+
+            // Every container the polygonizer fills allocates through
+            // mMemory, so size() and the phase statistics are exact.
+            template <typename T>
+            using Vector = std::vector<T, atlas::core::CountingAllocator<T>>;
+            template <typename Key, typename Value>
+            using Map = std::map<Key, Value, std::less<Key>,
+                atlas::core::CountingAllocator<std::pair<Key const, Value>>>;
+            template <typename Key, typename Value>
+            using HashMap = std::unordered_map<Key, Value, std::hash<Key>,
+                std::equal_to<Key>,
+                atlas::core::CountingAllocator<std::pair<Key const, Value>>>;
 
+            atlas::core::MemoryCounter mMemory;
 
             atlas::math::Point mGridDelta, mSvDelta, mMin, mMax;
             std::uint64_t mGridSize, mSvSize;
             float mMagic;
 
-            std::vector<Voxel> mVoxels;
+            VoxelList mVoxels;
             std::mutex mSeenVoxelsMutex;
-            std::map<std::uint64_t, VoxelId> mSeenVoxels;
+            Map<std::uint64_t, VoxelId> mSeenVoxels;
 
             std::mutex mSeenPointsMutex;
-            std::map<std::uint64_t, FieldPoint> mSeenPoints;
+            Map<std::uint64_t, FieldPoint> mSeenPoints;
 
             std::mutex mSvMutex;
-            std::unordered_map<std::uint64_t, SuperVoxel> mSuperVoxels;
+            HashMap<std::uint64_t, SuperVoxel> mSuperVoxels;
 
             std::mutex mPointMutex;
-            std::map<std::uint128_t, LinePoint> mComputedPoints;
+            Map<std::uint128_t, LinePoint> mComputedPoints;
 
             Lattice mLattice;
             tree::TreePointer mTree;
 
             atlas::utils::Mesh mMesh;
+            std::vector<MeshChunkRange> mChunks;
 
+            PolygonizerStats mStats;
+            tbb::enumerable_thread_specific<Counters> mCounters;
+            std::unique_ptr<UtilizationObserver> mObserver;
+            Progress* mProgress;
             std::stringstream mLog;
             std::string mName;
         };
@@ -18,7 +18,7 @@ namespace bsoid
         struct BsoidHash
         {
             static constexpr T bits = std::numeric_limits<T>::digits / 3;
-            static constexpr T mask = ~(static_cast<T>(0) << bits);
+            static constexpr T mask = ~(~static_cast<T>(0) << bits);
             static constexpr T hash(T x, T y, T z)
             {
                 return (((x & mask) << bits | (y & mask)) << bits | (z & mask));
@@ -16,7 +16,8 @@ namespace bsoid
         {
             Lattice() = default;
 
-            void makeLattice(std::vector<Voxel> const& voxels);
+            void makeLattice(VoxelList const& voxels,
+                bool uniqueEdges = true);
             void clearBuffers();
 
             std::vector<atlas::math::Point> vertices;
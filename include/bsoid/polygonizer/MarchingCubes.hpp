@@ -4,15 +4,22 @@
 #pragma once
 
 #include "Polygonizer.hpp"
+#include "Stats.hpp"
+#include "Utilization.hpp"
+#include "Progress.hpp"
+#include "MeshSink.hpp"
 #include "bsoid/tree/BlobTree.hpp"
 
+#include <atlas/core/Memory.hpp>
 #include <atlas/utils/Mesh.hpp>
 
+#include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
+#include <scoped_allocator>
 #include <cinttypes>
-#include <mutex>
 
 namespace bsoid
 {
@@ -21,6 +28,12 @@ namespace bsoid
         class MarchingCubes
         {
         public:
+            // The mesh is made in chunks of ChunkSize voxels along each axis.
+            // The id of a chunk packs the coordinates of its block, which
+            // getChunkBlock recovers.
+            static constexpr std::uint32_t ChunkSize = 16;
+            static glm::u32vec3 getChunkBlock(std::uint64_t id);
+
             MarchingCubes();
             MarchingCubes(tree::BlobTree const& model, std::string const& name,
                 float isoValue = 0.5f);
@@ -32,20 +45,41 @@ namespace bsoid
             void setIsoValue(float isoValue);
             void setResolution(std::uint32_t res);
 
+            tree::BlobTree* tree() const;
+            float getIsoValue() const;
+            glm::u32vec3 getResolution() const;
+
             void polygonize();
+            void polygonize(MeshSink& sink);
+            void optimizeMesh();
 
             atlas::utils::Mesh& getMesh();
 
+            // Where every chunk of the mesh is, when the mesh was made by
+            // polygonize() or through a MemoryMeshSink that records them.
+            // optimizeMesh keeps the chunks contiguous.
+            std::vector<MeshChunkRange>& getChunks();
+
             void setName(std::string const& name);
             std::string getName() const;
 
             std::string getLog() const;
             void clearLog();
 
-            void saveMesh();
+            PolygonizerStats const& getStats() const;
+
+            // Reports how far polygonize and optimizeMesh have come, so they
+            // can run on another thread. The progress is not owned and may
+            // be null.
+            void setProgress(Progress* progress);
+
+            void saveMesh(atlas::utils::MeshFormat format =
+                atlas::utils::MeshFormat::OBJ);
             std::size_t size() const;
 
         private:
+            friend struct BenchmarkAccess;
+
             struct VoxelPoint
             {
                 VoxelPoint() = default;
@@ -54,18 +88,41 @@ namespace bsoid
             };
 
             void constructGrid();
-            void createTriangles();
-
+            std::size_t createTriangles(MeshSink& sink);
+            void beginPhase();
+            void endPhase(std::string const& name, double seconds);
+
+            // The scoped adaptor hands the counting allocator down to the
+            // rows and columns of the grid.
+            template <typename T>
+            using GridAllocator = std::scoped_allocator_adaptor<
+                atlas::core::CountingAllocator<T>>;
+            using GridColumn = std::vector<VoxelPoint,
+                GridAllocator<VoxelPoint>>;
+            using GridSlice = std::vector<GridColumn,
+                GridAllocator<GridColumn>>;
+            using Grid = std::vector<GridSlice, GridAllocator<GridSlice>>;
+
+            // The buffers and maps of the triangle phase count into mMemory
+            // as well.
+            template <typename T>
+            using Vector = std::vector<T, atlas::core::CountingAllocator<T>>;
+            template <typename Key, typename Value>
+            using HashMap = std::unordered_map<Key, Value, std::hash<Key>,
+                std::equal_to<Key>,
+                atlas::core::CountingAllocator<std::pair<Key const, Value>>>;
+
+            atlas::core::MemoryCounter mMemory;
             glm::u32vec3 mResolution;
             atlas::utils::Mesh mMesh;
-            std::vector<std::vector<std::vector<VoxelPoint>>> mGrid;
-            std::vector<atlas::math::Point> mVertices;
-            std::vector<atlas::math::Normal> mNormals;
-            std::vector<std::uint32_t> mIndices;
-            std::mutex mDataMutex;
+            std::vector<MeshChunkRange> mChunks;
+            Grid mGrid;
             tree::TreePointer mTree;
             float mMagic;
 
+            PolygonizerStats mStats;
+            std::unique_ptr<UtilizationObserver> mObserver;
+            Progress* mProgress;
             std::stringstream mLog;
             std::string mName;
 
@@ -0,0 +1,284 @@
+#ifndef BSOID_INCLUDE_BSOID_POLYGONIZER_MESH_SINK_HPP
+#define BSOID_INCLUDE_BSOID_POLYGONIZER_MESH_SINK_HPP
+
+#pragma once
+
+#include "Polygonizer.hpp"
+
+#include <atlas/math/Math.hpp>
+#include <atlas/utils/BBox.hpp>
+#include <atlas/utils/BlockWriter.hpp>
+#include <atlas/utils/Mesh.hpp>
+#include <atlas/utils/MeshSimplifier.hpp>
+
+#include <atomic>
+#include <cinttypes>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bsoid
+{
+    namespace polygonizer
+    {
+        // A piece of the mesh produced by a polygonizer. The vertices are the
+        // ones that first appear in this chunk and are numbered globally
+        // starting at vertexOffset. Indices are global too, so a chunk may
+        // reference vertices that were emitted by earlier chunks.
+        struct MeshChunk
+        {
+            MeshChunk() :
+                id(0),
+                vertexOffset(0)
+            { }
+
+            std::uint64_t id;
+            std::uint32_t vertexOffset;
+            atlas::utils::BBox bounds;
+
+            std::vector<atlas::math::Point> vertices;
+            std::vector<atlas::math::Normal> normals;
+            std::vector<std::uint32_t> indices;
+        };
+
+        // Where the triangles of a chunk ended up in a mesh, so the chunk
+        // can be drawn or culled on its own.
+        struct MeshChunkRange
+        {
+            MeshChunkRange() :
+                id(0),
+                firstIndex(0),
+                numIndices(0)
+            { }
+
+            std::uint64_t id;
+            std::uint32_t firstIndex;
+            std::uint32_t numIndices;
+            atlas::utils::BBox bounds;
+        };
+
+        // Start offsets of the chunks in the index list, as taken by
+        // atlas::utils::optimizeVertexCache. Empty if the chunks do not cover
+        // the list in order, for instance when the mesh did not come from
+        // the sink that recorded them.
+        std::vector<std::size_t> getChunkOffsets(
+            std::vector<MeshChunkRange> const& chunks, std::size_t numIndices);
+
+        // How normals are stored in interleaved vertices. Every vertex starts
+        // with its position as three floats. Float normals follow as three
+        // more floats, while packed normals are normalized and stored as one
+        // signed 2_10_10_10 integer, to be read as GL_INT_2_10_10_10_REV.
+        enum class NormalFormat : int
+        {
+            Float = 0,
+            Packed
+        };
+
+        // Bytes per interleaved vertex.
+        std::size_t getVertexStride(NormalFormat format);
+
+        // Writes count vertices to out, which must hold count times the
+        // stride. Positions and normals must have count elements each.
+        void writeInterleaved(atlas::math::Point const* positions,
+            atlas::math::Normal const* normals, std::size_t count,
+            NormalFormat format, void* out);
+
+        // Receives the mesh from a polygonizer as it is being generated.
+        // begin and end bracket a single polygonization, and write is always
+        // called from one thread at a time with chunks in increasing order of
+        // vertexOffset.
+        class MeshSink
+        {
+        public:
+            virtual ~MeshSink() = default;
+
+            virtual void begin()
+            { }
+
+            virtual void write(MeshChunk const& chunk) = 0;
+
+            virtual void end()
+            { }
+        };
+
+        class MemoryMeshSink : public MeshSink
+        {
+        public:
+            MemoryMeshSink(atlas::utils::Mesh& mesh);
+
+            // Also records the range of every chunk.
+            MemoryMeshSink(atlas::utils::Mesh& mesh,
+                std::vector<MeshChunkRange>& chunks);
+
+            void begin() override;
+            void write(MeshChunk const& chunk) override;
+
+        private:
+            atlas::utils::Mesh& mMesh;
+            std::vector<MeshChunkRange>* mChunks;
+        };
+
+        // Streams the mesh to a binary PLY file. Vertices go straight to the
+        // file while faces are staged in a temporary file next to it, which
+        // is appended once the polygonizer is done.
+        class FileMeshSink : public MeshSink
+        {
+        public:
+            FileMeshSink(std::string const& filename);
+            ~FileMeshSink();
+
+            void begin() override;
+            void write(MeshChunk const& chunk) override;
+            void end() override;
+
+            bool good() const;
+
+        private:
+            std::string mFilename;
+            std::string mFacesFilename;
+            std::unique_ptr<atlas::utils::BlockWriter> mFile;
+            std::unique_ptr<atlas::utils::BlockWriter> mFaces;
+            std::size_t mVertexCountOffset, mFaceCountOffset;
+            std::uint64_t mNumVertices, mNumFaces;
+            bool mGood;
+        };
+
+        class CallbackMeshSink : public MeshSink
+        {
+        public:
+            using Callback = std::function<void(MeshChunk const&)>;
+
+            CallbackMeshSink(Callback const& callback);
+
+            void write(MeshChunk const& chunk) override;
+
+        private:
+            Callback mCallback;
+        };
+
+        // Decimates every chunk before passing it on, so the full resolution
+        // mesh never has to be stored. Vertices on the border of a chunk are
+        // left alone, which keeps neighbouring chunks stitched together. The
+        // ratio is the fraction of triangles to keep and maxError a distance
+        // in model units, as in atlas::utils::simplifyTriangles. The result
+        // of all chunks together is logged at the end.
+        class SimplifyMeshSink : public MeshSink
+        {
+        public:
+            SimplifyMeshSink(MeshSink& sink, float ratio,
+                float maxError = std::numeric_limits<float>::max());
+
+            void begin() override;
+            void write(MeshChunk const& chunk) override;
+            void end() override;
+
+        private:
+            struct BorderVertex
+            {
+                std::uint32_t index;
+                atlas::math::Point position;
+                atlas::math::Normal normal;
+            };
+
+            MeshSink& mSink;
+            float mRatio, mMaxError;
+            std::uint32_t mNumVertices;
+            std::unordered_map<std::uint32_t, BorderVertex> mBorder;
+            atlas::utils::SimplifyStats mStats;
+        };
+
+        // Passes the chunks on to another sink and also hands a copy of each
+        // to a second thread. The chunks go through a lock-free queue with
+        // one producer (the polygonizer) and one consumer, so a viewer can
+        // show the mesh while it is being generated.
+        class QueueMeshSink : public MeshSink
+        {
+        public:
+            QueueMeshSink(MeshSink& sink);
+            ~QueueMeshSink();
+
+            QueueMeshSink(QueueMeshSink const&) = delete;
+            QueueMeshSink& operator=(QueueMeshSink const&) = delete;
+
+            void begin() override;
+            void write(MeshChunk const& chunk) override;
+            void end() override;
+
+            // Takes the oldest chunk that has not been taken yet. Returns
+            // false if there is none, which does not mean that no more will
+            // come. Only one thread may call this.
+            bool pop(MeshChunk& chunk);
+
+        private:
+            struct Node
+            {
+                Node() :
+                    next(nullptr)
+                { }
+
+                MeshChunk chunk;
+                std::atomic<Node*> next;
+            };
+
+            MeshSink& mSink;
+
+            // The consumer owns the head, which is always a node that has
+            // already been taken, and the producer owns the tail. Keep them
+            // on separate cache lines.
+            Node* mHead;
+            char mPadding[64];
+            Node* mTail;
+        };
+
+        // Writes the mesh straight into buffers owned by the caller, such as
+        // mapped GPU memory, with interleaved vertices. The buffers are sized
+        // beforehand. Whatever does not fit is dropped, but is still counted,
+        // so the caller can retry with the sizes that were needed.
+        class InterleavedMeshSink : public MeshSink
+        {
+        public:
+            InterleavedMeshSink(void* vertices, std::size_t maxVertices,
+                std::uint32_t* indices, std::size_t maxIndices,
+                NormalFormat format = NormalFormat::Float);
+
+            void begin() override;
+            void write(MeshChunk const& chunk) override;
+
+            // Vertices and indices the mesh has, which may be more than
+            // were written.
+            std::size_t numVertices() const;
+            std::size_t numIndices() const;
+            bool overflowed() const;
+
+        private:
+            unsigned char* mVertices;
+            std::size_t mMaxVertices;
+            std::uint32_t* mIndices;
+            std::size_t mMaxIndices;
+            NormalFormat mFormat;
+            std::size_t mNumVertices, mNumIndices;
+        };
+
+        // Discards the mesh and only keeps track of its size.
+        class NullMeshSink : public MeshSink
+        {
+        public:
+            NullMeshSink();
+
+            void begin() override;
+            void write(MeshChunk const& chunk) override;
+
+            std::uint64_t numVertices() const;
+            std::uint64_t numTriangles() const;
+            std::uint64_t numChunks() const;
+
+        private:
+            std::uint64_t mNumVertices, mNumTriangles, mNumChunks;
+        };
+    }
+}
+
+#endif
@@ -13,6 +13,12 @@ namespace bsoid
         class MarchingCubes;
         struct Lattice;
         struct Voxel;
+        struct MeshChunk;
+        class MeshSink;
+
+        // Defined by the benchmarks to reach the individual stages of the
+        // polygonizers.
+        struct BenchmarkAccess;
     }
 }
 
@@ -0,0 +1,72 @@
+#ifndef BSOID_INCLUDE_BSOID_POLYGONIZER_PROGRESS_HPP
+#define BSOID_INCLUDE_BSOID_POLYGONIZER_PROGRESS_HPP
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace bsoid
+{
+    namespace polygonizer
+    {
+        // How far a polygonization running on another thread has come. The
+        // polygonizer moves through named steps and counts the work done in
+        // each, while any other thread may read the values at any time.
+        class Progress
+        {
+        public:
+            Progress() :
+                mStep(""),
+                mDone(0),
+                mTotal(0)
+            { }
+
+            // Starts a new step. A total of 0 means the amount of work is not
+            // known in advance, as for the surface tracking of Bsoid.
+            void beginStep(const char* name, std::uint64_t total)
+            {
+                mDone.store(0, std::memory_order_relaxed);
+                mTotal.store(total, std::memory_order_relaxed);
+                mStep.store(name, std::memory_order_release);
+            }
+
+            void advance(std::uint64_t amount = 1)
+            {
+                mDone.fetch_add(amount, std::memory_order_relaxed);
+            }
+
+            // The name is stored as a pointer, so steps are named with string
+            // literals.
+            const char* step() const
+            {
+                return mStep.load(std::memory_order_acquire);
+            }
+
+            std::uint64_t done() const
+            {
+                return mDone.load(std::memory_order_relaxed);
+            }
+
+            std::uint64_t total() const
+            {
+                return mTotal.load(std::memory_order_relaxed);
+            }
+
+            // Fraction of the current step, or 0 if its total is unknown.
+            float fraction() const
+            {
+                auto total = this->total();
+                return (total == 0) ? 0.0f : static_cast<float>(
+                    static_cast<double>(done()) / total);
+            }
+
+        private:
+            std::atomic<const char*> mStep;
+            std::atomic<std::uint64_t> mDone;
+            std::atomic<std::uint64_t> mTotal;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef BSOID_INCLUDE_BSOID_POLYGONIZER_STATS_HPP
+#define BSOID_INCLUDE_BSOID_POLYGONIZER_STATS_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bsoid
+{
+    namespace polygonizer
+    {
+        // What one thread of the arena did during a phase. Active is the time
+        // it spent in the arena, busy the part of it spent running tasks and
+        // idle the part spent stealing, waiting and scheduling. The calling
+        // thread is only in the arena inside a parallel algorithm, the rest
+        // of its time is serial.
+        struct WorkerStats
+        {
+            WorkerStats() :
+                master(false),
+                active(0.0),
+                busy(0.0),
+                idle(0.0),
+                serial(0.0),
+                tasks(0),
+                entries(0),
+                exits(0)
+            { }
+
+            bool master;
+            double active;
+            double busy;
+            double idle;
+            double serial;
+            std::uint64_t tasks;
+
+            // Times the thread joined and left the arena.
+            std::uint64_t entries;
+            std::uint64_t exits;
+        };
+
+        // Time and memory used by one phase of a polygonization.
+        struct PhaseStats
+        {
+            PhaseStats() :
+                seconds(0.0),
+                bytes(0),
+                peakBytes(0),
+                allocations(0),
+                rss(0),
+                peakRSS(0)
+            { }
+
+            std::string name;
+            double seconds;
+
+            // Bytes held by the polygonizer's containers at the end of the
+            // phase and at most during it, and the allocations it made.
+            std::size_t bytes;
+            std::size_t peakBytes;
+            std::uint64_t allocations;
+
+            // Resident set size of the whole process at the end of the phase
+            // and at most during it.
+            std::size_t rss;
+            std::size_t peakRSS;
+
+            // Threads that took part in the phase, only filled in when
+            // utilization is enabled. The calling thread comes first.
+            std::vector<WorkerStats> workers;
+        };
+
+        // Timings and counts of the last polygonization.
+        struct PolygonizerStats
+        {
+            PolygonizerStats() :
+                evaluations(0),
+                vertices(0)
+            { }
+
+            // The phases in the order they ran.
+            std::vector<PhaseStats> phases;
+
+            // Wall-clock time of steps inside the phases, such as the serial
+            // surface tracking of Bsoid.
+            std::vector<std::pair<std::string, double>> sections;
+
+            std::uint64_t evaluations;
+            std::uint64_t vertices;
+
+            // Polygonizer-specific counters, such as cache hits.
+            std::vector<std::pair<std::string, std::uint64_t>> counters;
+        };
+
+        // Work done inside one supervoxel of Bsoid.
+        struct SuperVoxelStats
+        {
+            SuperVoxelStats() :
+                x(0), y(0), z(0),
+                evaluations(0),
+                fields(0),
+                voxels(0)
+            { }
+
+            std::uint64_t x, y, z;
+
+            // Evaluations of the subtree, the number of fields in it, and
+            // the number of surface voxels assigned to the supervoxel.
+            std::uint64_t evaluations;
+            std::uint64_t fields;
+            std::uint64_t voxels;
+        };
+    }
+}
+
+#endif
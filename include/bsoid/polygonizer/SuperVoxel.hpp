@@ -15,7 +15,9 @@ namespace bsoid
     {
         struct SuperVoxel
         {
-            SuperVoxel()
+            SuperVoxel() :
+                fieldCount(0),
+                index(0)
             { }
 
             float eval(atlas::math::Point const& p) const
@@ -31,6 +33,11 @@ namespace bsoid
             glm::u64vec3 id;
             fields::ImplicitFieldPtr field;
             atlas::utils::BBox cell;
+            std::size_t fieldCount;
+
+            // Position of the supervoxel among those that hold a field,
+            // assigned once the grid has been built.
+            std::size_t index;
         };
     }
 }
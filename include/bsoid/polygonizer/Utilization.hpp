@@ -0,0 +1,178 @@
+#ifndef BSOID_INCLUDE_BSOID_POLYGONIZER_UTILIZATION_HPP
+#define BSOID_INCLUDE_BSOID_POLYGONIZER_UTILIZATION_HPP
+
+#pragma once
+
+#include "Stats.hpp"
+
+// Also set for the whole build, this only helps translation units that
+// include TBB here first.
+#ifndef TBB_PREVIEW_LOCAL_OBSERVER
+#define TBB_PREVIEW_LOCAL_OBSERVER 1
+#endif
+
+#include <tbb/task_arena.h>
+#include <tbb/task_scheduler_observer.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+
+namespace bsoid
+{
+    namespace polygonizer
+    {
+        // Time spent by every thread inside the bodies of parallel tasks.
+        // The observer below only learns when threads join and leave the
+        // arena, so the task bodies mark themselves with UTILIZATION_TASK.
+        // Nothing is recorded unless utilization is enabled, in which case
+        // every task pays for two clock reads.
+        namespace utilization
+        {
+            void setEnabled(bool enabled);
+            bool isEnabled();
+
+            // Only the outermost of nested tasks on a thread is timed, so a
+            // task that waits on others is not counted twice.
+            void beginTask();
+            void endTask();
+
+            // Brackets a parallel algorithm called outside of any task, the
+            // only time the calling thread works in or waits on the arena.
+            void beginParallel();
+            void endParallel();
+        }
+
+        class UtilizationTask
+        {
+        public:
+            UtilizationTask() :
+                mActive(utilization::isEnabled())
+            {
+                if (mActive)
+                {
+                    utilization::beginTask();
+                }
+            }
+
+            ~UtilizationTask()
+            {
+                if (mActive)
+                {
+                    utilization::endTask();
+                }
+            }
+
+            UtilizationTask(UtilizationTask const&) = delete;
+            UtilizationTask& operator=(UtilizationTask const&) = delete;
+
+        private:
+            bool mActive;
+        };
+
+        class UtilizationParallel
+        {
+        public:
+            UtilizationParallel() :
+                mActive(utilization::isEnabled())
+            {
+                if (mActive)
+                {
+                    utilization::beginParallel();
+                }
+            }
+
+            ~UtilizationParallel()
+            {
+                if (mActive)
+                {
+                    utilization::endParallel();
+                }
+            }
+
+            UtilizationParallel(UtilizationParallel const&) = delete;
+            UtilizationParallel& operator=(UtilizationParallel const&) =
+                delete;
+
+        private:
+            bool mActive;
+        };
+
+        // Owns the arena the observer watches. It is a base listed before
+        // the observer, so the arena exists by the time the observer is
+        // given it.
+        struct ObservedArena
+        {
+            ObservedArena() :
+                mArena(tbb::task_arena::attach())
+            { }
+
+            tbb::task_arena mArena;
+        };
+
+        // Watches the arena of the calling thread for the duration of a
+        // phase. Threads that were already in the arena when the phase began
+        // are not announced again, so they count as active from the start.
+        class UtilizationObserver : private ObservedArena,
+            public tbb::task_scheduler_observer
+        {
+        public:
+            UtilizationObserver();
+            ~UtilizationObserver();
+
+            void beginPhase();
+            void endPhase(PhaseStats& phase);
+
+            void on_scheduler_entry(bool isWorker) override;
+            void on_scheduler_exit(bool isWorker) override;
+
+        private:
+            struct ThreadState
+            {
+                ThreadState() :
+                    master(false),
+                    inside(false),
+                    seen(false),
+                    entered(0),
+                    active(0),
+                    entries(0),
+                    exits(0),
+                    busy(0),
+                    tasks(0),
+                    parallel(0)
+                { }
+
+                bool master, inside, seen;
+                std::uint64_t entered, active;
+                std::uint64_t entries, exits;
+
+                // Task counters of the thread when the phase began.
+                std::uint64_t busy, tasks, parallel;
+            };
+
+            std::mutex mMutex;
+            std::uint64_t mBegin;
+            std::map<std::uint32_t, ThreadState> mThreads;
+        };
+
+        // Writes the totals of the phase and a line per thread.
+        void writeUtilization(PhaseStats const& phase, std::ostream& out);
+    }
+}
+
+#define BSOID_UTILIZATION_CONCAT_IMPL(a, b) a##b
+#define BSOID_UTILIZATION_CONCAT(a, b) BSOID_UTILIZATION_CONCAT_IMPL(a, b)
+
+// Counts the rest of the enclosing scope as one task of the calling thread.
+#define UTILIZATION_TASK() \
+    bsoid::polygonizer::UtilizationTask \
+    BSOID_UTILIZATION_CONCAT(utilizationTask, __LINE__)
+
+// Counts the rest of the enclosing scope as time the calling thread spends in
+// the arena running or waiting on a parallel algorithm.
+#define UTILIZATION_PARALLEL() \
+    bsoid::polygonizer::UtilizationParallel \
+    BSOID_UTILIZATION_CONCAT(utilizationParallel, __LINE__)
+
+#endif
@@ -4,9 +4,11 @@
 #pragma once
 
 #include <atlas/math/Math.hpp>
+#include <atlas/core/Memory.hpp>
 
 #include <cinttypes>
 #include <array>
+#include <vector>
 
 #if defined(max)
 #undef max
@@ -92,6 +94,9 @@ namespace bsoid
             std::array<FieldPoint, 8> points;
             VoxelId id;
         };
+
+        using VoxelList =
+            std::vector<Voxel, atlas::core::CountingAllocator<Voxel>>;
     }
 }
 
@@ -7,6 +7,7 @@
 #include "Node.hpp"
 #include "bsoid/fields/ImplicitField.hpp"
 
+#include <string>
 #include <vector>
 
 namespace bsoid
@@ -40,6 +41,15 @@ namespace bsoid
             std::vector<atlas::math::Point> getSeeds() const;
 
             std::string getFieldSummary() const;
+            std::uint64_t getEvaluationCount() const;
+
+            // Writes the tree as a binary snapshot (see Snapshot.hpp).
+            bool saveToFile(std::string const& filename) const;
+
+            // Rebuilds a tree from a snapshot. The records are decoded into
+            // one field and one node object each, so loading still
+            // allocates per node.
+            static bool fromFile(std::string const& filename, BlobTree& tree);
 
         private:
             std::vector<NodePtr> mNodes;
@@ -20,6 +20,7 @@ namespace bsoid
             ~Node() = default;
 
             void setField(fields::ImplicitFieldPtr const& field);
+            fields::ImplicitFieldPtr getField() const;
             atlas::utils::BBox getBBox() const;
 
             void addChild(NodePtr const& child);
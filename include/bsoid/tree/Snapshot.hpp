@@ -0,0 +1,117 @@
+#ifndef BSOID_INCLUDE_BSOID_TREE_SNAPSHOT_HPP
+#define BSOID_INCLUDE_BSOID_TREE_SNAPSHOT_HPP
+
+#pragma once
+
+#include "Tree.hpp"
+#include "bsoid/fields/Fields.hpp"
+
+#include <atlas/utils/MappedFile.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace bsoid
+{
+    namespace tree
+    {
+        // A snapshot is a header followed by flat arrays of fixed-size
+        // records, so a mapped file can be read in place. All values are
+        // little endian and every section starts on a SnapshotAlignment
+        // boundary.
+        constexpr char SnapshotMagic[4] = { 'B', 'S', 'T', 'R' };
+        constexpr std::uint32_t SnapshotVersion = 1;
+        constexpr std::uint64_t SnapshotAlignment = 16;
+        constexpr std::uint32_t SnapshotMaxParams = 16;
+
+        struct SnapshotHeader
+        {
+            char magic[4];
+            std::uint32_t version;
+            std::uint32_t numFields;
+            std::uint32_t numFieldChildren;
+            std::uint32_t numNodes;
+            std::uint32_t numNodeChildren;
+            std::uint32_t numSkeletalFields;
+            std::uint32_t fieldRoot;
+            std::uint32_t nodeRoot;
+            std::uint32_t reserved;
+            std::uint64_t fieldsOffset;
+            std::uint64_t fieldChildrenOffset;
+            std::uint64_t nodesOffset;
+            std::uint64_t nodeChildrenOffset;
+            std::uint64_t skeletalFieldsOffset;
+        };
+
+        // Fields are stored children first, so every child index is smaller
+        // than the index of the field that refers to it. Shared fields are
+        // only stored once. The parameters are laid out as:
+        //  Sphere:    radius, centre.
+        //  Torus:     inner radius, outer radius, centre.
+        //  Transform: the column-major matrix.
+        struct FieldRecord
+        {
+            fields::FieldType type;
+            std::uint32_t firstChild;
+            std::uint32_t numChildren;
+            std::uint32_t reserved;
+            float params[SnapshotMaxParams];
+        };
+
+        // Children of the nodes of the volume tree, as indices into the node
+        // records. As with fields, every child index is smaller than the
+        // index of its parent, which is also the order insertNodeTree needs
+        // to get the boxes right.
+        struct NodeRecord
+        {
+            std::uint32_t field;
+            std::uint32_t firstChild;
+            std::uint32_t numChildren;
+            std::uint32_t reserved;
+        };
+
+        static_assert(sizeof(SnapshotHeader) == 80, "Unexpected padding.");
+        static_assert(sizeof(FieldRecord) == 80, "Unexpected padding.");
+        static_assert(sizeof(NodeRecord) == 16, "Unexpected padding.");
+
+        // Read-only view of a snapshot file. The file is mapped and only
+        // the header and section bounds are checked, so the records are
+        // accessed directly from the mapping.
+        //
+        // The polygonizers do not evaluate the records in place.
+        // Supervoxels take field subtrees from Node::subTree and keep them as
+        // ImplicitFieldPtr, so BlobTree::fromFile turns every record into the
+        // same shared field and node objects that a model builds. Loading
+        // therefore costs one allocation per field and per node. Particles
+        // has 101 of each and loads in about 30us, as long as building it
+        // from code and far below the time of a polygonization. What a
+        // snapshot saves is rebuilding the model, not those allocations.
+        class Snapshot
+        {
+        public:
+            Snapshot(std::string const& filename);
+            ~Snapshot() = default;
+
+            bool isValid() const;
+
+            SnapshotHeader const& header() const;
+            FieldRecord const* fields() const;
+            std::uint32_t const* fieldChildren() const;
+            NodeRecord const* nodes() const;
+            std::uint32_t const* nodeChildren() const;
+            std::uint32_t const* skeletalFields() const;
+
+        private:
+            template <typename T>
+            T const* section(std::uint64_t offset) const
+            {
+                return reinterpret_cast<T const*>(mFile.data() + offset);
+            }
+
+            atlas::utils::MappedFile mFile;
+            bool mValid;
+        };
+    }
+}
+
+#endif
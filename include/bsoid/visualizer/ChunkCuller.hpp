@@ -0,0 +1,42 @@
+#ifndef BSOID_INCLUDE_BSOID_VISUALIZER_CHUNK_CULLER_HPP
+#define BSOID_INCLUDE_BSOID_VISUALIZER_CHUNK_CULLER_HPP
+
+#pragma once
+
+#include <atlas/math/Math.hpp>
+#include <atlas/utils/BBox.hpp>
+
+#include <cinttypes>
+#include <vector>
+
+namespace bsoid
+{
+    namespace visualizer
+    {
+        // Tests the bounding boxes of mesh chunks against a view frustum. The
+        // boxes are stored one component per array, so that each plane is
+        // tested against four boxes at once where SSE is available.
+        class ChunkCuller
+        {
+        public:
+            ChunkCuller() = default;
+
+            void clear();
+            void addChunk(atlas::utils::BBox const& bounds);
+            std::size_t size() const;
+
+            // Writes the indices of the chunks that are at least partly
+            // inside the frustum of clip, in increasing order. The matrix
+            // takes the chunks to clip space, so it includes the model
+            // transform. Boxes that straddle a plane are kept.
+            void cull(atlas::math::Matrix4 const& clip,
+                std::vector<std::uint32_t>& visible) const;
+
+        private:
+            std::vector<float> mMin[3];
+            std::vector<float> mMax[3];
+        };
+    }
+}
+
+#endif
@@ -5,12 +5,20 @@
 
 #include "bsoid/polygonizer/Bsoid.hpp"
 #include "bsoid/polygonizer/MarchingCubes.hpp"
+#include "bsoid/polygonizer/MeshSink.hpp"
+#include "bsoid/polygonizer/Progress.hpp"
+#include "bsoid/visualizer/ChunkCuller.hpp"
 
 #include <atlas/utils/Geometry.hpp>
 #include <atlas/utils/Mesh.hpp>
 #include <atlas/gl/Buffer.hpp>
 #include <atlas/gl/VertexArrayObject.hpp>
 
+#include <atomic>
+#include <future>
+#include <memory>
+#include <vector>
+
 namespace bsoid
 {
     namespace visualizer
@@ -23,7 +31,9 @@ namespace bsoid
             ModelView(polygonizer::MarchingCubes&& mc);
             ModelView(polygonizer::Bsoid&& soid);
 
-            ModelView(ModelView&& view) = default;
+            // The polygonization runs in the background and refers to the
+            // view, so it cannot be moved. Destroying the view waits for it.
+            ModelView(ModelView&& view) = delete;
             ~ModelView() = default;
 
             std::string getModelName() const;
@@ -37,14 +47,64 @@ namespace bsoid
 //            glm::vec3 mModel;
 
         private:
+            // One level of the LOD pyramid. Level 0 has the full resolution
+            // and every level above it has half the resolution of the one
+            // below.
+            struct LodLevel
+            {
+                LodLevel();
+
+                atlas::gl::VertexArrayObject vao;
+                atlas::gl::Buffer data;
+                atlas::gl::Buffer indices;
+                std::size_t numIndices;
+                std::size_t numVertices;
+
+                // The mesh is drawn per chunk, so chunks outside the view or
+                // drawn at another level can be skipped.
+                ChunkCuller culler;
+                std::vector<glm::u32vec3> blocks;
+                std::vector<GLsizei> counts;
+                std::vector<std::size_t> firsts;
+                std::vector<std::uint32_t> visible;
+                std::size_t numDrawn;
+            };
+
             void initShaders();
+
+            // Polygonizes every level on a worker thread, coarsest first.
+            // The chunks of the coarsest level are uploaded by
+            // pollPolygonization as they come in, and each level is uploaded
+            // once it is optimized. Returns true if there is anything to
+            // draw.
+            void startPolygonization();
+            bool pollPolygonization();
+            void streamChunks();
+            void setVertexLayout(LodLevel& level);
+            polygonizer::MarchingCubes& getPolygonizer(std::size_t level);
+
             void constructLattices();
             void constructMesh();
-            void constructMCMesh();
+            void constructMCMesh(std::size_t level);
+
+            void addChunk(LodLevel& level, std::uint64_t id,
+                atlas::utils::BBox const& bounds, std::size_t firstIndex,
+                std::size_t numIndices);
+
+            // True if the voxels of the block at the given level are no
+            // larger than mLodPixels on screen.
+            bool isCoarseEnough(std::size_t level, glm::u32vec3 const& block,
+                atlas::math::Point const& eye, float pixelScale) const;
+            void drawLevels(atlas::math::Matrix4 const& projection,
+                atlas::math::Matrix4 const& view);
 
             polygonizer::Bsoid mSoid;
             polygonizer::MarchingCubes mMC;
 
+            // The polygonizers of levels 1 and up, mMC makes level 0.
+            std::vector<std::unique_ptr<polygonizer::MarchingCubes>>
+                mCoarseMC;
+
             atlas::gl::VertexArrayObject mLatticeVao;
             atlas::gl::Buffer mLatticeData;
             atlas::gl::Buffer mLatticeIndices;
@@ -56,11 +116,15 @@ namespace bsoid
             std::size_t mMeshNumIndices;
             std::size_t mMeshNumVertices;
 
-            atlas::gl::VertexArrayObject mMCVao;
-            atlas::gl::Buffer mMCData;
-            atlas::gl::Buffer mMCIndices;
-            std::size_t mMCNumIndices;
-            std::size_t mMCNumVertices;
+            std::vector<std::unique_ptr<LodLevel>> mLevels;
+            atlas::math::Point mGridOrigin;
+            atlas::math::Vector mVoxelSize;
+            std::size_t mFinestLevel;
+            std::size_t mLevelsUploaded;
+            float mLodPixels;
+            std::vector<GLsizei> mDrawCounts;
+            std::vector<const GLvoid*> mDrawOffsets;
+            bool mCullChunks;
 
             bool mShowLattices;
             bool mShowMesh;
@@ -68,6 +132,25 @@ namespace bsoid
             bool mHasMC;
             int mRenderMode;
             int mSelectedSlice;
+
+            // Declared last so the job is waited for before anything it
+            // uses is destroyed.
+            bool mMCReady;
+            polygonizer::Progress mProgress;
+            std::atomic<std::size_t> mLevelsDone;
+            std::atomic<std::size_t> mProgressLevel;
+
+            // Copies of the streamed data, so the buffers can be orphaned and
+            // filled again when they grow. The vertices are interleaved, and
+            // capacities are in bytes and indices.
+            std::vector<unsigned char> mStreamVertices;
+            std::vector<GLuint> mStreamIndices;
+            std::size_t mStreamVertexCapacity;
+            std::size_t mStreamIndexCapacity;
+            std::unique_ptr<polygonizer::MemoryMeshSink> mMemorySink;
+            std::unique_ptr<polygonizer::QueueMeshSink> mStream;
+
+            std::future<void> mJob;
         };
     }
 }
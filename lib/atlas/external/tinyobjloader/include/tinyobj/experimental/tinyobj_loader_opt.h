@@ -1054,8 +1054,15 @@ static bool parseLine(Command *command, const char *p, size_t p_len,
   // @todo { operate directly on pointer `p'. to do that, add range check for
   // string operatoion against `p', since `p' is not null-terminated at p[p_len]
   // }
-  char linebuf[4096];
-  assert(p_len < 4095);
+  // Lines that do not fit on the stack (long faces or names) are copied to
+  // the heap instead.
+  char stackbuf[4096];
+  std::vector<char> heapbuf;
+  char *linebuf = stackbuf;
+  if (p_len >= sizeof(stackbuf)) {
+    heapbuf.resize(p_len + 1);
+    linebuf = heapbuf.data();
+  }
   memcpy(linebuf, p, p_len);
   linebuf[p_len] = '\0';
 
@@ -1295,50 +1302,36 @@ bool parseObj(attrib_t *attrib, std::vector<shape_t> *shapes,
     for (size_t t = 0; t < static_cast<size_t>(num_threads); t++) {
       workers->push_back(std::thread([&, t]() {
         auto start_idx = (t + 0) * chunk_size;
-        auto end_idx = (std::min)((t + 1) * chunk_size, len - 1);
+        auto end_idx = (std::min)((t + 1) * chunk_size, len);
         if (t == static_cast<size_t>((num_threads - 1))) {
-          end_idx = len - 1;
+          end_idx = len;
         }
 
-        size_t prev_pos = start_idx;
-        for (size_t i = start_idx; i < end_idx; i++) {
-          if (is_line_ending(buf, i, end_idx)) {
-            if ((t > 0) && (prev_pos == start_idx) &&
-                (!is_line_ending(buf, start_idx - 1, end_idx))) {
-              // first linebreak found in (chunk > 0), and a line before this
-              // linebreak belongs to previous chunk, so skip it.
-              prev_pos = i + 1;
-              continue;
-            } else {
-              LineInfo info;
-              info.pos = prev_pos;
-              info.len = i - prev_pos;
-
-              if (info.len > 0) {
-                line_infos[t].push_back(info);
-              }
-
-              prev_pos = i + 1;
-            }
+        // Each thread owns the lines that start inside its chunk. A line that
+        // starts in this chunk may end in a later one, and the last line of
+        // the buffer does not need a trailing line ending.
+        size_t pos = start_idx;
+        if (t > 0) {
+          while (pos < end_idx && !is_line_ending(buf, pos - 1, len)) {
+            pos++;
           }
         }
 
-        // Find extra line which spand across chunk boundary.
-        if ((t < num_threads) && (buf[end_idx - 1] != '\n')) {
-          auto extra_span_idx = (std::min)(end_idx - 1 + chunk_size, len - 1);
-          for (size_t i = end_idx; i < extra_span_idx; i++) {
-            if (is_line_ending(buf, i, extra_span_idx)) {
-              LineInfo info;
-              info.pos = prev_pos;
-              info.len = i - prev_pos;
-
-              if (info.len > 0) {
-                line_infos[t].push_back(info);
-              }
+        while (pos < end_idx) {
+          size_t i = pos;
+          while (i < len && !is_line_ending(buf, i, len)) {
+            i++;
+          }
 
-              break;
-            }
+          LineInfo info;
+          info.pos = pos;
+          info.len = i - pos;
+
+          if (info.len > 0) {
+            line_infos[t].push_back(info);
           }
+
+          pos = i + 1;
         }
       }));
     }
@@ -1510,8 +1503,10 @@ bool parseObj(attrib_t *attrib, std::vector<shape_t> *shapes,
     StackVector<std::thread, 16> workers;
 
     for (size_t t = 0; t < num_threads; t++) {
-      int material_id = -1;  // -1 = default unknown material.
       workers->push_back(std::thread([&, t]() {
+        // Each worker has its own, since a reference to a variable of this
+        // loop would not outlive the iteration.
+        int material_id = -1;  // -1 = default unknown material.
         size_t v_count = v_offsets[t];
         size_t n_count = n_offsets[t];
         size_t t_count = t_offsets[t];
@@ -0,0 +1,103 @@
+/**
+ *	\file FileWatcher.hpp
+ *	\brief Defines a watcher that reports changes to files from a background
+ *	thread.
+ *
+ *	On Linux the watcher uses inotify. It watches the directories that hold
+ *	the files rather than the files themselves, so editors that save by
+ *	writing a new file and renaming it over the old one are still seen.
+ *	Changes are collected by a background thread, and checking for them is a
+ *	single atomic load until something has actually changed. On other
+ *	platforms the watcher is not available and the caller has to fall back
+ *	to polling.
+ */
+
+#ifndef ATLAS_INCLUDE_ATLAS_CORE_FILE_WATCHER_HPP
+#define ATLAS_INCLUDE_ATLAS_CORE_FILE_WATCHER_HPP
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace atlas
+{
+    namespace core
+    {
+        /**
+         *	\class FileWatcher
+         *	\brief Collects the names of watched files that were written.
+         *
+         *	Files are reported with the name they were watched with. The
+         *	watcher can be shared between threads, but it cannot be copied.
+         */
+        class FileWatcher
+        {
+        public:
+            /**
+             *	Starts the background thread. If the platform has no way of
+             *	watching files, the watcher is created unavailable and never
+             *	reports anything.
+             */
+            FileWatcher();
+
+            /**
+             *	Stops and joins the background thread.
+             */
+            ~FileWatcher();
+
+            FileWatcher(FileWatcher const&) = delete;
+            FileWatcher& operator=(FileWatcher const&) = delete;
+
+            /**
+             *	\return True if files can be watched on this platform.
+             */
+            bool isAvailable() const;
+
+            /**
+             *	Adds a file to the watch list. Watching a file more than once
+             *	has no effect.
+             *
+             *	\param[in] filename The file to watch.
+             *
+             *	\return True if the file is being watched, false otherwise.
+             */
+            bool watch(std::string const& filename);
+
+            /**
+             *	Checks whether any watched file has been written since the
+             *	changes were last taken. This only reads an atomic flag and
+             *	is meant to be called every frame.
+             */
+            bool hasChanges() const;
+
+            /**
+             *	Returns the watched files that were written since the last
+             *	call and clears the list.
+             */
+            std::vector<std::string> takeChanges();
+
+        private:
+            void run();
+
+            int mFd;
+            int mWakeFds[2];
+            std::atomic<bool> mChanged;
+            std::mutex mMutex;
+
+            // Watch descriptor of a directory to the names of the files in
+            // it and the names they were watched with.
+            std::map<int, std::multimap<std::string, std::string>> mWatches;
+            std::set<std::string> mFiles;
+            std::set<std::string> mChanges;
+            std::thread mThread;
+        };
+    }
+}
+
+#endif
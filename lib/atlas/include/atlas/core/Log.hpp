@@ -19,6 +19,15 @@
  * These are chosen depending on the macro that is used. While it is possible
  * to invoke the log function directly, it is more convenient to use the
  * provided macros.
+ *
+ * Messages are not written by the thread that logs them. The calling thread
+ * copies the format string pointer, the arguments and a time stamp into a
+ * lock-free ring buffer, and a background thread formats and writes them in
+ * order. Errors and critical messages are flushed before the call returns,
+ * and the buffer is drained when the program exits.
+ *
+ * Levels below \c ATLAS_LOG_MIN_SEVERITY (the integer value of a
+ * SeverityLevel, 0 by default) are compiled out of the macros entirely.
  * 
  */
 
@@ -29,7 +38,14 @@
 
 #include "Macros.hpp"
 
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 namespace atlas
 {
@@ -76,17 +92,201 @@ namespace atlas
              */
             void log(SeverityLevel level, std::string const& message);
 
+            /**
+             *	Outputs the passed in message as is. This overload is chosen
+             *	over the formatted one when there are no arguments, so the
+             *	message is never read as a format.
+             *
+             *	\param[in] level The severity flag for the output message.
+             *	\param[in] message The message to output.
+             */
+            void log(SeverityLevel level, const char* message);
+
+            /**
+             *	Waits until every message logged so far has been written out.
+             */
+            void flush();
+
+            namespace detail
+            {
+                /**
+                 *	The arguments of a message are copied into a fixed block
+                 *	of each ring buffer slot. Messages whose arguments do not
+                 *	fit are formatted by the calling thread instead.
+                 */
+                static const std::size_t kPayloadSize = 232;
+
+                typedef int (*Formatter)(char* buffer, std::size_t size,
+                    const char* format, const unsigned char* payload);
+
+                /**
+                 *	Copies an argument into the payload and reads it back.
+                 *	Everything except strings is copied by value.
+                 */
+                template <typename T>
+                struct Argument
+                {
+                    static_assert(std::is_trivially_copyable<T>::value,
+                        "Log arguments must be trivially copyable.");
+
+                    static std::size_t size(T const&)
+                    {
+                        return sizeof(T);
+                    }
+
+                    static void store(unsigned char*& out, T const& value)
+                    {
+                        std::memcpy(out, &value, sizeof(T));
+                        out += sizeof(T);
+                    }
+
+                    static T load(const unsigned char*& in)
+                    {
+                        T value;
+                        std::memcpy(&value, in, sizeof(T));
+                        in += sizeof(T);
+                        return value;
+                    }
+                };
+
+                /**
+                 *	Strings are copied, as the pointer may be gone by the
+                 *	time the message is formatted.
+                 */
+                template <>
+                struct Argument<const char*>
+                {
+                    static std::size_t size(const char* value)
+                    {
+                        return std::strlen(value ? value : "(null)") + 1;
+                    }
+
+                    static void store(unsigned char*& out, const char* value)
+                    {
+                        auto length = size(value);
+                        std::memcpy(out, value ? value : "(null)", length);
+                        out += length;
+                    }
+
+                    static const char* load(const unsigned char*& in)
+                    {
+                        auto value = reinterpret_cast<const char*>(in);
+                        in += std::strlen(value) + 1;
+                        return value;
+                    }
+                };
+
+                template <>
+                struct Argument<char*> : public Argument<const char*>
+                { };
+
+                template <typename T>
+                using Stored = Argument<typename std::decay<T>::type>;
+
+                inline std::size_t sizeOf()
+                {
+                    return 0;
+                }
+
+                template <typename T, typename... Rest>
+                std::size_t sizeOf(T const& first, Rest const&... rest)
+                {
+                    return Stored<T>::size(first) + sizeOf(rest...);
+                }
+
+                template <typename... Args>
+                void store(unsigned char* out, Args const&... args)
+                {
+                    int expand[] = { 0, (Stored<Args>::store(out, args), 0)... };
+                    UNUSED(expand);
+                    UNUSED(out);
+                }
+
+                template <typename Tuple, std::size_t... I>
+                int formatTuple(char* buffer, std::size_t size,
+                    const char* format, Tuple const& values,
+                    std::index_sequence<I...>)
+                {
+                    return std::snprintf(buffer, size, format,
+                        std::get<I>(values)...);
+                }
+
+                /**
+                 *	Reads the arguments back in order (braced initialization
+                 *	guarantees it) and formats them.
+                 */
+                template <typename... Args>
+                int formatPayload(char* buffer, std::size_t size,
+                    const char* format, const unsigned char* payload)
+                {
+                    UNUSED(payload);
+                    std::tuple<decltype(Stored<Args>::load(payload))...>
+                        values{ Stored<Args>::load(payload)... };
+                    return formatTuple(buffer, size, format, values,
+                        std::index_sequence_for<Args...>());
+                }
+
+                /**
+                 *	Claims a slot of the ring buffer for a message. Returns
+                 *	a pointer to the payload of the slot, or nullptr if the
+                 *	logger has been shut down and the message must be
+                 *	written directly.
+                 */
+                unsigned char* beginRecord(SeverityLevel level,
+                    std::chrono::system_clock::time_point time,
+                    Formatter formatter, const char* format);
+
+                /**
+                 *	Publishes the slot whose payload was returned by
+                 *	beginRecord.
+                 */
+                void endRecord(unsigned char* payload);
+
+                /**
+                 *	Formats the message on the calling thread and queues the
+                 *	result.
+                 */
+                void logFormatted(SeverityLevel level,
+                    std::chrono::system_clock::time_point time,
+                    const char* format, ...);
+            }
+
             /**
              *	Outputs the passed message in the format described above
              *	using the give flag to stdout and the debug console (Windows
              *	only). This function allows the user to pass in formatted
              *	strings like \c printf.
+             *
+             *	Only the arguments are copied when the message is logged, so
+             *	the format must outlive the program (string literals are the
+             *	intended use) and the arguments must be trivially copyable.
              *	
              *	\param[in] level The severity flag for the output message.
              *	\param[in] format The formatted string to output.
-             *	\param[in] ... The format specification.
+             *	\param[in] args The format specification.
              */
-            void log(SeverityLevel level, const char* format, ...);
+            template <typename... Args>
+            void log(SeverityLevel level, const char* format,
+                Args const&... args)
+            {
+                auto time = std::chrono::system_clock::now();
+                if (detail::sizeOf(args...) > detail::kPayloadSize)
+                {
+                    detail::logFormatted(level, time, format, args...);
+                    return;
+                }
+
+                auto payload = detail::beginRecord(level, time,
+                    &detail::formatPayload<Args...>, format);
+                if (!payload)
+                {
+                    detail::logFormatted(level, time, format, args...);
+                    return;
+                }
+
+                detail::store(payload, args...);
+                detail::endRecord(payload);
+            }
         }
     }
 }
@@ -108,6 +308,15 @@ namespace atlas
 #define LOG_V(level, format, ...) \
         atlas::core::Log::log(level, format, __VA_ARGS__)
 
+/**
+ *	\def ATLAS_LOG_MIN_SEVERITY
+ *	The lowest severity level, as an integer, whose macros generate any code.
+ *	Defaults to 0, which keeps every level.
+ */
+#ifndef ATLAS_LOG_MIN_SEVERITY
+#define ATLAS_LOG_MIN_SEVERITY 0
+#endif
+
 /**
  * \def DEBUG_LOG(message)
  * Outputs the given message with the "debug" flag enabled.
@@ -115,7 +324,7 @@ namespace atlas
  * This macro performs the specified operation in debug mode only. In
  * release mode, this evaluates to nothing.
  */
-#ifdef ATLAS_DEBUG
+#if defined(ATLAS_DEBUG) && (ATLAS_LOG_MIN_SEVERITY <= 0)
 #define DEBUG_LOG(message) \
         LOG(atlas::core::Log::SeverityLevel::DEBUG, message)
 
@@ -135,6 +344,7 @@ namespace atlas
 #define DEBUG_LOG_V(format, ...)
 #endif
 
+#if (ATLAS_LOG_MIN_SEVERITY <= 1)
 /**
  * \def INFO_LOG(message)
  * Outputs the given message with the "info" flag enabled.
@@ -149,7 +359,13 @@ namespace atlas
  */
 #define INFO_LOG_V(format, ...) \
         LOG_V(atlas::core::Log::SeverityLevel::INFO, format, __VA_ARGS__)
+#else
+#define INFO_LOG(message)
+
+#define INFO_LOG_V(format, ...)
+#endif
 
+#if (ATLAS_LOG_MIN_SEVERITY <= 2)
 /**
  * \def WARN_LOG(message)
  * Outputs the given message with the "warning" flag enabled.
@@ -164,7 +380,13 @@ namespace atlas
  */
 #define WARN_LOG_V(format, ...) \
         LOG_V(atlas::core::Log::SeverityLevel::WARNING, format, __VA_ARGS__)
+#else
+#define WARN_LOG(message)
+
+#define WARN_LOG_V(format, ...)
+#endif
 
+#if (ATLAS_LOG_MIN_SEVERITY <= 3)
 /**
  * \def ERROR_LOG(message)
  * Outputs the given message with the "error" flag enabled.
@@ -179,7 +401,13 @@ namespace atlas
  */
 #define ERROR_LOG_V(format, ...) \
         LOG_V(atlas::core::Log::SeverityLevel::ERR, format, __VA_ARGS__)
+#else
+#define ERROR_LOG(message)
+
+#define ERROR_LOG_V(format, ...)
+#endif
 
+#if (ATLAS_LOG_MIN_SEVERITY <= 4)
 /**
  * \def CRITICAL_LOG(message)
  * Outputs the given message with the "critical" flag enabled.
@@ -194,5 +422,10 @@ namespace atlas
  */
 #define CRITICAL_LOG_V(format, ...) \
         LOG_V(atlas::core::Log::SeverityLevel::CRITICAL, format, __VA_ARGS__)
+#else
+#define CRITICAL_LOG(message)
+
+#define CRITICAL_LOG_V(format, ...)
+#endif
 
 #endif
@@ -0,0 +1,198 @@
+/**
+ *	\file Memory.hpp
+ *	\brief Defines functions that query the memory used by the process and
+ *	an allocator that counts the memory used by individual containers.
+ */
+
+#ifndef ATLAS_INCLUDE_ATLAS_CORE_MEMORY_HPP
+#define ATLAS_INCLUDE_ATLAS_CORE_MEMORY_HPP
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace atlas
+{
+    namespace core
+    {
+        /**
+         *	Returns the resident set size of the process, which is the amount
+         *	of physical memory that it currently occupies.
+         *
+         *	\return The size in bytes, or 0 if it cannot be queried.
+         */
+        std::size_t getCurrentRSS();
+
+        /**
+         *	Returns the largest resident set size of the process since it
+         *	started or since the last call to resetPeakRSS.
+         *
+         *	\return The size in bytes, or 0 if it cannot be queried.
+         */
+        std::size_t getPeakRSS();
+
+        /**
+         *	Resets the peak resident set size to the current one, so the peak
+         *	of a single piece of work can be measured. This is only supported
+         *	on Linux, elsewhere the peak keeps covering the whole process.
+         *
+         *	\return True if the peak was reset.
+         */
+        bool resetPeakRSS();
+
+        /**
+         *	\class MemoryCounter
+         *	\brief Keeps track of the bytes allocated through any number of
+         *	CountingAllocators.
+         *
+         *	The counts are atomic, so containers that are filled from several
+         *	threads can share a counter.
+         */
+        class MemoryCounter
+        {
+        public:
+            MemoryCounter() :
+                mCurrent(0),
+                mPeak(0),
+                mAllocations(0)
+            { }
+
+            MemoryCounter(MemoryCounter const&) = delete;
+            MemoryCounter& operator=(MemoryCounter const&) = delete;
+
+            void allocate(std::size_t bytes)
+            {
+                auto current = mCurrent.fetch_add(bytes,
+                    std::memory_order_relaxed) + bytes;
+                mAllocations.fetch_add(1, std::memory_order_relaxed);
+
+                auto peak = mPeak.load(std::memory_order_relaxed);
+                while (current > peak && !mPeak.compare_exchange_weak(peak,
+                    current, std::memory_order_relaxed))
+                { }
+            }
+
+            void deallocate(std::size_t bytes)
+            {
+                mCurrent.fetch_sub(bytes, std::memory_order_relaxed);
+            }
+
+            /**
+             *	Returns the number of bytes that are currently allocated.
+             */
+            std::size_t getCurrent() const
+            {
+                return mCurrent.load(std::memory_order_relaxed);
+            }
+
+            /**
+             *	Returns the largest number of bytes that were allocated at
+             *	once since the last call to reset.
+             */
+            std::size_t getPeak() const
+            {
+                return mPeak.load(std::memory_order_relaxed);
+            }
+
+            /**
+             *	Returns the number of allocations made since the last call to
+             *	reset.
+             */
+            std::uint64_t getAllocations() const
+            {
+                return mAllocations.load(std::memory_order_relaxed);
+            }
+
+            /**
+             *	Starts a new measurement interval: the peak is set to the
+             *	current size and the allocation count to 0.
+             */
+            void reset()
+            {
+                mPeak.store(getCurrent(), std::memory_order_relaxed);
+                mAllocations.store(0, std::memory_order_relaxed);
+            }
+
+        private:
+            std::atomic<std::size_t> mCurrent;
+            std::atomic<std::size_t> mPeak;
+            std::atomic<std::uint64_t> mAllocations;
+        };
+
+        /**
+         *	\class CountingAllocator
+         *	\brief A standard allocator that reports every allocation to a
+         *	MemoryCounter.
+         *
+         *	Node-based containers allocate their nodes through the rebound
+         *	allocator, so the counted size includes the per-node overhead. An
+         *	allocator without a counter behaves like std::allocator.
+         *
+         *	\tparam T The allocated type.
+         */
+        template <typename T>
+        class CountingAllocator
+        {
+        public:
+            using value_type = T;
+
+            CountingAllocator(MemoryCounter* counter = nullptr) noexcept :
+                mCounter(counter)
+            { }
+
+            template <typename U>
+            CountingAllocator(CountingAllocator<U> const& other) noexcept :
+                mCounter(other.getCounter())
+            { }
+
+            T* allocate(std::size_t n)
+            {
+                auto bytes = n * sizeof(T);
+                auto ptr = static_cast<T*>(::operator new(bytes));
+                if (mCounter)
+                {
+                    mCounter->allocate(bytes);
+                }
+                return ptr;
+            }
+
+            // The counter is updated before the memory is freed, so that
+            // nothing is read after the free.
+            void deallocate(T* ptr, std::size_t n) noexcept
+            {
+                if (mCounter)
+                {
+                    mCounter->deallocate(n * sizeof(T));
+                }
+                ::operator delete(ptr);
+            }
+
+            MemoryCounter* getCounter() const noexcept
+            {
+                return mCounter;
+            }
+
+        private:
+            MemoryCounter* mCounter;
+        };
+
+        template <typename T, typename U>
+        bool operator==(CountingAllocator<T> const& lhs,
+            CountingAllocator<U> const& rhs) noexcept
+        {
+            return lhs.getCounter() == rhs.getCounter();
+        }
+
+        template <typename T, typename U>
+        bool operator!=(CountingAllocator<T> const& lhs,
+            CountingAllocator<U> const& rhs) noexcept
+        {
+            return !(lhs == rhs);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ *	\file NumberFormat.hpp
+ *	\brief Defines locale-independent functions to convert numbers to text.
+ */
+
+#ifndef ATLAS_INCLUDE_ATLAS_CORE_NUMBER_FORMAT_HPP
+#define ATLAS_INCLUDE_ATLAS_CORE_NUMBER_FORMAT_HPP
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace atlas
+{
+    namespace core
+    {
+        /**
+         *	The maximum number of characters written by formatFloat.
+         */
+        constexpr std::size_t MaxFloatChars = 16;
+
+        /**
+         *	The maximum number of characters written by formatUInt.
+         */
+        constexpr std::size_t MaxUIntChars = 10;
+
+        /**
+         *	Writes the shortest decimal representation of the given number
+         *	that reads back as exactly the same float. The conversion is done
+         *	with the Ryu algorithm, so it does not depend on the current locale
+         *	and does not allocate. Numbers whose magnitude is reasonable are
+         *	written in fixed notation while the rest use scientific notation.
+         *	No terminating null character is written.
+         *
+         *	\param[in] value The number to convert.
+         *	\param[out] buffer The output buffer. It must have room for at
+         *	least MaxFloatChars characters.
+         *	\return A pointer to one past the last character written.
+         */
+        char* formatFloat(float value, char* buffer);
+
+        /**
+         *	Writes the given number in decimal. No terminating null character
+         *	is written.
+         *
+         *	\param[in] value The number to convert.
+         *	\param[out] buffer The output buffer. It must have room for at
+         *	least MaxUIntChars characters.
+         *	\return A pointer to one past the last character written.
+         */
+        char* formatUInt(std::uint32_t value, char* buffer);
+    }
+}
+
+#endif
@@ -0,0 +1,122 @@
+/**
+ *	\file Profiler.hpp
+ *	\brief Defines a scoped profiler that records nested zones per thread.
+ *
+ *	Zones are opened and closed with the PROFILE_ZONE macro, which times the
+ *	enclosing scope. Every thread keeps its own stack of open zones and its
+ *	own list of finished ones, so recording a zone never contends with other
+ *	threads. The recorded zones can be written out in the Chrome trace event
+ *	format and viewed in chrome://tracing or Perfetto.
+ *
+ *	Unless ATLAS_ENABLE_PROFILING is defined the macros expand to nothing and
+ *	cost nothing.
+ */
+
+#ifndef ATLAS_INCLUDE_ATLAS_CORE_PROFILER_HPP
+#define ATLAS_INCLUDE_ATLAS_CORE_PROFILER_HPP
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace atlas
+{
+    namespace core
+    {
+        /**
+         *	\struct ProfileEvent
+         *	\brief A finished zone.
+         *
+         *	Timestamps are in nanoseconds since the profiler was first used.
+         *	The depth is the number of zones that were open on the same thread
+         *	when this one started.
+         */
+        struct ProfileEvent
+        {
+            const char* name;
+            std::uint64_t begin;
+            std::uint64_t end;
+            std::uint32_t thread;
+            std::uint32_t depth;
+        };
+
+        namespace Profiler
+        {
+            /**
+             *	Opens a zone on the calling thread. The name is stored as a
+             *	pointer, so it must outlive the profiler (string literals are
+             *	the intended use).
+             */
+            void beginZone(const char* name);
+
+            /**
+             *	Closes the most recently opened zone on the calling thread.
+             */
+            void endZone();
+
+            /**
+             *	Returns the zones finished by all threads, sorted by start
+             *	time. This must not be called while other threads are still
+             *	recording zones.
+             */
+            std::vector<ProfileEvent> getEvents();
+
+            /**
+             *	Discards every finished zone. Zones that are still open are
+             *	kept.
+             */
+            void clear();
+
+            /**
+             *	Writes the finished zones as Chrome trace event JSON.
+             */
+            void writeChromeTrace(std::ostream& out);
+
+            /**
+             *	Writes the finished zones to a Chrome trace file.
+             *
+             *	\return False if the file could not be written.
+             */
+            bool saveChromeTrace(std::string const& filename);
+        }
+
+        /**
+         *	\class ProfileZone
+         *	\brief Opens a zone on construction and closes it on destruction.
+         */
+        class ProfileZone
+        {
+        public:
+            ProfileZone(const char* name)
+            {
+                Profiler::beginZone(name);
+            }
+
+            ~ProfileZone()
+            {
+                Profiler::endZone();
+            }
+
+            ProfileZone(ProfileZone const&) = delete;
+            ProfileZone& operator=(ProfileZone const&) = delete;
+        };
+    }
+}
+
+#define ATLAS_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ATLAS_PROFILE_CONCAT(a, b) ATLAS_PROFILE_CONCAT_IMPL(a, b)
+
+#if defined(ATLAS_ENABLE_PROFILING)
+/**
+ *	Times the rest of the enclosing scope as a zone with the given name.
+ */
+#define PROFILE_ZONE(name) \
+    atlas::core::ProfileZone ATLAS_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
+
+#endif
@@ -170,9 +170,14 @@ namespace atlas
             bool reloadShaders(int idx = -1);
 
             /**
-             * This will check the timestamp of the shaders. If a shader file
-             * (or any dependencies of that file) has been modified, then the
-             * shader will be recompiled and re-linked.
+             * If a shader file (or any dependencies of that file) has been
+             * modified, then the shader will be recompiled and re-linked.
+             * 
+             * Where the platform supports it, the files are watched by a
+             * background thread, and unless one of them was written this
+             * function only reads an atomic flag. It can therefore be
+             * called every frame. Otherwise the timestamps of every file
+             * are checked on each call.
              * 
              * \return True if the shaders were reloaded, false otherwise.
              * 
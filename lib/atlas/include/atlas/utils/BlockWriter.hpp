@@ -0,0 +1,98 @@
+/**
+ *	\file BlockWriter.hpp
+ *	\brief Defines a buffered writer for large binary files.
+ */
+
+#ifndef ATLAS_INCLUDE_ATLAS_UTILS_BLOCK_WRITER_HPP
+#define ATLAS_INCLUDE_ATLAS_UTILS_BLOCK_WRITER_HPP
+
+#pragma once
+
+#include "Utils.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace atlas
+{
+    namespace utils
+    {
+        /**
+         *	\class BlockWriter
+         *	\brief Writes binary data to a file in large blocks.
+         *
+         *	Small writes are staged in an internal buffer that is handed to
+         *	the OS once it is full, while writes that are at least as large
+         *	as the buffer bypass it entirely. This keeps the number of calls
+         *	into the C runtime independent of the number of elements that
+         *	are written, which is what dominates the cost of writing large
+         *	meshes one value at a time.
+         */
+        class BlockWriter
+        {
+        public:
+            /**
+             *	Opens the given file for writing, truncating it if it already
+             *	exists.
+             *
+             *	\param[in] filename The file to write to.
+             *	\param[in] blockSize The size (in bytes) of the staging buffer.
+             */
+            BlockWriter(std::string const& filename,
+                std::size_t blockSize = DefaultBlockSize);
+
+            BlockWriter(BlockWriter const&) = delete;
+            BlockWriter& operator=(BlockWriter const&) = delete;
+
+            /**
+             *	Flushes any pending data and closes the file.
+             */
+            ~BlockWriter();
+
+            bool isOpen() const;
+
+            /**
+             *	Returns false if the file could not be opened or if any write
+             *	has failed.
+             */
+            bool good() const;
+
+            void write(const void* data, std::size_t size);
+
+            template <typename T>
+            void write(T const& value)
+            {
+                write(&value, sizeof(T));
+            }
+
+            /**
+             *	Overwrites previously written data at the given offset from the
+             *	start of the file. This is used to patch headers whose contents
+             *	are only known once all of the data has been written. Any
+             *	pending data is flushed first.
+             */
+            void writeAt(std::size_t offset, const void* data, std::size_t size);
+
+            void flush();
+            void close();
+
+            /**
+             *	The total number of bytes written so far, including the ones
+             *	that are still in the staging buffer.
+             */
+            std::size_t bytesWritten() const;
+
+            static constexpr std::size_t DefaultBlockSize = 4 * 1024 * 1024;
+
+        private:
+            std::FILE* mFile;
+            std::vector<char> mBuffer;
+            std::size_t mUsed;
+            std::size_t mWritten;
+            bool mGood;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,63 @@
+/**
+ *	\file MappedFile.hpp
+ *	\brief Defines a read-only memory mapped file.
+ */
+
+#ifndef ATLAS_INCLUDE_ATLAS_UTILS_MAPPED_FILE_HPP
+#define ATLAS_INCLUDE_ATLAS_UTILS_MAPPED_FILE_HPP
+
+#pragma once
+
+#include "Utils.hpp"
+#include "atlas/core/Platform.hpp"
+
+#include <string>
+
+namespace atlas
+{
+    namespace utils
+    {
+        /**
+         *	\class MappedFile
+         *	\brief Maps the contents of a file into memory for reading.
+         *
+         *	The contents are paged in by the OS on demand, which avoids
+         *	copying the file into a separate buffer before it is parsed. The
+         *	mapping is released when the object is destroyed.
+         */
+        class MappedFile
+        {
+        public:
+            /**
+             *	Opens and maps the given file. If the file cannot be mapped an
+             *	error is logged and isOpen returns false.
+             *
+             *	\param[in] filename The file to map.
+             */
+            MappedFile(std::string const& filename);
+
+            MappedFile(MappedFile const&) = delete;
+            MappedFile& operator=(MappedFile const&) = delete;
+
+            ~MappedFile();
+
+            bool isOpen() const;
+
+            const char* data() const;
+            std::size_t size() const;
+
+        private:
+            const char* mData;
+            std::size_t mSize;
+
+#if defined(ATLAS_PLATFORM_WINDOWS)
+            void* mFile;
+            void* mMapping;
+#else
+            int mFile;
+#endif
+        };
+    }
+}
+
+#endif
@@ -9,11 +9,23 @@
 
 #include <vector>
 #include <memory>
+#include <string>
 
 namespace atlas
 {
     namespace utils
     {
+        enum class MeshFormat : int
+        {
+            OBJ = 0,
+            PLY,
+            STL,
+            QMESH
+        };
+
+        std::string getFormatExtension(MeshFormat format);
+        MeshFormat getFormatFromFilename(std::string const& filename);
+
         struct Face
         {
             Face() :
@@ -48,6 +60,21 @@ namespace atlas
             std::vector<Face> faces;
         };
 
+        struct InterleavedMesh
+        {
+            InterleavedMesh() :
+                stride(0),
+                hasNormals(false),
+                hasTexCoords(false)
+            { }
+
+            std::vector<float> vertexData;
+            std::vector<GLuint> indices;
+            std::size_t stride;
+            bool hasNormals;
+            bool hasTexCoords;
+        };
+
         class Mesh
         {
         public:
@@ -61,8 +88,13 @@ namespace atlas
                 std::vector<atlas::math::Normal> const& normals = {},
                 std::vector<atlas::math::Point2> const& uvs = {});
 
+            // Materials are not kept, so the material library of the file
+            // is not needed.
             static bool fromFile(std::string const& filename, Mesh& mesh,
-                std::string const& mtl = "", bool triangulate = true);
+                bool triangulate = true);
+
+            static bool fromQuantizedFile(std::string const& filename,
+                InterleavedMesh& mesh);
 
             std::vector<atlas::math::Point>& vertices();
             std::vector<atlas::math::Normal>& normals();
@@ -73,8 +105,16 @@ namespace atlas
             std::vector<tinyobj::material_t>& materials();
 
             void saveToFile(std::string const& filename);
+            void saveToFile(std::string const& filename, MeshFormat format);
 
         private:
+            void saveObj(std::string const& filename);
+            void savePly(std::string const& filename);
+            void saveStl(std::string const& filename);
+            void saveQuantized(std::string const& filename);
+
+            static bool loadQuantized(std::string const& filename, Mesh& mesh);
+
             std::vector<Shape> mShapes;
             std::vector<tinyobj::material_t> mMaterials;
 
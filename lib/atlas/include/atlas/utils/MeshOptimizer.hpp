@@ -0,0 +1,80 @@
+/**
+ *	\file MeshOptimizer.hpp
+ *	\brief Defines functions that reorder meshes for faster rendering.
+ */
+
+#ifndef ATLAS_INCLUDE_ATLAS_UTILS_MESH_OPTIMIZER_HPP
+#define ATLAS_INCLUDE_ATLAS_UTILS_MESH_OPTIMIZER_HPP
+
+#pragma once
+
+#include "Utils.hpp"
+#include "Mesh.hpp"
+
+#include <vector>
+
+namespace atlas
+{
+    namespace utils
+    {
+        /**
+         *	The number of entries of the simulated post-transform vertex
+         *	cache.
+         */
+        constexpr std::size_t DefaultVertexCacheSize = 32;
+
+        /**
+         *	Computes the average cache miss ratio (ACMR) of the given
+         *	triangle list, which is the number of vertices that have to be
+         *	transformed per triangle. The cache is simulated as a FIFO, so the
+         *	result ranges from 0.5 for very long strips to 3 for meshes with
+         *	no reuse at all.
+         *
+         *	\param[in] indices The triangle list.
+         *	\param[in] cacheSize The number of entries in the cache.
+         *	\return The average number of cache misses per triangle.
+         */
+        float computeACMR(std::vector<GLuint> const& indices,
+            std::size_t cacheSize = DefaultVertexCacheSize);
+
+        /**
+         *	Reorders the triangles of the mesh so that consecutive triangles
+         *	reuse the same vertices. This uses the greedy algorithm described
+         *	by Tom Forsyth in "Linear-Speed Vertex Cache Optimisation", which
+         *	does not depend on the exact size of the cache on the GPU. The
+         *	vertices themselves are left untouched.
+         *
+         *	\param[in,out] mesh The mesh to reorder.
+         *	\param[in] cacheSize The number of entries in the simulated cache.
+         */
+        void optimizeVertexCache(Mesh& mesh,
+            std::size_t cacheSize = DefaultVertexCacheSize);
+
+        /**
+         *	Same as above, except that triangles are only reordered within
+         *	ranges of the index list, so a mesh that is drawn in separate
+         *	pieces keeps them contiguous. Each range starts at the given
+         *	offset into the index list and ends where the next one starts, or
+         *	at the end of the list for the last one.
+         *
+         *	\param[in,out] mesh The mesh to reorder.
+         *	\param[in] ranges The sorted start offsets of the ranges.
+         *	\param[in] cacheSize The number of entries in the simulated cache.
+         */
+        void optimizeVertexCache(Mesh& mesh,
+            std::vector<std::size_t> const& ranges,
+            std::size_t cacheSize = DefaultVertexCacheSize);
+
+        /**
+         *	Renumbers the vertices of the mesh in the order in which the
+         *	triangles first use them, so that vertex fetches walk through
+         *	memory linearly. Vertices that are not referenced by any triangle
+         *	are moved to the end. This should run after optimizeVertexCache.
+         *
+         *	\param[in,out] mesh The mesh to reorder.
+         */
+        void optimizeVertexFetch(Mesh& mesh);
+    }
+}
+
+#endif
@@ -0,0 +1,154 @@
+/**
+ *	\file MeshSimplifier.hpp
+ *	\brief Defines functions that decimate triangle meshes.
+ */
+
+#ifndef ATLAS_INCLUDE_ATLAS_UTILS_MESH_SIMPLIFIER_HPP
+#define ATLAS_INCLUDE_ATLAS_UTILS_MESH_SIMPLIFIER_HPP
+
+#pragma once
+
+#include "Utils.hpp"
+#include "Mesh.hpp"
+
+#include <limits>
+#include <vector>
+
+namespace atlas
+{
+    namespace utils
+    {
+        /**
+         *	The default number of partitions along each axis used by
+         *	simplifyMesh.
+         */
+        constexpr std::size_t DefaultSimplifyPartitions = 8;
+
+        /**
+         *	The number of triangles simplifyMesh wants in each cell on
+         *	average. Meshes too small to fill the grid get fewer partitions.
+         */
+        constexpr std::size_t MinSimplifyCellTriangles = 2048;
+
+        /**
+         *	Records how a simplification went and, if it stopped short of its
+         *	target, what held it back.
+         */
+        struct SimplifyStats
+        {
+            SimplifyStats();
+
+            SimplifyStats& operator+=(SimplifyStats const& rhs);
+
+            /**
+             *	The number of triangles before and after, and the number
+             *	that was aimed for.
+             */
+            std::size_t inputTriangles;
+            std::size_t triangles;
+            std::size_t targetTriangles;
+
+            /**
+             *	Edges between two border vertices, which are never collapsed.
+             */
+            std::size_t lockedEdges;
+
+            /**
+             *	Collapses that were rejected because they would have made the
+             *	surface non-manifold, joined two border vertices, or flipped
+             *	a triangle.
+             */
+            std::size_t linkRejections;
+            std::size_t borderRejections;
+            std::size_t flipRejections;
+
+            /**
+             *	Set when the cheapest remaining collapse was above the error
+             *	bound, or when no collapse was left before the target was
+             *	reached. Either one means the target was missed.
+             */
+            bool errorBound;
+            bool exhausted;
+        };
+
+        /**
+         *	Logs the result of a simplification. When it stopped short of
+         *	its target, a warning names what kept it from going further.
+         *	Rounding the targets of separate pieces up may leave a few more
+         *	triangles than the target without a warning.
+         *
+         *	\param[in] stats The result to report.
+         */
+        void logSimplifyStats(SimplifyStats const& stats);
+
+        /**
+         *	Finds the vertices that lie on the border of the given triangle
+         *	list, which are the ones that touch an edge that is not shared by
+         *	exactly two triangles.
+         *
+         *	\param[in] indices The triangle list.
+         *	\param[in] numVertices The number of vertices that the indices
+         *	refer to.
+         *	\return A flag per vertex that is set for border vertices.
+         */
+        std::vector<bool> findBorderVertices(
+            std::vector<GLuint> const& indices, std::size_t numVertices);
+
+        /**
+         *	Decimates a triangle list with quadric error edge collapses, as
+         *	described by Garland and Heckbert in "Surface Simplification Using
+         *	Quadric Error Metrics". Vertices on the border of the triangle
+         *	list are never moved or removed, so separate pieces of a mesh can
+         *	be simplified independently and still fit together afterwards.
+         *
+         *	The indices are replaced by the decimated triangles. Vertices that
+         *	survive may have been moved, while removed vertices are left in
+         *	place but are no longer referenced.
+         *
+         *	\param[in,out] vertices The vertex positions.
+         *	\param[in,out] normals The vertex normals. May be empty.
+         *	\param[in,out] indices The triangle list.
+         *	\param[in] targetTriangles The number of triangles to stop at.
+         *	\param[in] maxError A distance in model units. The cost of a
+         *	collapse is the sum of the squared distances from the new vertex
+         *	to the planes of the triangles it absorbs, and collapses stop
+         *	once it exceeds maxError squared. The vertex therefore stays
+         *	within maxError of every one of those planes, and usually much
+         *	closer.
+         *	\param[out] stats If not null, receives what happened. May be
+         *	null.
+         *	\return The number of triangles left.
+         */
+        std::size_t simplifyTriangles(
+            std::vector<atlas::math::Point>& vertices,
+            std::vector<atlas::math::Normal>& normals,
+            std::vector<GLuint>& indices, std::size_t targetTriangles,
+            float maxError = std::numeric_limits<float>::max(),
+            SimplifyStats* stats = nullptr);
+
+        /**
+         *	Decimates the mesh in parallel. The bounding box of the mesh is
+         *	split into a grid of cells, the triangles of each cell are
+         *	simplified with simplifyTriangles with the cell borders locked,
+         *	and the results are joined back together. Each cell receives a
+         *	share of the target proportional to its number of triangles.
+         *	If the target is not reached, a second pass runs on a grid
+         *	shifted by half a cell, so the edges that were locked on the cell
+         *	borders can be collapsed as well. Unreferenced vertices are
+         *	removed, so the vertices end up in first-use order.
+         *
+         *	\param[in,out] mesh The mesh to simplify.
+         *	\param[in] targetTriangles The number of triangles to aim for.
+         *	\param[in] maxError A distance in model units, see
+         *	simplifyTriangles.
+         *	\param[in] partitions The largest number of cells along each
+         *	axis.
+         *	\return What happened, which is also logged.
+         */
+        SimplifyStats simplifyMesh(Mesh& mesh, std::size_t targetTriangles,
+            float maxError = std::numeric_limits<float>::max(),
+            std::size_t partitions = DefaultSimplifyPartitions);
+    }
+}
+
+#endif
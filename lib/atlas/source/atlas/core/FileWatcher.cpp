@@ -0,0 +1,194 @@
+#include "atlas/core/FileWatcher.hpp"
+#include "atlas/core/Platform.hpp"
+#include "atlas/core/Log.hpp"
+#include "atlas/core/Macros.hpp"
+
+#ifdef ATLAS_PLATFORM_LINUX
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace atlas
+{
+    namespace core
+    {
+        FileWatcher::FileWatcher() :
+            mFd(-1),
+            mWakeFds{ -1, -1 },
+            mChanged(false)
+        {
+#ifdef ATLAS_PLATFORM_LINUX
+            mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (mFd < 0)
+            {
+                WARN_LOG("Could not create an inotify instance.");
+                return;
+            }
+
+            // Writing to the pipe wakes the thread up when it has to stop.
+            if (pipe2(mWakeFds, O_CLOEXEC) != 0)
+            {
+                WARN_LOG("Could not create the file watcher pipe.");
+                close(mFd);
+                mFd = -1;
+                return;
+            }
+
+            mThread = std::thread(&FileWatcher::run, this);
+#endif
+        }
+
+        FileWatcher::~FileWatcher()
+        {
+#ifdef ATLAS_PLATFORM_LINUX
+            if (mThread.joinable())
+            {
+                char stop = 0;
+                while (write(mWakeFds[1], &stop, 1) < 0 && errno == EINTR)
+                { }
+                mThread.join();
+            }
+
+            for (auto fd : { mFd, mWakeFds[0], mWakeFds[1] })
+            {
+                if (fd >= 0)
+                {
+                    close(fd);
+                }
+            }
+#endif
+        }
+
+        bool FileWatcher::isAvailable() const
+        {
+            return mFd >= 0;
+        }
+
+        bool FileWatcher::watch(std::string const& filename)
+        {
+#ifdef ATLAS_PLATFORM_LINUX
+            if (mFd < 0)
+            {
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mFiles.count(filename) != 0)
+            {
+                return true;
+            }
+
+            std::string dir = ".";
+            std::string name = filename;
+            auto slash = filename.find_last_of('/');
+            if (slash != std::string::npos)
+            {
+                dir = (slash == 0) ? "/" : filename.substr(0, slash);
+                name = filename.substr(slash + 1);
+            }
+
+            // Watching the same directory again returns the same descriptor.
+            int wd = inotify_add_watch(mFd, dir.c_str(),
+                IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (wd < 0)
+            {
+                WARN_LOG_V("Could not watch \"%s\".", filename.c_str());
+                return false;
+            }
+
+            mWatches[wd].emplace(name, filename);
+            mFiles.insert(filename);
+            return true;
+#else
+            UNUSED(filename);
+            return false;
+#endif
+        }
+
+        bool FileWatcher::hasChanges() const
+        {
+            return mChanged.load(std::memory_order_acquire);
+        }
+
+        std::vector<std::string> FileWatcher::takeChanges()
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mChanged.store(false, std::memory_order_relaxed);
+            std::vector<std::string> changes(mChanges.begin(),
+                mChanges.end());
+            mChanges.clear();
+            return changes;
+        }
+
+        void FileWatcher::run()
+        {
+#ifdef ATLAS_PLATFORM_LINUX
+            alignas(inotify_event) char buffer[4096];
+            pollfd fds[2] = {
+                { mFd, POLLIN, 0 },
+                { mWakeFds[0], POLLIN, 0 }
+            };
+
+            for (;;)
+            {
+                if (poll(fds, 2, -1) < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    ERROR_LOG("The file watcher stopped.");
+                    return;
+                }
+
+                if (fds[1].revents != 0)
+                {
+                    return;
+                }
+
+                if ((fds[0].revents & POLLIN) == 0)
+                {
+                    continue;
+                }
+
+                auto length = read(mFd, buffer, sizeof(buffer));
+                if (length <= 0)
+                {
+                    continue;
+                }
+
+                std::lock_guard<std::mutex> lock(mMutex);
+                bool changed = false;
+                for (char* ptr = buffer; ptr < buffer + length;
+                    ptr += sizeof(inotify_event) +
+                    reinterpret_cast<inotify_event*>(ptr)->len)
+                {
+                    auto event = reinterpret_cast<inotify_event*>(ptr);
+                    auto dir = mWatches.find(event->wd);
+                    if (event->len == 0 || dir == mWatches.end())
+                    {
+                        continue;
+                    }
+
+                    auto files = dir->second.equal_range(event->name);
+                    for (auto it = files.first; it != files.second; ++it)
+                    {
+                        mChanges.insert(it->second);
+                        changed = true;
+                    }
+                }
+
+                if (changed)
+                {
+                    mChanged.store(true, std::memory_order_release);
+                }
+            }
+#endif
+        }
+    }
+}
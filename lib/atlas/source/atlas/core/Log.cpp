@@ -6,17 +6,22 @@
 #include <windows.h>
 #endif
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <ctime>
 #include <cstring>
-#include <sstream>
-#include <iomanip>
-#include <vector>
 #include <cstdarg>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 static const int kMaxLogLength = 16 * 1024;
-static const std::vector<std::string> kLevelStrings =
-std::vector<std::string>
+// Plain strings so that messages logged during static destruction can still
+// be written.
+static const char* const kLevelStrings[] =
 {
     "debug",
     "info",
@@ -25,74 +30,396 @@ std::vector<std::string>
     "critical"
 };
 
+// Must be a power of two.
+static const std::size_t kQueueSize = 1024;
 
-namespace atlas
+namespace
 {
-    namespace core
+    using atlas::core::Log::SeverityLevel;
+    using atlas::core::Log::detail::Formatter;
+    using atlas::core::Log::detail::kPayloadSize;
+    using Clock = std::chrono::system_clock;
+
+    struct Slot
     {
-        namespace Log
+        std::atomic<std::size_t> sequence;
+        SeverityLevel level;
+        Clock::time_point time;
+
+        // Null for messages that were copied into the payload as is.
+        Formatter formatter;
+        const char* format;
+        unsigned char payload[kPayloadSize];
+    };
+
+    // Bounded multi-producer single-consumer queue. Every slot carries a
+    // sequence number that tells producers when it is free and the writer
+    // when it has been filled, so neither side ever takes a lock.
+    class Writer
+    {
+    public:
+        Writer() :
+            mSlots(new Slot[kQueueSize]),
+            mTail(0),
+            mPadding(),
+            mHead(0),
+            mWritten(0),
+            mSleeping(false),
+            mStopping(false),
+            mStopped(false),
+            mLastSecond(-1)
         {
-            static void _log(std::string const& message)
+            for (std::size_t i = 0; i < kQueueSize; ++i)
             {
-                char buf[kMaxLogLength];
-                memcpy(buf, message.c_str(), message.size() + 1);
+                mSlots[i].sequence.store(i, std::memory_order_relaxed);
+            }
 
-#ifdef ATLAS_PLATFORM_WINDOWS
-                strncat_s(buf, "\n", 3);
-
-                WCHAR wszBuf[kMaxLogLength] = { 0 };
-                MultiByteToWideChar(CP_UTF8, 0, buf, -1, wszBuf, sizeof(wszBuf));
-                OutputDebugStringW(wszBuf);
-                WideCharToMultiByte(CP_ACP, 0, wszBuf, -1, buf, sizeof(buf),
-                    nullptr, FALSE);
-                printf("%s", buf);
-                fflush(stdout);
-#else
-                strncat(buf, "\n", 3);
+            mThread = std::thread(&Writer::run, this);
+        }
 
-                fprintf(stdout, "%s", buf);
-                fflush(stdout);
-#endif
+        Slot* claim()
+        {
+            std::size_t pos = mTail.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                if (mStopped.load(std::memory_order_acquire))
+                {
+                    return nullptr;
+                }
+
+                auto& slot = mSlots[pos & (kQueueSize - 1)];
+                auto seq = slot.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(seq) -
+                    static_cast<std::ptrdiff_t>(pos);
+
+                if (diff == 0)
+                {
+                    if (mTail.compare_exchange_weak(pos, pos + 1,
+                        std::memory_order_relaxed))
+                    {
+                        return &slot;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    // The queue is full, let the writer catch up.
+                    wake();
+                    std::this_thread::yield();
+                    pos = mTail.load(std::memory_order_relaxed);
+                }
+                else
+                {
+                    pos = mTail.load(std::memory_order_relaxed);
+                }
             }
+        }
 
-            static std::string getTimeStamp()
+        void publish(Slot* slot)
+        {
+            auto seq = slot->sequence.load(std::memory_order_relaxed);
+            slot->sequence.store(seq + 1, std::memory_order_release);
+
+            // Pairs with the fence in run() so that either the writer sees
+            // the slot before sleeping or we see that it sleeps. Only the
+            // first producer to notice pays for waking it up.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (mSleeping.load(std::memory_order_relaxed) &&
+                mSleeping.exchange(false))
             {
-                auto now = std::chrono::system_clock::now();
-                auto nowTime = std::chrono::system_clock::to_time_t(now);
+                wake();
+            }
+        }
 
-                std::stringstream stream;
-                stream << std::put_time(std::localtime(&nowTime), "%T");
-                return stream.str();
+        void flush()
+        {
+            auto target = mTail.load(std::memory_order_acquire);
+            while (!mStopped.load(std::memory_order_acquire) &&
+                mWritten.load(std::memory_order_acquire) < target)
+            {
+                wake();
+                std::this_thread::yield();
             }
+        }
 
-            void log(SeverityLevel level, std::string const& message)
+        void stop()
+        {
+            if (mStopping.exchange(true))
+            {
+                return;
+            }
+
+            wake();
+            mThread.join();
+            mStopped.store(true, std::memory_order_release);
+        }
+
+        // Writes a line directly, after everything that was queued before.
+        void writeDirect(SeverityLevel level, Clock::time_point time,
+            const char* message)
+        {
+            flush();
+            std::string line;
+            std::time_t lastSecond = -1;
+            std::string stamp;
+            appendLine(line, level, time, message, lastSecond, stamp);
+
+            std::lock_guard<std::mutex> lock(mOutputMutex);
+            output(line);
+        }
+
+    private:
+        bool ready() const
+        {
+            auto& slot = mSlots[mHead & (kQueueSize - 1)];
+            return slot.sequence.load(std::memory_order_acquire) ==
+                mHead + 1;
+        }
+
+        void wake()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+            }
+            mWake.notify_one();
+        }
+
+        void run()
+        {
+            std::string batch;
+            std::vector<char> message(kMaxLogLength);
+            for (;;)
+            {
+                while (ready())
+                {
+                    auto& slot = mSlots[mHead & (kQueueSize - 1)];
+                    const char* text =
+                        reinterpret_cast<const char*>(slot.payload);
+                    if (slot.formatter)
+                    {
+                        slot.formatter(message.data(), message.size(),
+                            slot.format, slot.payload);
+                        text = message.data();
+                    }
+
+                    appendLine(batch, slot.level, slot.time, text,
+                        mLastSecond, mStamp);
+                    slot.sequence.store(mHead + kQueueSize,
+                        std::memory_order_release);
+                    ++mHead;
+
+                    if (batch.size() >= kMaxLogLength)
+                    {
+                        std::lock_guard<std::mutex> lock(mOutputMutex);
+                        output(batch);
+                        batch.clear();
+                        mWritten.store(mHead, std::memory_order_release);
+                    }
+                }
+
+                if (!batch.empty())
+                {
+                    std::lock_guard<std::mutex> lock(mOutputMutex);
+                    output(batch);
+                    batch.clear();
+                }
+                mWritten.store(mHead, std::memory_order_release);
+
+                if (mStopping.load(std::memory_order_acquire) &&
+                    mTail.load(std::memory_order_acquire) == mHead)
+                {
+                    return;
+                }
+
+                std::unique_lock<std::mutex> lock(mMutex);
+                mSleeping.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!ready() && !mStopping.load(std::memory_order_acquire))
+                {
+                    // The timeout covers producers that claimed a slot but
+                    // had not published it when we last looked.
+                    mWake.wait_for(lock, std::chrono::milliseconds(10));
+                }
+                mSleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        // The time stamp only changes once a second, so it is formatted
+        // again only when the second changes.
+        static void appendLine(std::string& out, SeverityLevel level,
+            Clock::time_point time, const char* message,
+            std::time_t& lastSecond, std::string& stamp)
+        {
+            auto second = Clock::to_time_t(time);
+            if (second != lastSecond)
             {
-                std::string logMessage = "";
+                char buffer[16];
+                std::strftime(buffer, sizeof(buffer), "%T",
+                    std::localtime(&second));
+                stamp = buffer;
+                lastSecond = second;
+            }
+
+            out.append(stamp);
+            out.append("    [");
+            out.append(kLevelStrings[static_cast<int>(level)]);
+            out.append("] : ");
+            out.append(message);
+            out.append("\n");
+        }
+
+        static void output(std::string const& text)
+        {
+#ifdef ATLAS_PLATFORM_WINDOWS
+            int length = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1,
+                nullptr, 0);
+            std::vector<WCHAR> wide(length);
+            MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, wide.data(),
+                length);
+            OutputDebugStringW(wide.data());
+
+            length = WideCharToMultiByte(CP_ACP, 0, wide.data(), -1, nullptr,
+                0, nullptr, FALSE);
+            std::vector<char> local(length);
+            WideCharToMultiByte(CP_ACP, 0, wide.data(), -1, local.data(),
+                length, nullptr, FALSE);
+            printf("%s", local.data());
+            fflush(stdout);
+#else
+            fwrite(text.data(), 1, text.size(), stdout);
+            fflush(stdout);
+#endif
+        }
 
-                // Get the current time stamp
-                logMessage.append(getTimeStamp());
-                logMessage.append("    ");
+        // Producers only touch the tail and the writer mostly the head,
+        // keep them on separate cache lines.
+        std::unique_ptr<Slot[]> mSlots;
+        std::atomic<std::size_t> mTail;
+        char mPadding[64];
+        std::size_t mHead;
+        std::atomic<std::size_t> mWritten;
 
-                std::string sevLevel = "[";
-                int levelNum = static_cast<int>(level);
-                sevLevel.append(kLevelStrings[levelNum]);
-                sevLevel.append("] : ");
+        std::atomic<bool> mSleeping;
+        std::atomic<bool> mStopping;
+        std::atomic<bool> mStopped;
+        std::mutex mMutex;
+        std::condition_variable mWake;
+        std::mutex mOutputMutex;
+        std::thread mThread;
 
-                logMessage.append(sevLevel);
-                logMessage.append(message);
-                _log(logMessage);
+        std::time_t mLastSecond;
+        std::string mStamp;
+    };
+
+    // Never destroyed, so messages logged from static destructors still go
+    // somewhere. The queue is drained when the program exits.
+    Writer& getWriter()
+    {
+        static Writer* writer = []()
+        {
+            auto w = new Writer();
+            std::atexit([]() { getWriter().stop(); });
+            return w;
+        }();
+
+        return *writer;
+    }
+
+    Slot* getSlot(unsigned char* payload)
+    {
+        return reinterpret_cast<Slot*>(payload - offsetof(Slot, payload));
+    }
+
+    void logMessage(SeverityLevel level, Clock::time_point time,
+        const char* message, std::size_t length)
+    {
+        if (length + 1 > kPayloadSize)
+        {
+            getWriter().writeDirect(level, time, message);
+            return;
+        }
+
+        auto payload = atlas::core::Log::detail::beginRecord(level, time,
+            nullptr, nullptr);
+        if (!payload)
+        {
+            getWriter().writeDirect(level, time, message);
+            return;
+        }
+
+        std::memcpy(payload, message, length + 1);
+        atlas::core::Log::detail::endRecord(payload);
+    }
+}
+
+namespace atlas
+{
+    namespace core
+    {
+        namespace Log
+        {
+            void log(SeverityLevel level, std::string const& message)
+            {
+                logMessage(level, Clock::now(), message.c_str(),
+                    message.size());
+            }
+
+            void log(SeverityLevel level, const char* message)
+            {
+                logMessage(level, Clock::now(), message,
+                    std::strlen(message));
+            }
+
+            void flush()
+            {
+                getWriter().flush();
             }
 
-            void log(SeverityLevel level, const char* format, ...)
+            namespace detail
             {
-                char buffer[kMaxLogLength];
-                va_list args;
-                va_start(args, format);
-                vsprintf(buffer, format, args);
-                va_end(args);
+                unsigned char* beginRecord(SeverityLevel level,
+                    std::chrono::system_clock::time_point time,
+                    Formatter formatter, const char* format)
+                {
+                    auto slot = getWriter().claim();
+                    if (!slot)
+                    {
+                        return nullptr;
+                    }
+
+                    slot->level = level;
+                    slot->time = time;
+                    slot->formatter = formatter;
+                    slot->format = format;
+                    return slot->payload;
+                }
+
+                void endRecord(unsigned char* payload)
+                {
+                    auto slot = getSlot(payload);
+                    auto level = slot->level;
+                    getWriter().publish(slot);
+
+                    // Errors are usually followed by the program stopping,
+                    // so make sure they are out.
+                    if (level >= SeverityLevel::ERR)
+                    {
+                        getWriter().flush();
+                    }
+                }
+
+                void logFormatted(SeverityLevel level,
+                    std::chrono::system_clock::time_point time,
+                    const char* format, ...)
+                {
+                    char buffer[kMaxLogLength];
+                    va_list args;
+                    va_start(args, format);
+                    vsnprintf(buffer, sizeof(buffer), format, args);
+                    va_end(args);
 
-                log(level, std::string(buffer));
+                    logMessage(level, time, buffer, std::strlen(buffer));
+                }
             }
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,114 @@
+#include "atlas/core/Memory.hpp"
+#include "atlas/core/Platform.hpp"
+
+#if defined(ATLAS_PLATFORM_WINDOWS)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+#if defined(ATLAS_PLATFORM_LINUX)
+    // Reads a field such as "VmRSS:    1234 kB" from /proc/self/status.
+    std::size_t readStatusField(const char* field)
+    {
+        std::FILE* file = std::fopen("/proc/self/status", "r");
+        if (!file)
+        {
+            return 0;
+        }
+
+        std::size_t length = std::strlen(field);
+        std::size_t result = 0;
+        char line[256];
+        while (std::fgets(line, sizeof(line), file))
+        {
+            if (std::strncmp(line, field, length) == 0 && line[length] == ':')
+            {
+                unsigned long long kb = 0;
+                if (std::sscanf(line + length + 1, "%llu", &kb) == 1)
+                {
+                    result = static_cast<std::size_t>(kb) * 1024;
+                }
+                break;
+            }
+        }
+
+        std::fclose(file);
+        return result;
+    }
+#endif
+}
+
+namespace atlas
+{
+    namespace core
+    {
+        std::size_t getCurrentRSS()
+        {
+#if defined(ATLAS_PLATFORM_WINDOWS)
+            PROCESS_MEMORY_COUNTERS counters;
+            if (GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                sizeof(counters)))
+            {
+                return counters.WorkingSetSize;
+            }
+            return 0;
+#elif defined(ATLAS_PLATFORM_LINUX)
+            return readStatusField("VmRSS");
+#else
+            // Without a cheap way of querying the current size, the peak is
+            // the best estimate.
+            return getPeakRSS();
+#endif
+        }
+
+        std::size_t getPeakRSS()
+        {
+#if defined(ATLAS_PLATFORM_WINDOWS)
+            PROCESS_MEMORY_COUNTERS counters;
+            if (GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                sizeof(counters)))
+            {
+                return counters.PeakWorkingSetSize;
+            }
+            return 0;
+#elif defined(ATLAS_PLATFORM_LINUX)
+            return readStatusField("VmHWM");
+#else
+            // Apple reports the maximum in bytes rather than kilobytes.
+            rusage usage;
+            if (getrusage(RUSAGE_SELF, &usage) != 0)
+            {
+                return 0;
+            }
+            return static_cast<std::size_t>(usage.ru_maxrss);
+#endif
+        }
+
+        bool resetPeakRSS()
+        {
+#if defined(ATLAS_PLATFORM_LINUX)
+            // Writing 5 to clear_refs resets VmHWM to the current RSS.
+            std::FILE* file = std::fopen("/proc/self/clear_refs", "w");
+            if (!file)
+            {
+                return false;
+            }
+
+            bool result = std::fputs("5", file) >= 0;
+            result = (std::fclose(file) == 0) && result;
+            return result;
+#else
+            return false;
+#endif
+        }
+    }
+}
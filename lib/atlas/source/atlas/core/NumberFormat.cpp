@@ -0,0 +1,453 @@
+#include "atlas/core/NumberFormat.hpp"
+
+#include <cstring>
+
+// The float to string conversion is an implementation of Ryu, described in
+// "Ryu: Fast Float-to-String Conversion" by Ulf Adams (PLDI 2018). Only the
+// single precision variant is needed here.
+namespace
+{
+    constexpr int kFloatMantissaBits = 23;
+    constexpr int kFloatExponentBits = 8;
+    constexpr int kFloatBias = 127;
+
+    constexpr int kPow5InvBitCount = 59;
+    constexpr int kPow5BitCount = 61;
+
+    // kPow5InvSplit[i] = ceil(2^(pow5Bits(i) - 1 + kPow5InvBitCount) / 5^i).
+    static const std::uint64_t kPow5InvSplit[31] =
+    {
+        576460752303423489ULL, 461168601842738791ULL,
+        368934881474191033ULL, 295147905179352826ULL,
+        472236648286964522ULL, 377789318629571618ULL,
+        302231454903657294ULL, 483570327845851670ULL,
+        386856262276681336ULL, 309485009821345069ULL,
+        495176015714152110ULL, 396140812571321688ULL,
+        316912650057057351ULL, 507060240091291761ULL,
+        405648192073033409ULL, 324518553658426727ULL,
+        519229685853482763ULL, 415383748682786211ULL,
+        332306998946228969ULL, 531691198313966350ULL,
+        425352958651173080ULL, 340282366920938464ULL,
+        544451787073501542ULL, 435561429658801234ULL,
+        348449143727040987ULL, 557518629963265579ULL,
+        446014903970612463ULL, 356811923176489971ULL,
+        570899077082383953ULL, 456719261665907162ULL,
+        365375409332725730ULL,
+    };
+
+    // kPow5Split[i] = floor(5^i / 2^(pow5Bits(i) - kPow5BitCount)).
+    static const std::uint64_t kPow5Split[47] =
+    {
+        1152921504606846976ULL, 1441151880758558720ULL,
+        1801439850948198400ULL, 2251799813685248000ULL,
+        1407374883553280000ULL, 1759218604441600000ULL,
+        2199023255552000000ULL, 1374389534720000000ULL,
+        1717986918400000000ULL, 2147483648000000000ULL,
+        1342177280000000000ULL, 1677721600000000000ULL,
+        2097152000000000000ULL, 1310720000000000000ULL,
+        1638400000000000000ULL, 2048000000000000000ULL,
+        1280000000000000000ULL, 1600000000000000000ULL,
+        2000000000000000000ULL, 1250000000000000000ULL,
+        1562500000000000000ULL, 1953125000000000000ULL,
+        1220703125000000000ULL, 1525878906250000000ULL,
+        1907348632812500000ULL, 1192092895507812500ULL,
+        1490116119384765625ULL, 1862645149230957031ULL,
+        1164153218269348144ULL, 1455191522836685180ULL,
+        1818989403545856475ULL, 2273736754432320594ULL,
+        1421085471520200371ULL, 1776356839400250464ULL,
+        2220446049250313080ULL, 1387778780781445675ULL,
+        1734723475976807094ULL, 2168404344971008868ULL,
+        1355252715606880542ULL, 1694065894508600678ULL,
+        2117582368135750847ULL, 1323488980084844279ULL,
+        1654361225106055349ULL, 2067951531382569187ULL,
+        1292469707114105741ULL, 1615587133892632177ULL,
+        2019483917365790221ULL,
+    };
+
+    static const char kDigitPairs[201] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    // ceil(log2(5^e)) for e >= 1, and 1 for e == 0.
+    inline int pow5Bits(int e)
+    {
+        return static_cast<int>(
+            ((static_cast<std::uint32_t>(e) * 1217359) >> 19) + 1);
+    }
+
+    // floor(log10(2^e)).
+    inline std::uint32_t log10Pow2(int e)
+    {
+        return (static_cast<std::uint32_t>(e) * 78913) >> 18;
+    }
+
+    // floor(log10(5^e)).
+    inline std::uint32_t log10Pow5(int e)
+    {
+        return (static_cast<std::uint32_t>(e) * 732923) >> 20;
+    }
+
+    inline std::uint32_t pow5Factor(std::uint32_t value)
+    {
+        std::uint32_t count = 0;
+        while (value % 5 == 0)
+        {
+            value /= 5;
+            ++count;
+        }
+        return count;
+    }
+
+    inline bool multipleOfPowerOf5(std::uint32_t value, std::uint32_t p)
+    {
+        return pow5Factor(value) >= p;
+    }
+
+    inline bool multipleOfPowerOf2(std::uint32_t value, std::uint32_t p)
+    {
+        return (value & ((1u << p) - 1)) == 0;
+    }
+
+    inline std::uint32_t mulShift(std::uint32_t m, std::uint64_t factor,
+        int shift)
+    {
+        std::uint64_t factorLo = factor & 0xFFFFFFFFu;
+        std::uint64_t factorHi = factor >> 32;
+        std::uint64_t bits0 = m * factorLo;
+        std::uint64_t bits1 = m * factorHi;
+        std::uint64_t sum = (bits0 >> 32) + bits1;
+        return static_cast<std::uint32_t>(sum >> (shift - 32));
+    }
+
+    inline std::uint32_t mulPow5InvDivPow2(std::uint32_t m, std::uint32_t q,
+        int j)
+    {
+        return mulShift(m, kPow5InvSplit[q], j);
+    }
+
+    inline std::uint32_t mulPow5DivPow2(std::uint32_t m, std::uint32_t i,
+        int j)
+    {
+        return mulShift(m, kPow5Split[i], j);
+    }
+
+    inline std::uint32_t decimalLength(std::uint32_t v)
+    {
+        std::uint32_t length = 1;
+        while (v >= 10)
+        {
+            v /= 10;
+            ++length;
+        }
+        return length;
+    }
+
+    // Writes the digits of v right-aligned so that the last digit ends up at
+    // end - 1.
+    inline void writeDigits(std::uint32_t v, char* end)
+    {
+        while (v >= 100)
+        {
+            std::uint32_t pair = (v % 100) * 2;
+            v /= 100;
+            end -= 2;
+            std::memcpy(end, kDigitPairs + pair, 2);
+        }
+
+        if (v >= 10)
+        {
+            end -= 2;
+            std::memcpy(end, kDigitPairs + v * 2, 2);
+        }
+        else
+        {
+            *--end = static_cast<char>('0' + v);
+        }
+    }
+
+    struct Decimal
+    {
+        std::uint32_t mantissa;
+        int exponent;
+    };
+
+    // Computes the shortest decimal m * 10^e that lies within the rounding
+    // interval of the given (finite, non-zero) binary float.
+    Decimal toDecimal(std::uint32_t ieeeMantissa, std::uint32_t ieeeExponent)
+    {
+        int e2;
+        std::uint32_t m2;
+        if (ieeeExponent == 0)
+        {
+            e2 = 1 - kFloatBias - kFloatMantissaBits - 2;
+            m2 = ieeeMantissa;
+        }
+        else
+        {
+            e2 = static_cast<int>(ieeeExponent) - kFloatBias -
+                kFloatMantissaBits - 2;
+            m2 = (1u << kFloatMantissaBits) | ieeeMantissa;
+        }
+
+        bool acceptBounds = (m2 & 1) == 0;
+
+        // The value and the two halfway points to its neighbours.
+        std::uint32_t mv = 4 * m2;
+        std::uint32_t mp = 4 * m2 + 2;
+        std::uint32_t mmShift = (ieeeMantissa != 0 || ieeeExponent <= 1);
+        std::uint32_t mm = 4 * m2 - 1 - mmShift;
+
+        std::uint32_t vr, vp, vm;
+        int e10;
+        bool vmIsTrailingZeros = false;
+        bool vrIsTrailingZeros = false;
+        std::uint32_t lastRemovedDigit = 0;
+        if (e2 >= 0)
+        {
+            std::uint32_t q = log10Pow2(e2);
+            e10 = static_cast<int>(q);
+            int k = kPow5InvBitCount + pow5Bits(static_cast<int>(q)) - 1;
+            int i = -e2 + static_cast<int>(q) + k;
+            vr = mulPow5InvDivPow2(mv, q, i);
+            vp = mulPow5InvDivPow2(mp, q, i);
+            vm = mulPow5InvDivPow2(mm, q, i);
+            if (q != 0 && (vp - 1) / 10 <= vm / 10)
+            {
+                int l = kPow5InvBitCount +
+                    pow5Bits(static_cast<int>(q - 1)) - 1;
+                lastRemovedDigit = mulPow5InvDivPow2(mv, q - 1,
+                    -e2 + static_cast<int>(q) - 1 + l) % 10;
+            }
+
+            if (q <= 9)
+            {
+                if (mv % 5 == 0)
+                {
+                    vrIsTrailingZeros = multipleOfPowerOf5(mv, q);
+                }
+                else if (acceptBounds)
+                {
+                    vmIsTrailingZeros = multipleOfPowerOf5(mm, q);
+                }
+                else
+                {
+                    vp -= multipleOfPowerOf5(mp, q);
+                }
+            }
+        }
+        else
+        {
+            std::uint32_t q = log10Pow5(-e2);
+            e10 = static_cast<int>(q) + e2;
+            int i = -e2 - static_cast<int>(q);
+            int k = pow5Bits(i) - kPow5BitCount;
+            int j = static_cast<int>(q) - k;
+            vr = mulPow5DivPow2(mv, static_cast<std::uint32_t>(i), j);
+            vp = mulPow5DivPow2(mp, static_cast<std::uint32_t>(i), j);
+            vm = mulPow5DivPow2(mm, static_cast<std::uint32_t>(i), j);
+            if (q != 0 && (vp - 1) / 10 <= vm / 10)
+            {
+                j = static_cast<int>(q) - 1 - (pow5Bits(i + 1) - kPow5BitCount);
+                lastRemovedDigit = mulPow5DivPow2(mv,
+                    static_cast<std::uint32_t>(i + 1), j) % 10;
+            }
+
+            if (q <= 1)
+            {
+                vrIsTrailingZeros = true;
+                if (acceptBounds)
+                {
+                    vmIsTrailingZeros = (mmShift == 1);
+                }
+                else
+                {
+                    --vp;
+                }
+            }
+            else if (q < 31)
+            {
+                vrIsTrailingZeros = multipleOfPowerOf2(mv, q - 1);
+            }
+        }
+
+        // Remove digits for as long as the interval allows it.
+        int removed = 0;
+        std::uint32_t output;
+        if (vmIsTrailingZeros || vrIsTrailingZeros)
+        {
+            while (vp / 10 > vm / 10)
+            {
+                vmIsTrailingZeros &= (vm % 10 == 0);
+                vrIsTrailingZeros &= (lastRemovedDigit == 0);
+                lastRemovedDigit = vr % 10;
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                ++removed;
+            }
+
+            if (vmIsTrailingZeros)
+            {
+                while (vm % 10 == 0)
+                {
+                    vrIsTrailingZeros &= (lastRemovedDigit == 0);
+                    lastRemovedDigit = vr % 10;
+                    vr /= 10;
+                    vp /= 10;
+                    vm /= 10;
+                    ++removed;
+                }
+            }
+
+            if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0)
+            {
+                // Round even if the exact value is .....50..0.
+                lastRemovedDigit = 4;
+            }
+
+            output = vr + ((vr == vm && (!acceptBounds || !vmIsTrailingZeros))
+                || lastRemovedDigit >= 5);
+        }
+        else
+        {
+            while (vp / 10 > vm / 10)
+            {
+                lastRemovedDigit = vr % 10;
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                ++removed;
+            }
+
+            output = vr + (vr == vm || lastRemovedDigit >= 5);
+        }
+
+        return { output, e10 + removed };
+    }
+}
+
+namespace atlas
+{
+    namespace core
+    {
+        char* formatFloat(float value, char* buffer)
+        {
+            std::uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(float));
+
+            bool sign = ((bits >> (kFloatMantissaBits + kFloatExponentBits))
+                & 1) != 0;
+            std::uint32_t ieeeMantissa =
+                bits & ((1u << kFloatMantissaBits) - 1);
+            std::uint32_t ieeeExponent = (bits >> kFloatMantissaBits) &
+                ((1u << kFloatExponentBits) - 1);
+
+            char* out = buffer;
+            if (ieeeExponent == ((1u << kFloatExponentBits) - 1))
+            {
+                if (ieeeMantissa != 0)
+                {
+                    std::memcpy(out, "nan", 3);
+                    return out + 3;
+                }
+
+                if (sign)
+                {
+                    *out++ = '-';
+                }
+                std::memcpy(out, "inf", 3);
+                return out + 3;
+            }
+
+            if (sign)
+            {
+                *out++ = '-';
+            }
+
+            if (ieeeExponent == 0 && ieeeMantissa == 0)
+            {
+                *out++ = '0';
+                return out;
+            }
+
+            Decimal d = toDecimal(ieeeMantissa, ieeeExponent);
+            int length = static_cast<int>(decimalLength(d.mantissa));
+
+            // The number of digits in front of the decimal point.
+            int point = length + d.exponent;
+            if (d.exponent >= 0 && point <= 9)
+            {
+                // Integer: the digits followed by the trailing zeros.
+                writeDigits(d.mantissa, out + length);
+                out += length;
+                std::memset(out, '0', d.exponent);
+                return out + d.exponent;
+            }
+
+            if (d.exponent < 0 && point > 0)
+            {
+                // The point falls within the digits.
+                writeDigits(d.mantissa, out + length + 1);
+                std::memmove(out, out + 1, point);
+                out[point] = '.';
+                return out + length + 1;
+            }
+
+            if (point <= 0 && point > -4)
+            {
+                // Small number: 0.000ddd.
+                *out++ = '0';
+                *out++ = '.';
+                std::memset(out, '0', -point);
+                out += -point;
+                writeDigits(d.mantissa, out + length);
+                return out + length;
+            }
+
+            // Everything else goes into scientific notation: d.ddde+xx.
+            writeDigits(d.mantissa, out + length + 1);
+            out[0] = out[1];
+            if (length > 1)
+            {
+                out[1] = '.';
+                out += length + 1;
+            }
+            else
+            {
+                out += 1;
+            }
+
+            int exponent = point - 1;
+            *out++ = 'e';
+            if (exponent < 0)
+            {
+                *out++ = '-';
+                exponent = -exponent;
+            }
+
+            if (exponent >= 10)
+            {
+                std::memcpy(out, kDigitPairs + exponent * 2, 2);
+                return out + 2;
+            }
+
+            *out++ = static_cast<char>('0' + exponent);
+            return out;
+        }
+
+        char* formatUInt(std::uint32_t value, char* buffer)
+        {
+            std::uint32_t length = decimalLength(value);
+            writeDigits(value, buffer + length);
+            return buffer + length;
+        }
+    }
+}
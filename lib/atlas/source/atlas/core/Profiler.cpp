@@ -0,0 +1,209 @@
+#include "atlas/core/Profiler.hpp"
+#include "atlas/core/Log.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct OpenZone
+    {
+        const char* name;
+        std::uint64_t begin;
+    };
+
+    // Owned by the registry rather than the thread so the events of threads
+    // that have exited are still reported.
+    struct ThreadBuffer
+    {
+        std::uint32_t id;
+        std::vector<OpenZone> stack;
+        std::vector<atlas::core::ProfileEvent> events;
+    };
+
+    struct Registry
+    {
+        Registry() :
+            epoch(Clock::now())
+        { }
+
+        Clock::time_point epoch;
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    };
+
+    Registry& getRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    ThreadBuffer& getThreadBuffer()
+    {
+        static thread_local ThreadBuffer* buffer = nullptr;
+        if (!buffer)
+        {
+            auto& registry = getRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.buffers.emplace_back(new ThreadBuffer());
+            buffer = registry.buffers.back().get();
+            buffer->id = static_cast<std::uint32_t>(
+                registry.buffers.size() - 1);
+        }
+
+        return *buffer;
+    }
+
+    std::uint64_t now()
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - getRegistry().epoch).count());
+    }
+
+    void writeJsonString(std::ostream& out, const char* str)
+    {
+        out << '"';
+        for (; *str; ++str)
+        {
+            if (*str == '"' || *str == '\\')
+            {
+                out << '\\';
+            }
+            out << *str;
+        }
+        out << '"';
+    }
+
+    // Chrome expects microseconds, keep the nanoseconds as decimals.
+    void writeMicroseconds(std::ostream& out, std::uint64_t ns)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%llu.%03llu",
+            static_cast<unsigned long long>(ns / 1000),
+            static_cast<unsigned long long>(ns % 1000));
+        out << buffer;
+    }
+}
+
+namespace atlas
+{
+    namespace core
+    {
+        namespace Profiler
+        {
+            void beginZone(const char* name)
+            {
+                auto& buffer = getThreadBuffer();
+                buffer.stack.push_back({ name, now() });
+            }
+
+            void endZone()
+            {
+                auto end = now();
+                auto& buffer = getThreadBuffer();
+                if (buffer.stack.empty())
+                {
+                    return;
+                }
+
+                auto zone = buffer.stack.back();
+                buffer.stack.pop_back();
+                buffer.events.push_back({ zone.name, zone.begin, end,
+                    buffer.id, static_cast<std::uint32_t>(
+                        buffer.stack.size()) });
+            }
+
+            std::vector<ProfileEvent> getEvents()
+            {
+                auto& registry = getRegistry();
+                std::vector<ProfileEvent> events;
+                {
+                    std::lock_guard<std::mutex> lock(registry.mutex);
+                    for (auto& buffer : registry.buffers)
+                    {
+                        events.insert(events.end(), buffer->events.begin(),
+                            buffer->events.end());
+                    }
+                }
+
+                std::sort(events.begin(), events.end(),
+                    [](ProfileEvent const& a, ProfileEvent const& b)
+                {
+                    return (a.begin != b.begin) ? a.begin < b.begin :
+                        a.depth < b.depth;
+                });
+
+                return events;
+            }
+
+            void clear()
+            {
+                auto& registry = getRegistry();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                for (auto& buffer : registry.buffers)
+                {
+                    buffer->events.clear();
+                }
+            }
+
+            void writeChromeTrace(std::ostream& out)
+            {
+                auto events = getEvents();
+
+                std::uint32_t numThreads = 0;
+                for (auto& event : events)
+                {
+                    numThreads = std::max(numThreads, event.thread + 1);
+                }
+
+                out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+                bool first = true;
+                for (std::uint32_t t = 0; t < numThreads; ++t)
+                {
+                    out << (first ? "\n" : ",\n");
+                    out << "{\"name\":\"thread_name\",\"ph\":\"M\"," \
+                        "\"pid\":0,\"tid\":" << t << ",\"args\":{\"name\":" \
+                        "\"Thread " << t << "\"}}";
+                    first = false;
+                }
+
+                for (auto& event : events)
+                {
+                    out << (first ? "\n" : ",\n");
+                    out << "{\"name\":";
+                    writeJsonString(out, event.name);
+                    out << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread <<
+                        ",\"ts\":";
+                    writeMicroseconds(out, event.begin);
+                    out << ",\"dur\":";
+                    writeMicroseconds(out, event.end - event.begin);
+                    out << "}";
+                    first = false;
+                }
+
+                out << "\n]}\n";
+            }
+
+            bool saveChromeTrace(std::string const& filename)
+            {
+                std::ofstream file(filename);
+                if (!file)
+                {
+                    ERROR_LOG_V("Could not open %s for writing.",
+                        filename.c_str());
+                    return false;
+                }
+
+                writeChromeTrace(file);
+                return static_cast<bool>(file);
+            }
+        }
+    }
+}
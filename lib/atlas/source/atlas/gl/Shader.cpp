@@ -3,6 +3,7 @@
 #include "atlas/core/Platform.hpp"
 #include "atlas/core/Macros.hpp"
 #include "atlas/core/Exception.hpp"
+#include "atlas/core/FileWatcher.hpp"
 #include "atlas/gl/ErrorCheck.hpp"
 
 #include <iostream>
@@ -33,6 +34,23 @@ namespace atlas
             ShaderImpl(ShaderImpl const& impl) = default;
             ~ShaderImpl() = default;
 
+            // The watcher is only created once a file is read, so shaders
+            // that are never compiled do not start a thread.
+            void watchFile(std::string const& filename)
+            {
+                if (!watcher)
+                {
+                    watcher = std::make_shared<core::FileWatcher>();
+                }
+
+                watcher->watch(filename);
+            }
+
+            bool isWatching() const
+            {
+                return watcher && watcher->isAvailable();
+            }
+
             time_t getFileTimeStamp(std::string const& filename)
             {
                 // Check to see if hot reloading is available. If it isn't, 
@@ -75,6 +93,7 @@ namespace atlas
                 {
                     auto timestamp = getFileTimeStamp(filename);
                     unit.includedFiles.push_back({ filename, -1 , timestamp });
+                    watchFile(filename);
                 }
 
                 int fileNum = (int)unit.includedFiles.size() - 1;
@@ -108,6 +127,7 @@ namespace atlas
                         auto timestamp = getFileTimeStamp(absolutePath);
                         ShaderFile f = { absolutePath, fileNum, timestamp };
                         unit.includedFiles.push_back(f);
+                        watchFile(absolutePath);
 
                         // Now recurse on the included file.
                         auto parsedFile = readShaderSource(absolutePath, unit);
@@ -352,6 +372,7 @@ namespace atlas
             std::vector<std::string> tmpFiles;
             bool isHotReloadAvailable;
             std::string includeDir;
+            std::shared_ptr<core::FileWatcher> watcher;
         };
 
         Shader::Shader() :
@@ -532,25 +553,54 @@ namespace atlas
 
             int i = 0;
             std::vector<int> changedShaders;
-            for (auto& unit : mImpl->shaderUnits)
+            if (mImpl->isWatching())
             {
-                // Now check every single included file. If the timestamps
-                // are different, then queue it to be reloaded.
-                for (auto& file : unit.includedFiles)
+                // The watcher thread has already seen every write, so
+                // unless it flagged something there is nothing to do.
+                if (!mImpl->watcher->hasChanges())
                 {
-                    time_t stamp = mImpl->getFileTimeStamp(file.name);
+                    return false;
+                }
 
-                    double secs = std::difftime(stamp, file.timeStamp);
-                    if (secs > 0)
+                auto changes = mImpl->watcher->takeChanges();
+                std::set<std::string> changedFiles(changes.begin(),
+                    changes.end());
+                for (auto& unit : mImpl->shaderUnits)
+                {
+                    for (auto& file : unit.includedFiles)
                     {
-                        // Add the unit to the queue and update the timestamp
-                        // on the file.
-                        file.timeStamp = stamp;
-                        changedShaders.push_back(i);
+                        if (changedFiles.count(file.name) != 0)
+                        {
+                            changedShaders.push_back(i);
+                        }
                     }
+
+                    ++i;
                 }
+            }
+            else
+            {
+                for (auto& unit : mImpl->shaderUnits)
+                {
+                    // Now check every single included file. If the
+                    // timestamps are different, then queue it to be
+                    // reloaded.
+                    for (auto& file : unit.includedFiles)
+                    {
+                        time_t stamp = mImpl->getFileTimeStamp(file.name);
+
+                        double secs = std::difftime(stamp, file.timeStamp);
+                        if (secs > 0)
+                        {
+                            // Add the unit to the queue and update the
+                            // timestamp on the file.
+                            file.timeStamp = stamp;
+                            changedShaders.push_back(i);
+                        }
+                    }
 
-                ++i;
+                    ++i;
+                }
             }
 
             // If there's nothing to reload, return.
@@ -0,0 +1,153 @@
+#include "atlas/utils/BlockWriter.hpp"
+#include "atlas/core/Log.hpp"
+#include "atlas/core/Platform.hpp"
+
+#if !defined(ATLAS_PLATFORM_WINDOWS)
+#include <sys/types.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    // std::fseek takes a long, which is only 32 bits on Windows, so offsets
+    // past 2 GiB need the 64-bit variant of each platform. An offset that
+    // off_t cannot hold fails instead of wrapping around.
+    bool seekTo(std::FILE* file, std::uint64_t offset, int origin)
+    {
+#if defined(ATLAS_PLATFORM_WINDOWS)
+        if (offset > static_cast<std::uint64_t>(
+            std::numeric_limits<__int64>::max()))
+        {
+            return false;
+        }
+
+        return _fseeki64(file, static_cast<__int64>(offset), origin) == 0;
+#else
+        if (offset > static_cast<std::uint64_t>(
+            std::numeric_limits<off_t>::max()))
+        {
+            return false;
+        }
+
+        return fseeko(file, static_cast<off_t>(offset), origin) == 0;
+#endif
+    }
+}
+
+namespace atlas
+{
+    namespace utils
+    {
+        constexpr std::size_t BlockWriter::DefaultBlockSize;
+
+        BlockWriter::BlockWriter(std::string const& filename,
+            std::size_t blockSize) :
+            mFile(std::fopen(filename.c_str(), "wb")),
+            mBuffer(blockSize),
+            mUsed(0),
+            mWritten(0),
+            mGood(true)
+        {
+            if (!mFile)
+            {
+                ERROR_LOG_V("Could not open file %s for writing.",
+                    filename.c_str());
+                mGood = false;
+                return;
+            }
+
+            // We do our own buffering, so there is no point in having the
+            // runtime copy everything a second time.
+            std::setvbuf(mFile, nullptr, _IONBF, 0);
+        }
+
+        BlockWriter::~BlockWriter()
+        {
+            close();
+        }
+
+        bool BlockWriter::isOpen() const
+        {
+            return mFile != nullptr;
+        }
+
+        bool BlockWriter::good() const
+        {
+            return mGood;
+        }
+
+        void BlockWriter::write(const void* data, std::size_t size)
+        {
+            if (!mFile)
+            {
+                return;
+            }
+
+            if (mBuffer.size() - mUsed < size)
+            {
+                flush();
+            }
+
+            mWritten += size;
+            if (size >= mBuffer.size())
+            {
+                // Large arrays go straight to the file.
+                mGood &= (std::fwrite(data, 1, size, mFile) == size);
+                return;
+            }
+
+            std::memcpy(mBuffer.data() + mUsed, data, size);
+            mUsed += size;
+        }
+
+        void BlockWriter::writeAt(std::size_t offset, const void* data,
+            std::size_t size)
+        {
+            if (!mFile)
+            {
+                return;
+            }
+
+            flush();
+            if (!seekTo(mFile, offset, SEEK_SET))
+            {
+                mGood = false;
+                return;
+            }
+
+            mGood &= (std::fwrite(data, 1, size, mFile) == size);
+            mGood &= seekTo(mFile, 0, SEEK_END);
+        }
+
+        void BlockWriter::flush()
+        {
+            if (!mFile || mUsed == 0)
+            {
+                return;
+            }
+
+            mGood &= (std::fwrite(mBuffer.data(), 1, mUsed, mFile) == mUsed);
+            mUsed = 0;
+        }
+
+        void BlockWriter::close()
+        {
+            if (!mFile)
+            {
+                return;
+            }
+
+            flush();
+            mGood &= (std::fclose(mFile) == 0);
+            mFile = nullptr;
+        }
+
+        std::size_t BlockWriter::bytesWritten() const
+        {
+            return mWritten;
+        }
+    }
+}
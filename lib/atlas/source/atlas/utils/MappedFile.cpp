@@ -0,0 +1,142 @@
+#include "atlas/utils/MappedFile.hpp"
+#include "atlas/core/Log.hpp"
+
+#if defined(ATLAS_PLATFORM_WINDOWS)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace atlas
+{
+    namespace utils
+    {
+#if defined(ATLAS_PLATFORM_WINDOWS)
+        MappedFile::MappedFile(std::string const& filename) :
+            mData(nullptr),
+            mSize(0),
+            mFile(INVALID_HANDLE_VALUE),
+            mMapping(nullptr)
+        {
+            mFile = CreateFileA(filename.c_str(), GENERIC_READ,
+                FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (mFile == INVALID_HANDLE_VALUE)
+            {
+                ERROR_LOG_V("Could not open file %s.", filename.c_str());
+                return;
+            }
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+            {
+                ERROR_LOG_V("File %s is empty.", filename.c_str());
+                return;
+            }
+
+            mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0,
+                nullptr);
+            if (!mMapping)
+            {
+                ERROR_LOG_V("Could not map file %s.", filename.c_str());
+                return;
+            }
+
+            mData = static_cast<const char*>(
+                MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+            if (!mData)
+            {
+                ERROR_LOG_V("Could not map file %s.", filename.c_str());
+                return;
+            }
+
+            mSize = static_cast<std::size_t>(size.QuadPart);
+        }
+
+        MappedFile::~MappedFile()
+        {
+            if (mData)
+            {
+                UnmapViewOfFile(mData);
+            }
+
+            if (mMapping)
+            {
+                CloseHandle(mMapping);
+            }
+
+            if (mFile != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(mFile);
+            }
+        }
+#else
+        MappedFile::MappedFile(std::string const& filename) :
+            mData(nullptr),
+            mSize(0),
+            mFile(-1)
+        {
+            mFile = open(filename.c_str(), O_RDONLY);
+            if (mFile == -1)
+            {
+                ERROR_LOG_V("Could not open file %s.", filename.c_str());
+                return;
+            }
+
+            struct stat info;
+            if (fstat(mFile, &info) == -1 || info.st_size == 0)
+            {
+                ERROR_LOG_V("File %s is empty.", filename.c_str());
+                return;
+            }
+
+            void* data = mmap(nullptr, static_cast<std::size_t>(info.st_size),
+                PROT_READ, MAP_PRIVATE, mFile, 0);
+            if (data == MAP_FAILED)
+            {
+                ERROR_LOG_V("Could not map file %s.", filename.c_str());
+                return;
+            }
+
+            // The file is read front to back by the parser.
+            madvise(data, static_cast<std::size_t>(info.st_size),
+                MADV_SEQUENTIAL);
+
+            mData = static_cast<const char*>(data);
+            mSize = static_cast<std::size_t>(info.st_size);
+        }
+
+        MappedFile::~MappedFile()
+        {
+            if (mData)
+            {
+                munmap(const_cast<char*>(mData), mSize);
+            }
+
+            if (mFile != -1)
+            {
+                close(mFile);
+            }
+        }
+#endif
+
+        bool MappedFile::isOpen() const
+        {
+            return mData != nullptr;
+        }
+
+        const char* MappedFile::data() const
+        {
+            return mData;
+        }
+
+        std::size_t MappedFile::size() const
+        {
+            return mSize;
+        }
+    }
+}
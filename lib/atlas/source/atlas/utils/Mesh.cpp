@@ -1,16 +1,360 @@
 #include "atlas/utils/Mesh.hpp"
+#include "atlas/utils/BlockWriter.hpp"
+#include "atlas/utils/MappedFile.hpp"
+#include "atlas/utils/MeshOptimizer.hpp"
+#include "atlas/utils/BBox.hpp"
 #include "atlas/core/Log.hpp"
+#include "atlas/core/NumberFormat.hpp"
 
-#include <unordered_set>
-#include <functional>
-#include <fstream>
 #include <unordered_map>
-#include <numeric>
+#include <algorithm>
+#include <cctype>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+#include <array>
+#include <atomic>
+
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_scan.h>
+#include <tbb/parallel_sort.h>
+#include <tbb/task_arena.h>
+#include <tbb/blocked_range.h>
+
+// The optimized loader pulls in windows.h, which must not define min and max.
+#if defined(ATLAS_PLATFORM_WINDOWS) && !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+// Only the declarations of the loader are used here, its static helpers
+// are compiled with the implementation.
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+#include <tinyobj/experimental/tinyobj_loader_opt.h>
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace
+{
+    // Replaces every value with the sum of the values in front of it and
+    // returns the total.
+    std::uint32_t exclusiveScan(std::vector<std::uint32_t>& values)
+    {
+        using Range = tbb::blocked_range<std::size_t>;
+        return tbb::parallel_scan(Range(0, values.size()), std::uint32_t(0),
+            [&values](Range const& range, std::uint32_t sum, bool isFinal)
+        {
+            for (auto i = range.begin(); i != range.end(); ++i)
+            {
+                auto value = values[i];
+                if (isFinal)
+                {
+                    values[i] = sum;
+                }
+                sum += value;
+            }
+            return sum;
+        },
+            [](std::uint32_t lhs, std::uint32_t rhs)
+        {
+            return lhs + rhs;
+        });
+    }
+
+    // The quantized format starts with this header, followed by the
+    // positions, normals, texture coordinates and the index stream.
+    struct QuantizedHeader
+    {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t flags;
+        std::uint32_t numVertices;
+        std::uint32_t numIndices;
+        std::uint32_t reserved;
+        std::uint64_t indexBytes;
+        float boxMin[3];
+        float boxMax[3];
+    };
+
+    static_assert(sizeof(QuantizedHeader) == 56,
+        "The quantized mesh header must not contain padding.");
+
+    constexpr char QuantizedMagic[4] = { 'Q', 'M', 'S', 'H' };
+    constexpr std::uint32_t QuantizedVersion = 1;
+    constexpr std::uint32_t QuantizedHasNormals = 1;
+    constexpr std::uint32_t QuantizedHasTexCoords = 2;
+    constexpr float QuantizedPositionScale = 65535.0f;
+    constexpr float QuantizedNormalScale = 32767.0f;
+
+    // Octahedral encoding maps the unit sphere onto a square by projecting
+    // onto the octahedron |x| + |y| + |z| = 1 and folding the lower half
+    // over the diagonals.
+    void encodeOctahedral(atlas::math::Normal const& n, std::int16_t* out)
+    {
+        float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        float x = (sum > 0.0f) ? n.x / sum : 0.0f;
+        float y = (sum > 0.0f) ? n.y / sum : 0.0f;
+        if (n.z < 0.0f)
+        {
+            float fx = (1.0f - std::abs(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+            float fy = (1.0f - std::abs(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+            x = fx;
+            y = fy;
+        }
+
+        out[0] = static_cast<std::int16_t>(std::round(
+            glm::clamp(x, -1.0f, 1.0f) * QuantizedNormalScale));
+        out[1] = static_cast<std::int16_t>(std::round(
+            glm::clamp(y, -1.0f, 1.0f) * QuantizedNormalScale));
+    }
+
+    atlas::math::Normal decodeOctahedral(std::int16_t const* in)
+    {
+        float x = static_cast<float>(in[0]) / QuantizedNormalScale;
+        float y = static_cast<float>(in[1]) / QuantizedNormalScale;
+        float z = 1.0f - std::abs(x) - std::abs(y);
+        if (z < 0.0f)
+        {
+            float fx = (1.0f - std::abs(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+            float fy = (1.0f - std::abs(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+            x = fx;
+            y = fy;
+        }
+        return glm::normalize(atlas::math::Normal(x, y, z));
+    }
+
+    // Indices are stored as the zig-zag encoded difference to the previous
+    // index, written as a little-endian base 128 varint.
+    char* writeVarint(std::uint32_t value, char* out)
+    {
+        while (value >= 0x80)
+        {
+            *out++ = static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        *out++ = static_cast<char>(value);
+        return out;
+    }
+
+    bool readIndices(const unsigned char* in, std::size_t size,
+        std::vector<GLuint>& indices)
+    {
+        const unsigned char* end = in + size;
+        std::uint32_t previous = 0;
+        for (auto& index : indices)
+        {
+            std::uint32_t value = 0;
+            for (int shift = 0;; shift += 7)
+            {
+                if (in == end || shift > 28)
+                {
+                    return false;
+                }
+
+                std::uint32_t byte = *in++;
+                value |= (byte & 0x7F) << shift;
+                if (!(byte & 0x80))
+                {
+                    break;
+                }
+            }
+
+            std::uint32_t delta = (value >> 1) ^ (0u - (value & 1));
+            previous += delta;
+            index = previous;
+        }
+
+        return in == end;
+    }
+
+    // Where the sections of a quantized file start, derived from a header
+    // that has been checked against the size of the file.
+    struct QuantizedLayout
+    {
+        std::size_t numVertices;
+        std::size_t numIndices;
+        std::size_t positionOffset;
+        std::size_t normalOffset;
+        std::size_t uvOffset;
+        std::size_t indexOffset;
+        std::size_t indexBytes;
+        bool hasNormals;
+        bool hasTexCoords;
+    };
+
+    // Checks every count and offset of the header against the size of the
+    // file before anything is allocated from them. The section sizes are
+    // summed in 64 bits, where they cannot overflow since the counts are 32
+    // bits, and the index bytes are compared against what is left of the
+    // file instead of being added to the offset.
+    bool readQuantizedHeader(atlas::utils::MappedFile const& file,
+        QuantizedHeader& header, QuantizedLayout& layout)
+    {
+        if (file.size() < sizeof(QuantizedHeader))
+        {
+            return false;
+        }
+
+        std::memcpy(&header, file.data(), sizeof(QuantizedHeader));
+        if (std::memcmp(header.magic, QuantizedMagic, 4) != 0 ||
+            header.version != QuantizedVersion ||
+            header.numIndices % 3 != 0)
+        {
+            return false;
+        }
+
+        bool hasNormals = (header.flags & QuantizedHasNormals) != 0;
+        bool hasTexCoords = (header.flags & QuantizedHasTexCoords) != 0;
+        std::uint64_t n = header.numVertices;
+        std::uint64_t normalOffset = sizeof(QuantizedHeader) +
+            n * 3 * sizeof(std::uint16_t);
+        std::uint64_t uvOffset = normalOffset +
+            (hasNormals ? n * 2 * sizeof(std::int16_t) : 0);
+        std::uint64_t indexOffset = uvOffset +
+            (hasTexCoords ? n * 2 * sizeof(float) : 0);
+
+        std::uint64_t size = file.size();
+        if (indexOffset > size || header.indexBytes != size - indexOffset)
+        {
+            return false;
+        }
+
+        // Every index takes between one and five bytes.
+        std::uint64_t numIndices = header.numIndices;
+        if (numIndices > header.indexBytes ||
+            header.indexBytes > 5 * numIndices)
+        {
+            return false;
+        }
+
+        layout.numVertices = static_cast<std::size_t>(n);
+        layout.numIndices = static_cast<std::size_t>(numIndices);
+        layout.positionOffset = sizeof(QuantizedHeader);
+        layout.normalOffset = static_cast<std::size_t>(normalOffset);
+        layout.uvOffset = static_cast<std::size_t>(uvOffset);
+        layout.indexOffset = static_cast<std::size_t>(indexOffset);
+        layout.indexBytes = static_cast<std::size_t>(header.indexBytes);
+        layout.hasNormals = hasNormals;
+        layout.hasTexCoords = hasTexCoords;
+        return true;
+    }
+
+    // Decodes a file whose header has been read into the given indices and
+    // calls the given function with every decoded vertex.
+    template <typename Callback>
+    bool readQuantized(atlas::utils::MappedFile const& file,
+        QuantizedHeader const& header, QuantizedLayout const& layout,
+        std::vector<GLuint>& indices, Callback const& vertex)
+    {
+        auto data = reinterpret_cast<const unsigned char*>(file.data());
+        indices.resize(layout.numIndices);
+        if (!readIndices(data + layout.indexOffset, layout.indexBytes,
+            indices))
+        {
+            return false;
+        }
+
+        std::size_t n = layout.numVertices;
+        for (auto index : indices)
+        {
+            if (index >= n)
+            {
+                return false;
+            }
+        }
+
+        atlas::math::Point boxMin(header.boxMin[0], header.boxMin[1],
+            header.boxMin[2]);
+        atlas::math::Point boxMax(header.boxMax[0], header.boxMax[1],
+            header.boxMax[2]);
+        auto scale = (boxMax - boxMin) / QuantizedPositionScale;
+
+        tbb::parallel_for(std::size_t(0), n, [&](std::size_t i)
+        {
+            std::uint16_t q[3];
+            std::memcpy(q, data + layout.positionOffset + i * sizeof(q),
+                sizeof(q));
+            atlas::math::Point p = boxMin + scale *
+                atlas::math::Point(q[0], q[1], q[2]);
+
+            atlas::math::Normal normal(0.0f);
+            if (layout.hasNormals)
+            {
+                std::int16_t e[2];
+                std::memcpy(e, data + layout.normalOffset + i * sizeof(e),
+                    sizeof(e));
+                normal = decodeOctahedral(e);
+            }
+
+            atlas::math::Point2 uv(0.0f);
+            if (layout.hasTexCoords)
+            {
+                std::memcpy(&uv, data + layout.uvOffset + i * sizeof(uv),
+                    sizeof(uv));
+            }
+
+            vertex(i, p, normal, uv);
+        });
+
+        return true;
+    }
+}
 
 namespace atlas
 {
     namespace utils
     {
+        std::string getFormatExtension(MeshFormat format)
+        {
+            switch (format)
+            {
+            case MeshFormat::PLY:
+                return ".ply";
+
+            case MeshFormat::STL:
+                return ".stl";
+
+            case MeshFormat::QMESH:
+                return ".qmesh";
+
+            case MeshFormat::OBJ:
+            default:
+                return ".obj";
+            }
+        }
+
+        MeshFormat getFormatFromFilename(std::string const& filename)
+        {
+            auto dot = filename.find_last_of('.');
+            if (dot == std::string::npos)
+            {
+                return MeshFormat::OBJ;
+            }
+
+            std::string ext = filename.substr(dot);
+            std::transform(ext.begin(), ext.end(), ext.begin(),
+                [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+            if (ext == getFormatExtension(MeshFormat::PLY))
+            {
+                return MeshFormat::PLY;
+            }
+
+            if (ext == getFormatExtension(MeshFormat::STL))
+            {
+                return MeshFormat::STL;
+            }
+
+            if (ext == getFormatExtension(MeshFormat::QMESH))
+            {
+                return MeshFormat::QMESH;
+            }
+
+            return MeshFormat::OBJ;
+        }
+
         Mesh::Mesh()
         { }
 
@@ -21,35 +365,7 @@ namespace atlas
             std::vector<atlas::math::Normal> const& normals,
             std::vector<atlas::math::Point2> const& uvs)
         {
-            struct MeshVertex
-            {
-                bool operator==(MeshVertex const& rhs) const
-                {
-                    return
-                        (vertex == rhs.vertex) &&
-                        (normal == rhs.normal) &&
-                        (uv == rhs.uv);
-                }
-
-                bool operator!=(MeshVertex const& rhs) const
-                {
-                    return !(*this == rhs);
-                }
-
-                math::Point vertex;
-                math::Normal normal;
-                math::Point2 uv;
-                GLuint index;
-            };
-
-            struct MeshVertexHasher
-            {
-                std::size_t operator()(MeshVertex const& mv) const
-                {
-                    return std::hash<float>()(mv.vertex.x + mv.vertex.y + 
-                        mv.vertex.z);
-                }
-            };
+            using std::size_t;
 
             bool hasNormals, hasTextures;
 
@@ -69,219 +385,437 @@ namespace atlas
                 return false;
             }
 
-            std::unordered_set<MeshVertex, MeshVertexHasher> uniqueVertices;
-            std::vector<std::size_t> normalCount;
-            GLuint current = 0;
-            for (auto& idx : indices)
+            // Vertices are welded when their positions, normals and texture
+            // coordinates are bit-for-bit identical, so creases keep their
+            // separate normals.
+            using Key = std::array<std::uint32_t, 8>;
+            auto makeKey = [&](GLuint idx)
             {
-                MeshVertex v;
-                v.vertex = vertices[idx];
-
+                auto floatBits = [](float f)
+                {
+                    // Adding zero turns -0 into +0 so both weld together.
+                    f += 0.0f;
+                    std::uint32_t bits;
+                    std::memcpy(&bits, &f, sizeof(float));
+                    return bits;
+                };
+
+                auto const& v = vertices[idx];
+                Key key = { floatBits(v.x), floatBits(v.y), floatBits(v.z),
+                    0, 0, 0, 0, 0 };
                 if (hasNormals)
                 {
-                    v.normal = normals[idx];
+                    key[3] = floatBits(normals[idx].x);
+                    key[4] = floatBits(normals[idx].y);
+                    key[5] = floatBits(normals[idx].z);
                 }
-
                 if (hasTextures)
                 {
-                    v.uv = uvs[idx];
+                    key[6] = floatBits(uvs[idx].x);
+                    key[7] = floatBits(uvs[idx].y);
                 }
+                return key;
+            };
 
-                // Check if this vertex already exists.
-                if (uniqueVertices.find(v) == uniqueVertices.end())
+            auto hashKey = [](Key const& key)
+            {
+                std::uint64_t h = 0;
+                for (auto k : key)
                 {
-                    // It doesn't, so increase the count and insert.
-                    mesh.indices().push_back(current);
-                    mesh.vertices().push_back(v.vertex);
-                    normalCount.push_back(1);
+                    h ^= k;
+                    h ^= h >> 33;
+                    h *= 0xff51afd7ed558ccdULL;
+                    h ^= h >> 33;
+                    h *= 0xc4ceb9fe1a85ec53ULL;
+                    h ^= h >> 33;
+                }
+                return h;
+            };
 
-                    if (hasNormals)
+            // Every corner is inserted into an open-addressing table shared
+            // by all threads. The slot of each distinct vertex ends up
+            // holding its representative, which is the smallest corner that
+            // uses it. Slots store the corner + 1 so that 0 means empty.
+            size_t numCorners = indices.size();
+            size_t capacity = 1;
+            while (capacity < 2 * numCorners)
+            {
+                capacity <<= 1;
+            }
+            size_t mask = capacity - 1;
+
+            std::vector<std::atomic<std::uint32_t>> slots(capacity);
+            std::vector<std::uint32_t> slotOf(numCorners);
+            tbb::parallel_for(size_t(0), numCorners, [&](size_t i)
+            {
+                auto corner = static_cast<std::uint32_t>(i + 1);
+                auto key = makeKey(indices[i]);
+                auto slot = static_cast<size_t>(hashKey(key)) & mask;
+                for (;; slot = (slot + 1) & mask)
+                {
+                    auto current = slots[slot].load(std::memory_order_relaxed);
+                    if (current == 0 &&
+                        slots[slot].compare_exchange_strong(current, corner))
                     {
-                        mesh.normals().push_back(v.normal);
+                        break;
                     }
 
-                    if (hasTextures)
+                    if (makeKey(indices[current - 1]) != key)
                     {
-                        mesh.texCoords().push_back(v.uv);
+                        continue;
                     }
 
-                    v.index = current;
-                    uniqueVertices.insert(v);
-                    current++;
+                    while (corner < current &&
+                        !slots[slot].compare_exchange_weak(current, corner))
+                    { }
+                    break;
                 }
-                else
+                slotOf[i] = static_cast<std::uint32_t>(slot);
+            });
+
+            // Number the welded vertices in the order in which they are
+            // first used.
+            std::vector<std::uint32_t> representative(numCorners);
+            std::vector<std::uint32_t> newIndex(numCorners);
+            tbb::parallel_for(size_t(0), numCorners, [&](size_t i)
+            {
+                representative[i] = slots[slotOf[i]].load() - 1;
+                newIndex[i] = (representative[i] == i) ? 1 : 0;
+            });
+            size_t numVertices = exclusiveScan(newIndex);
+
+            mesh.mIndices.resize(numCorners);
+            mesh.mVertices.resize(numVertices);
+            mesh.mNormals.resize(hasNormals ? numVertices : 0);
+            mesh.mTexCoords.resize(hasTextures ? numVertices : 0);
+            tbb::parallel_for(size_t(0), numCorners, [&](size_t i)
+            {
+                auto out = newIndex[representative[i]];
+                mesh.mIndices[i] = out;
+
+                if (representative[i] == i)
                 {
-                    // We have already seen this vertex, so grab it's index.
-                    auto uniqueV = *uniqueVertices.find(v);
-                    mesh.indices().push_back(uniqueV.index);
+                    mesh.mVertices[out] = vertices[indices[i]];
 
                     if (hasNormals)
                     {
-                        normalCount[uniqueV.index]++;
-                        auto k = normalCount[uniqueV.index];
-                        auto mK = mesh.normals()[uniqueV.index];
-                        mK = mK + ((v.normal - mK) / (float)k);
-                        mesh.normals()[uniqueV.index] = mK;
+                        mesh.mNormals[out] = normals[indices[i]];
+                    }
+
+                    if (hasTextures)
+                    {
+                        mesh.mTexCoords[out] = uvs[indices[i]];
                     }
                 }
-            }
+            });
 
             return true;
         }
 
-        bool Mesh::fromFile(std::string const& filename, Mesh& mesh, 
-            std::string const& mtl, bool triangulate)
+        bool Mesh::fromFile(std::string const& filename, Mesh& mesh,
+            bool triangulate)
         {
-            tinyobj::attrib_t attrib;
-            std::vector<tinyobj::shape_t> shapes;
-            std::vector<tinyobj::material_t> materials;
-
-            std::string errorString;
-
-            bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials,
-                &errorString, filename.c_str(), mtl.c_str(), triangulate);
+            if (getFormatFromFilename(filename) == MeshFormat::QMESH)
+            {
+                return loadQuantized(filename, mesh);
+            }
 
-            if (!errorString.empty())
+            MappedFile file(filename);
+            if (!file.isOpen())
             {
-                ERROR_LOG(errorString);
+                return false;
             }
 
-            if (!ret)
+            tinyobj_opt::attrib_t attrib;
+            std::vector<tinyobj_opt::shape_t> shapes;
+            std::vector<tinyobj_opt::material_t> materials;
+
+            tinyobj_opt::LoadOption option;
+            option.triangulate = triangulate;
+
+            if (!tinyobj_opt::parseObj(&attrib, &shapes, &materials,
+                file.data(), file.size(), option))
             {
+                ERROR_LOG_V("Could not parse file %s.", filename.c_str());
                 return false;
             }
 
             using std::size_t;
 
-            std::vector<math::Point> vertices;
-            std::vector<math::Normal> normals;
-            std::vector<math::Point2> texCoord;
-            std::vector<GLuint> indices;
+            size_t numVertices = attrib.vertices.size() / 3;
+            size_t numNormals = attrib.normals.size() / 3;
+            size_t numTexCoords = attrib.texcoords.size() / 2;
+            auto const& corners = attrib.indices;
+
+            // Faces that were not triangulated by the loader are split into
+            // fans.
+            std::vector<size_t> faceStart(attrib.face_num_verts.size() + 1, 0);
+            std::vector<size_t> triangleStart(faceStart.size(), 0);
+            for (size_t f = 0; f < attrib.face_num_verts.size(); ++f)
+            {
+                int size = attrib.face_num_verts[f];
+                faceStart[f + 1] = faceStart[f] + size;
+                triangleStart[f + 1] = triangleStart[f] +
+                    ((size > 2) ? size - 2 : 0);
+            }
+
+            auto isValid = [](int idx, size_t count)
+            {
+                return idx >= 0 && static_cast<size_t>(idx) < count;
+            };
 
-            for (auto& shape : shapes)
+            for (auto const& corner : corners)
             {
-                for (auto& index : shape.mesh.indices)
+                if (!isValid(corner.vertex_index, numVertices))
                 {
-                    vertices.emplace_back(
-                        attrib.vertices[3 * index.vertex_index + 0],
-                        attrib.vertices[3 * index.vertex_index + 1],
-                        attrib.vertices[3 * index.vertex_index + 2]
-                    );
+                    ERROR_LOG_V("Invalid vertex index in file %s.",
+                        filename.c_str());
+                    return false;
+                }
+            }
+
+            // Normals and texture coordinates are only kept if every corner
+            // references them.
+            bool hasNormals = numNormals != 0 && std::all_of(corners.begin(),
+                corners.end(), [&](tinyobj_opt::index_t const& corner)
+            {
+                return isValid(corner.normal_index, numNormals);
+            });
 
-                    if (!attrib.normals.empty())
+            bool hasTextures = numTexCoords != 0 && std::all_of(
+                corners.begin(), corners.end(),
+                [&](tinyobj_opt::index_t const& corner)
+            {
+                return isValid(corner.texcoord_index, numTexCoords);
+            });
+
+            // When every attribute of a corner shares the position index
+            // (which is what saveToFile writes) and the arrays have the same
+            // length, they can be used as they are. Otherwise each distinct
+            // combination of indices becomes a vertex.
+            bool sharedIndices =
+                (!hasNormals || numNormals == numVertices) &&
+                (!hasTextures || numTexCoords == numVertices) &&
+                std::all_of(corners.begin(), corners.end(),
+                [&](tinyobj_opt::index_t const& corner)
+            {
+                return (!hasNormals ||
+                    corner.normal_index == corner.vertex_index) &&
+                    (!hasTextures ||
+                    corner.texcoord_index == corner.vertex_index);
+            });
+
+            std::vector<GLuint> cornerIndices(corners.size());
+            size_t numUnique = numVertices;
+            std::vector<tinyobj_opt::index_t> uniqueCorners;
+            if (sharedIndices)
+            {
+                tbb::parallel_for(size_t(0), corners.size(), [&](size_t i)
+                {
+                    cornerIndices[i] =
+                        static_cast<GLuint>(corners[i].vertex_index);
+                });
+            }
+            else
+            {
+                struct CornerKey
+                {
+                    bool operator==(CornerKey const& rhs) const
                     {
-                        normals.emplace_back(
-                            attrib.normals[3 * index.normal_index + 0],
-                            attrib.normals[3 * index.normal_index + 1],
-                            attrib.normals[3 * index.normal_index + 2]
-                        );
+                        return v == rhs.v && n == rhs.n && t == rhs.t;
                     }
 
-                    if (!attrib.texcoords.empty())
+                    int v, n, t;
+                };
+
+                struct CornerKeyHasher
+                {
+                    std::size_t operator()(CornerKey const& key) const
+                    {
+                        std::uint64_t h = static_cast<std::uint32_t>(key.v);
+                        h = h * 0x9e3779b97f4a7c15ULL +
+                            static_cast<std::uint32_t>(key.n);
+                        h = h * 0x9e3779b97f4a7c15ULL +
+                            static_cast<std::uint32_t>(key.t);
+                        h ^= h >> 33;
+                        h *= 0xff51afd7ed558ccdULL;
+                        h ^= h >> 33;
+                        return static_cast<std::size_t>(h);
+                    }
+                };
+
+                std::unordered_map<CornerKey, GLuint, CornerKeyHasher>
+                    uniqueMap;
+                uniqueMap.reserve(numVertices);
+                for (size_t i = 0; i < corners.size(); ++i)
+                {
+                    auto const& corner = corners[i];
+                    CornerKey key = { corner.vertex_index,
+                        hasNormals ? corner.normal_index : -1,
+                        hasTextures ? corner.texcoord_index : -1 };
+
+                    auto entry = uniqueMap.emplace(key,
+                        static_cast<GLuint>(uniqueCorners.size()));
+                    if (entry.second)
                     {
-                        texCoord.emplace_back(
-                            attrib.texcoords[2 * index.texcoord_index + 0],
-                            attrib.texcoords[2 * index.texcoord_index + 1]
-                        );
+                        uniqueCorners.push_back(corner);
                     }
+                    cornerIndices[i] = entry.first->second;
+                }
+
+                numUnique = uniqueCorners.size();
+            }
+
+            mesh.mVertices.resize(numUnique);
+            mesh.mNormals.resize(hasNormals ? numUnique : 0);
+            mesh.mTexCoords.resize(hasTextures ? numUnique : 0);
+            tbb::parallel_for(size_t(0), numUnique, [&](size_t i)
+            {
+                size_t v = i, n = i, t = i;
+                if (!sharedIndices)
+                {
+                    v = uniqueCorners[i].vertex_index;
+                    n = uniqueCorners[i].normal_index;
+                    t = uniqueCorners[i].texcoord_index;
+                }
+
+                mesh.mVertices[i] = math::Point(attrib.vertices[3 * v + 0],
+                    attrib.vertices[3 * v + 1], attrib.vertices[3 * v + 2]);
+
+                if (hasNormals)
+                {
+                    mesh.mNormals[i] = math::Normal(attrib.normals[3 * n + 0],
+                        attrib.normals[3 * n + 1], attrib.normals[3 * n + 2]);
+                }
+
+                if (hasTextures)
+                {
+                    mesh.mTexCoords[i] = math::Point2(
+                        attrib.texcoords[2 * t + 0],
+                        attrib.texcoords[2 * t + 1]);
+                }
+            });
+
+            mesh.mIndices.resize(3 * triangleStart.back());
+            tbb::parallel_for(size_t(0), attrib.face_num_verts.size(),
+                [&](size_t f)
+            {
+                size_t first = faceStart[f];
+                size_t out = 3 * triangleStart[f];
+                for (size_t k = first + 2; k < faceStart[f + 1]; ++k)
+                {
+                    mesh.mIndices[out++] = cornerIndices[first];
+                    mesh.mIndices[out++] = cornerIndices[k - 1];
+                    mesh.mIndices[out++] = cornerIndices[k];
+                }
+            });
+
+            return true;
+        }
+
+        bool Mesh::fromQuantizedFile(std::string const& filename,
+            InterleavedMesh& mesh)
+        {
+            MappedFile file(filename);
+            if (!file.isOpen())
+            {
+                return false;
+            }
+
+            QuantizedHeader header;
+            QuantizedLayout layout;
+            if (!readQuantizedHeader(file, header, layout))
+            {
+                ERROR_LOG_V("Could not parse file %s.", filename.c_str());
+                return false;
+            }
+
+            // The mesh is decoded on the side so that a corrupt file leaves
+            // the given one untouched.
+            InterleavedMesh result;
+            result.hasNormals = layout.hasNormals;
+            result.hasTexCoords = layout.hasTexCoords;
+            std::size_t normalOffset = result.hasNormals ? 3 : 0;
+            std::size_t uvOffset = result.hasTexCoords ?
+                3 + normalOffset : 0;
+            result.stride = 3 + (result.hasNormals ? 3 : 0) +
+                (result.hasTexCoords ? 2 : 0);
+            result.vertexData.resize(layout.numVertices * result.stride);
+
+            auto vertex = [&](std::size_t i, math::Point const& p,
+                math::Normal const& n, math::Point2 const& uv)
+            {
+                float* out = result.vertexData.data() + i * result.stride;
+                std::memcpy(out, &p, sizeof(math::Point));
+                if (normalOffset != 0)
+                {
+                    std::memcpy(out + normalOffset, &n, sizeof(math::Normal));
+                }
+                if (uvOffset != 0)
+                {
+                    std::memcpy(out + uvOffset, &uv, sizeof(math::Point2));
+                }
+            };
+
+            if (!readQuantized(file, header, layout, result.indices, vertex))
+            {
+                ERROR_LOG_V("Could not parse file %s.", filename.c_str());
+                return false;
+            }
+
+            std::swap(mesh, result);
+            return true;
+        }
+
+        bool Mesh::loadQuantized(std::string const& filename, Mesh& mesh)
+        {
+            MappedFile file(filename);
+            if (!file.isOpen())
+            {
+                return false;
+            }
 
+            QuantizedHeader header;
+            QuantizedLayout layout;
+            if (!readQuantizedHeader(file, header, layout))
+            {
+                ERROR_LOG_V("Could not parse file %s.", filename.c_str());
+                return false;
+            }
+
+            std::vector<math::Point> vertices(layout.numVertices);
+            std::vector<math::Normal> normals(
+                layout.hasNormals ? layout.numVertices : 0);
+            std::vector<math::Point2> texCoords(
+                layout.hasTexCoords ? layout.numVertices : 0);
+            std::vector<GLuint> indices;
+
+            auto vertex = [&](std::size_t i, math::Point const& p,
+                math::Normal const& n, math::Point2 const& uv)
+            {
+                vertices[i] = p;
+                if (layout.hasNormals)
+                {
+                    normals[i] = n;
+                }
+                if (layout.hasTexCoords)
+                {
+                    texCoords[i] = uv;
                 }
+            };
+
+            if (!readQuantized(file, header, layout, indices, vertex))
+            {
+                ERROR_LOG_V("Could not parse file %s.", filename.c_str());
+                return false;
             }
 
-            indices.resize(vertices.size());
-            std::iota(indices.begin(), indices.end(), 0);
-
-            return fromTriangleSoup(vertices, indices, mesh, normals, texCoord);
-
-
-            //size_t totalDataCount = 0;
-            //for (size_t s = 0; s < shapes.size(); ++s)
-            //{
-            //    size_t indexOffset = 0;
-            //    size_t numVertices = 0, numNormals = 0, numTex = 0,
-            //        numIndices = 0;
-
-            //    std::vector<GLuint> tmpIndices;
-            //    std::vector<Face> faces;
-            //    for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size();
-            //        ++f)
-            //    {
-            //        size_t fv = shapes[s].mesh.num_face_vertices[f];
-
-
-            //        Face face{ indices.size() + tmpIndices.size(),
-            //        fv, shapes[s].mesh.material_ids[f] };
-            //        face.materialId = (face.materialId == -1) ? 
-            //            0 : face.materialId;
-            //        faces.push_back(face);
-
-            //        for (size_t v = 0; v < fv; ++v)
-            //        {
-            //            tinyobj::index_t index =
-            //                shapes[s].mesh.indices[indexOffset + v];
-
-            //            math::Point vertex;
-            //            vertex.x = attrib.vertices[3 * index.vertex_index + 0];
-            //            vertex.y = attrib.vertices[3 * index.vertex_index + 1];
-            //            vertex.z = attrib.vertices[3 * index.vertex_index + 2];
-
-            //            vertices.push_back(vertex);
-            //            numVertices += 3;
-
-            //            if (!attrib.normals.empty())
-            //            {
-            //                math::Normal nml;
-            //                nml.x = attrib.normals[3 * index.normal_index + 0];
-            //                nml.y = attrib.normals[3 * index.normal_index + 1];
-            //                nml.z = attrib.normals[3 * index.normal_index + 2];
-            //                normals.push_back(nml);
-            //                numNormals += 3;
-            //            }
-
-            //            if (!attrib.texcoords.empty())
-            //            {
-            //                math::Point2 t;
-            //                t.x = attrib.texcoords[2 * index.texcoord_index + 0];
-            //                t.y = attrib.texcoords[2 * index.texcoord_index + 1];
-            //                texCoords.push_back(t);
-            //                numTex += 2;
-            //            }
-
-            //            tmpIndices.push_back((GLuint)tmpIndices.size());
-            //            numIndices++;
-            //        }
-
-            //        indexOffset += fv;
-            //    }
-
-            //    std::vector<Face> uniqueFaces;
-            //    Face firstFace = faces[0];
-            //    for (size_t i = 1; i < faces.size(); ++i)
-            //    {
-            //        if (faces[i].materialId == firstFace.materialId)
-            //        {
-            //            firstFace.size += faces[i].size;
-            //        }
-            //        else
-            //        {
-            //            uniqueFaces.push_back(firstFace);
-            //            firstFace = faces[i];
-            //        }
-
-            //    }
-
-            //    uniqueFaces.push_back(firstFace);
-
-            //    Shape shape{ totalDataCount, uniqueFaces };
-            //    mesh.shapes().push_back(shape);
-            //    mesh.indices().insert(mesh.indices().end(),
-            //        tmpIndices.begin(), tmpIndices.end());
-            //    totalDataCount += numVertices + numNormals + numTex;
-            //}
-
-            //mesh.vertices() = vertices;
-            //mesh.normals() = normals;
-            //mesh.texCoords() = texCoords;
+            mesh.mVertices.swap(vertices);
+            mesh.mNormals.swap(normals);
+            mesh.mTexCoords.swap(texCoords);
+            mesh.mIndices.swap(indices);
+
+            return true;
         }
 
         std::vector<atlas::math::Point>& Mesh::vertices()
@@ -316,65 +850,419 @@ namespace atlas
 
         void Mesh::saveToFile(std::string const& filename)
         {
-            std::fstream file(filename, std::fstream::out);
+            saveToFile(filename, getFormatFromFilename(filename));
+        }
 
-            file << "# number of vertices: " << mVertices.size() << "\n";
+        void Mesh::saveToFile(std::string const& filename, MeshFormat format)
+        {
+            switch (format)
+            {
+            case MeshFormat::PLY:
+                savePly(filename);
+                break;
+
+            case MeshFormat::STL:
+                saveStl(filename);
+                break;
+
+            case MeshFormat::QMESH:
+                saveQuantized(filename);
+                break;
+
+            case MeshFormat::OBJ:
+            default:
+                saveObj(filename);
+                break;
+            }
+        }
 
-            for (std::size_t i = 0; i < mVertices.size(); ++i)
+        void Mesh::saveObj(std::string const& filename)
+        {
+            // The lines are formatted in parallel into independent chunks.
+            // A batch of chunks is formatted at a time and each chunk is
+            // written out in order and freed, so only the batch is held in
+            // memory next to the mesh.
+            constexpr std::size_t chunkSize = 64 * 1024;
+
+            // Upper bounds on the length of each line.
+            constexpr std::size_t maxVertexLine = 4 + 3 * (core::MaxFloatChars
+                + 1);
+            constexpr std::size_t maxFaceLine = 3 + 3 * (3 * core::MaxUIntChars
+                + 3);
+
+            bool hasNormals = !mNormals.empty();
+            bool hasTextures = !mTexCoords.empty();
+            std::size_t numFaces = mIndices.size() / 3;
+            std::size_t numVertexChunks =
+                (mVertices.size() + chunkSize - 1) / chunkSize;
+            std::size_t numFaceChunks = (numFaces + chunkSize - 1) / chunkSize;
+
+            std::size_t numChunks = numVertexChunks + numFaceChunks;
+            std::size_t batchSize = 2 * static_cast<std::size_t>(
+                tbb::this_task_arena::max_concurrency());
+            std::vector<std::string> chunks(std::min(batchSize, numChunks));
+
+            auto writeLine = [](char* out, const char* tag, std::size_t tagSize,
+                const float* values, std::size_t count)
             {
-                auto v = mVertices[i];
-                file << "v " << v.x << " " << v.y << " " << v.z << "\n";
+                std::memcpy(out, tag, tagSize);
+                out += tagSize;
+                for (std::size_t k = 0; k < count; ++k)
+                {
+                    *out++ = ' ';
+                    out = core::formatFloat(values[k], out);
+                }
+                *out++ = '\n';
+                return out;
+            };
+
+            auto writeVertices = [&](std::size_t chunk, std::string& text)
+            {
+                std::size_t begin = chunk * chunkSize;
+                std::size_t end = std::min(begin + chunkSize, mVertices.size());
 
-                if (!mNormals.empty())
+                text.resize((end - begin) * 3 * maxVertexLine);
+                char* start = &text[0];
+                char* out = start;
+                for (std::size_t i = begin; i < end; ++i)
                 {
-                    auto n = mNormals[i];
-                    file << "vn " << n.x << " " << n.y << " " << n.z << "\n";
+                    out = writeLine(out, "v", 1, &mVertices[i].x, 3);
+
+                    if (hasNormals)
+                    {
+                        out = writeLine(out, "vn", 2, &mNormals[i].x, 3);
+                    }
+
+                    if (hasTextures)
+                    {
+                        out = writeLine(out, "vt", 2, &mTexCoords[i].x, 2);
+                    }
                 }
+                text.resize(out - start);
+            };
 
-                if (!mTexCoords.empty())
+            auto writeFaces = [&](std::size_t chunk, std::string& text)
+            {
+                std::size_t begin = chunk * chunkSize;
+                std::size_t end = std::min(begin + chunkSize, numFaces);
+
+                text.resize((end - begin) * maxFaceLine);
+                char* start = &text[0];
+                char* out = start;
+                for (std::size_t i = begin; i < end; ++i)
                 {
-                    auto uv = mTexCoords[i];
-                    file << "vt " << uv.x << " " << uv.y << "\n";
+                    *out++ = 'f';
+                    for (std::size_t k = 0; k < 3; ++k)
+                    {
+                        auto idx = mIndices[3 * i + k] + 1;
+                        *out++ = ' ';
+                        out = core::formatUInt(idx, out);
+
+                        if (hasTextures && hasNormals)
+                        {
+                            *out++ = '/';
+                            out = core::formatUInt(idx, out);
+                            *out++ = '/';
+                            out = core::formatUInt(idx, out);
+                        }
+                        else if (hasTextures)
+                        {
+                            *out++ = '/';
+                            out = core::formatUInt(idx, out);
+                        }
+                        else if (hasNormals)
+                        {
+                            *out++ = '/';
+                            *out++ = '/';
+                            out = core::formatUInt(idx, out);
+                        }
+                    }
+                    *out++ = '\n';
                 }
-            }
+                text.resize(out - start);
+            };
 
-            for (std::size_t i = 0; i < mIndices.size(); i += 3)
+            BlockWriter file(filename);
+            if (!file.isOpen())
             {
-                std::string start = "f ";
-                auto idx1 = mIndices[i + 0] + 1;
-                auto idx2 = mIndices[i + 1] + 1;
-                auto idx3 = mIndices[i + 2] + 1;
+                return;
+            }
+
+            std::string header = "# number of vertices: " +
+                std::to_string(mVertices.size()) + "\n";
+            file.write(header.data(), header.size());
 
+            for (std::size_t first = 0; first < numChunks; first += batchSize)
+            {
+                std::size_t last = std::min(first + batchSize, numChunks);
+                tbb::parallel_for(first, last, [&](std::size_t chunk)
+                {
+                    auto& text = chunks[chunk - first];
+                    if (chunk < numVertexChunks)
+                    {
+                        writeVertices(chunk, text);
+                    }
+                    else
+                    {
+                        writeFaces(chunk - numVertexChunks, text);
+                    }
+                });
 
-                if (mTexCoords.empty() && mNormals.empty())
+                for (std::size_t chunk = first; chunk < last; ++chunk)
                 {
-                    // We only have vertices.
-                    file << start << idx1 << " " << idx2 << " " << idx3 << "\n";
+                    auto& text = chunks[chunk - first];
+                    file.write(text.data(), text.size());
+                    std::string().swap(text);
                 }
-                else if (!mTexCoords.empty() && mNormals.empty())
+            }
+
+            file.close();
+            if (!file.good())
+            {
+                ERROR_LOG_V("Could not write mesh to %s.", filename.c_str());
+            }
+        }
+
+        // Both binary formats are written as little-endian, which matches
+        // the byte order of every platform we build for, so the in-memory
+        // representation of the arrays can be dumped as-is.
+        void Mesh::savePly(std::string const& filename)
+        {
+            BlockWriter file(filename);
+            if (!file.isOpen())
+            {
+                return;
+            }
+
+            bool hasNormals = !mNormals.empty();
+            bool hasTextures = !mTexCoords.empty();
+            std::size_t numFaces = mIndices.size() / 3;
+
+            std::string header = "ply\n";
+            header += "format binary_little_endian 1.0\n";
+            header += "element vertex " + std::to_string(mVertices.size()) +
+                "\n";
+            header += "property float x\n";
+            header += "property float y\n";
+            header += "property float z\n";
+            if (hasNormals)
+            {
+                header += "property float nx\n";
+                header += "property float ny\n";
+                header += "property float nz\n";
+            }
+
+            if (hasTextures)
+            {
+                header += "property float s\n";
+                header += "property float t\n";
+            }
+            header += "element face " + std::to_string(numFaces) + "\n";
+            header += "property list uchar int vertex_indices\n";
+            header += "end_header\n";
+            file.write(header.data(), header.size());
+
+            if (!hasNormals && !hasTextures)
+            {
+                // The vertices are already laid out the way PLY wants them.
+                file.write(mVertices.data(),
+                    mVertices.size() * sizeof(math::Point));
+            }
+            else
+            {
+                float record[8];
+                for (std::size_t i = 0; i < mVertices.size(); ++i)
                 {
-                    // We have textures but not normals.
-                    file << start << idx1 << "/" << idx1 << " ";
-                    file << idx2 << "/" << idx2 << " ";
-                    file << idx3 << "/" << idx3 << "\n";
+                    std::size_t size = 0;
+                    record[size++] = mVertices[i].x;
+                    record[size++] = mVertices[i].y;
+                    record[size++] = mVertices[i].z;
+
+                    if (hasNormals)
+                    {
+                        record[size++] = mNormals[i].x;
+                        record[size++] = mNormals[i].y;
+                        record[size++] = mNormals[i].z;
+                    }
+
+                    if (hasTextures)
+                    {
+                        record[size++] = mTexCoords[i].x;
+                        record[size++] = mTexCoords[i].y;
+                    }
+
+                    file.write(record, size * sizeof(float));
                 }
-                else if (mTexCoords.empty() && !mNormals.empty())
+            }
+
+            // Each face is a count byte followed by the three indices.
+            constexpr std::size_t faceSize = 1 + 3 * sizeof(std::int32_t);
+            char face[faceSize];
+            face[0] = 3;
+            for (std::size_t i = 0; i < numFaces; ++i)
+            {
+                std::memcpy(face + 1, &mIndices[3 * i], 3 * sizeof(GLuint));
+                file.write(face, faceSize);
+            }
+
+            file.close();
+            if (!file.good())
+            {
+                ERROR_LOG_V("Could not write mesh to %s.", filename.c_str());
+            }
+        }
+
+        void Mesh::saveStl(std::string const& filename)
+        {
+            BlockWriter file(filename);
+            if (!file.isOpen())
+            {
+                return;
+            }
+
+            char header[80] = { 0 };
+            std::strncpy(header, "binary STL", sizeof(header));
+            file.write(header, sizeof(header));
+
+            std::uint32_t numFaces =
+                static_cast<std::uint32_t>(mIndices.size() / 3);
+            file.write(numFaces);
+
+            // STL has no shared vertices, so each facet stores its own
+            // normal and copies of its three vertices.
+            constexpr std::size_t facetSize = 12 * sizeof(float) +
+                sizeof(std::uint16_t);
+            char facet[facetSize] = { 0 };
+            for (std::size_t i = 0; i < numFaces; ++i)
+            {
+                auto const& p0 = mVertices[mIndices[3 * i + 0]];
+                auto const& p1 = mVertices[mIndices[3 * i + 1]];
+                auto const& p2 = mVertices[mIndices[3 * i + 2]];
+
+                auto n = glm::cross(p1 - p0, p2 - p0);
+                float length = glm::length(n);
+                n = (length > 0.0f) ? n / length : math::Normal(0.0f);
+
+                std::memcpy(facet + 0 * sizeof(math::Point), &n,
+                    sizeof(math::Point));
+                std::memcpy(facet + 1 * sizeof(math::Point), &p0,
+                    sizeof(math::Point));
+                std::memcpy(facet + 2 * sizeof(math::Point), &p1,
+                    sizeof(math::Point));
+                std::memcpy(facet + 3 * sizeof(math::Point), &p2,
+                    sizeof(math::Point));
+                file.write(facet, facetSize);
+            }
+
+            file.close();
+            if (!file.good())
+            {
+                ERROR_LOG_V("Could not write mesh to %s.", filename.c_str());
+            }
+        }
+
+        // Positions are stored as 16-bit offsets inside the bounding box of
+        // the mesh and normals as 16-bit octahedral coordinates, which only
+        // keeps their direction. The mesh is first put in vertex cache order
+        // with the vertices in first-use order, so most index deltas fit in
+        // one or two bytes.
+        void Mesh::saveQuantized(std::string const& filename)
+        {
+            BlockWriter file(filename);
+            if (!file.isOpen())
+            {
+                return;
+            }
+
+            Mesh mesh;
+            mesh.mVertices = mVertices;
+            mesh.mNormals = mNormals;
+            mesh.mTexCoords = mTexCoords;
+            mesh.mIndices = mIndices;
+            optimizeVertexCache(mesh);
+            optimizeVertexFetch(mesh);
+
+            bool hasNormals = mesh.mNormals.size() == mesh.mVertices.size();
+            bool hasTextures = mesh.mTexCoords.size() == mesh.mVertices.size();
+            std::size_t numVertices = mesh.mVertices.size();
+
+            BBox box;
+            for (auto const& v : mesh.mVertices)
+            {
+                box = join(box, BBox(v));
+            }
+            if (numVertices == 0)
+            {
+                box = BBox(math::Point(0.0f));
+            }
+
+            std::vector<std::uint16_t> positions(numVertices * 3);
+            std::vector<std::int16_t> normals(hasNormals ? numVertices * 2 : 0);
+            auto extent = box.pMax - box.pMin;
+            tbb::parallel_for(std::size_t(0), numVertices, [&](std::size_t i)
+            {
+                for (int axis = 0; axis < 3; ++axis)
                 {
-                    // We have normals but not textures.
-                    file << start << idx1 << "//" << idx1 << " ";
-                    file << idx2 << "//" << idx2 << " ";
-                    file << idx3 << "//" << idx3 << "\n";
+                    float u = (extent[axis] > 0.0f) ?
+                        (mesh.mVertices[i][axis] - box.pMin[axis]) /
+                        extent[axis] : 0.0f;
+                    positions[3 * i + axis] = static_cast<std::uint16_t>(
+                        std::round(glm::clamp(u, 0.0f, 1.0f) *
+                            QuantizedPositionScale));
                 }
-                else
+
+                if (hasNormals)
                 {
-                    // We have normals and textures.
-                    file << start << idx1 << "/" << idx1 << "/" << idx1 << " ";
-                    file << idx2 << "/" << idx2 << "/" << idx2 << " ";
-                    file << idx3 << "/" << idx3 << "/" << idx3 << "\n";
+                    encodeOctahedral(mesh.mNormals[i], &normals[2 * i]);
                 }
+            });
+
+            std::vector<char> indexStream(mesh.mIndices.size() * 5);
+            char* out = indexStream.data();
+            std::uint32_t previous = 0;
+            for (auto index : mesh.mIndices)
+            {
+                std::uint32_t delta = index - previous;
+                std::uint32_t zigzag = (delta << 1) ^
+                    (0u - (delta >> 31));
+                out = writeVarint(zigzag, out);
+                previous = index;
+            }
+            indexStream.resize(out - indexStream.data());
+
+            QuantizedHeader header;
+            std::memset(&header, 0, sizeof(QuantizedHeader));
+            std::memcpy(header.magic, QuantizedMagic, 4);
+            header.version = QuantizedVersion;
+            header.flags = (hasNormals ? QuantizedHasNormals : 0) |
+                (hasTextures ? QuantizedHasTexCoords : 0);
+            header.numVertices = static_cast<std::uint32_t>(numVertices);
+            header.numIndices = static_cast<std::uint32_t>(
+                mesh.mIndices.size());
+            header.indexBytes = indexStream.size();
+            std::memcpy(header.boxMin, &box.pMin, sizeof(header.boxMin));
+            std::memcpy(header.boxMax, &box.pMax, sizeof(header.boxMax));
+
+            file.write(&header, sizeof(QuantizedHeader));
+            file.write(positions.data(),
+                positions.size() * sizeof(std::uint16_t));
+            if (hasNormals)
+            {
+                file.write(normals.data(),
+                    normals.size() * sizeof(std::int16_t));
+            }
+            if (hasTextures)
+            {
+                file.write(mesh.mTexCoords.data(),
+                    mesh.mTexCoords.size() * sizeof(math::Point2));
             }
+            file.write(indexStream.data(), indexStream.size());
 
             file.close();
+            if (!file.good())
+            {
+                ERROR_LOG_V("Could not write mesh to %s.", filename.c_str());
+            }
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,356 @@
+#include "atlas/utils/MeshOptimizer.hpp"
+#include "atlas/core/Log.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+namespace
+{
+    // Tuning constants from the original description of the algorithm.
+    constexpr float CacheDecayPower = 1.5f;
+    constexpr float LastTriangleScore = 0.75f;
+    constexpr float ValenceBoostScale = 2.0f;
+    constexpr float ValenceBoostPower = 0.5f;
+    constexpr std::size_t MaxValenceScore = 32;
+
+    class VertexScore
+    {
+    public:
+        VertexScore(std::size_t cacheSize) :
+            mCacheScores(cacheSize),
+            mValenceScores(MaxValenceScore)
+        {
+            for (std::size_t i = 0; i < cacheSize; ++i)
+            {
+                mCacheScores[i] = (i < 3) ? LastTriangleScore :
+                    std::pow(1.0f - static_cast<float>(i - 3) /
+                        static_cast<float>(cacheSize - 3), CacheDecayPower);
+            }
+
+            for (std::size_t i = 1; i < MaxValenceScore; ++i)
+            {
+                mValenceScores[i] = valenceScore(i);
+            }
+        }
+
+        // Vertices that are not in the cache have a position of -1.
+        float operator()(int cachePosition, std::uint32_t valence) const
+        {
+            if (valence == 0)
+            {
+                return -1.0f;
+            }
+
+            float score = (cachePosition < 0) ? 0.0f :
+                mCacheScores[cachePosition];
+            score += (valence < MaxValenceScore) ? mValenceScores[valence] :
+                valenceScore(valence);
+            return score;
+        }
+
+    private:
+        static float valenceScore(std::size_t valence)
+        {
+            return ValenceBoostScale *
+                std::pow(static_cast<float>(valence), -ValenceBoostPower);
+        }
+
+        std::vector<float> mCacheScores;
+        std::vector<float> mValenceScores;
+    };
+
+    std::size_t countVertices(std::vector<GLuint> const& indices)
+    {
+        if (indices.empty())
+        {
+            return 0;
+        }
+
+        return static_cast<std::size_t>(
+            *std::max_element(indices.begin(), indices.end())) + 1;
+    }
+
+    // Forsyth's algorithm on a single triangle list.
+    void reorderTriangles(std::vector<GLuint>& indices, std::size_t cacheSize)
+    {
+        std::size_t numTriangles = indices.size() / 3;
+        if (numTriangles == 0)
+        {
+            return;
+        }
+
+        cacheSize = std::max(cacheSize, static_cast<std::size_t>(4));
+        std::size_t numVertices = countVertices(indices);
+        VertexScore score(cacheSize);
+
+        // Build the list of triangles that use each vertex. The live
+        // part of each list shrinks as triangles are emitted.
+        std::vector<std::uint32_t> valence(numVertices, 0);
+        for (std::size_t i = 0; i < numTriangles * 3; ++i)
+        {
+            valence[indices[i]]++;
+        }
+
+        std::vector<std::size_t> offsets(numVertices + 1, 0);
+        for (std::size_t v = 0; v < numVertices; ++v)
+        {
+            offsets[v + 1] = offsets[v] + valence[v];
+        }
+
+        std::vector<std::uint32_t> adjacency(numTriangles * 3);
+        {
+            std::vector<std::size_t> cursor(offsets.begin(),
+                offsets.end() - 1);
+            for (std::size_t i = 0; i < numTriangles * 3; ++i)
+            {
+                adjacency[cursor[indices[i]]++] =
+                    static_cast<std::uint32_t>(i / 3);
+            }
+        }
+
+        std::vector<int> cachePosition(numVertices, -1);
+        std::vector<float> vertexScores(numVertices);
+        for (std::size_t v = 0; v < numVertices; ++v)
+        {
+            vertexScores[v] = score(-1, valence[v]);
+        }
+
+        std::vector<float> triangleScores(numTriangles);
+        for (std::size_t t = 0; t < numTriangles; ++t)
+        {
+            triangleScores[t] = vertexScores[indices[3 * t + 0]] +
+                vertexScores[indices[3 * t + 1]] +
+                vertexScores[indices[3 * t + 2]];
+        }
+
+        constexpr auto none = std::numeric_limits<std::size_t>::max();
+        std::vector<char> emitted(numTriangles, 0);
+        std::vector<std::uint32_t> cache, newCache;
+        cache.reserve(cacheSize + 3);
+        newCache.reserve(cacheSize + 3);
+
+        std::vector<GLuint> output;
+        output.reserve(numTriangles * 3);
+
+        std::size_t best = none;
+        std::size_t cursor = 0;
+        for (std::size_t count = 0; count < numTriangles; ++count)
+        {
+            // When none of the cached vertices have triangles left, carry
+            // on from the first triangle that has not been emitted.
+            if (best == none)
+            {
+                while (emitted[cursor])
+                {
+                    ++cursor;
+                }
+                best = cursor;
+            }
+
+            emitted[best] = 1;
+            newCache.clear();
+            for (std::size_t k = 0; k < 3; ++k)
+            {
+                auto v = indices[3 * best + k];
+                output.push_back(v);
+
+                auto begin = adjacency.begin() + offsets[v];
+                auto end = begin + valence[v];
+                std::iter_swap(std::find(begin, end, best), end - 1);
+                valence[v]--;
+
+                if (std::find(newCache.begin(), newCache.end(), v) ==
+                    newCache.end())
+                {
+                    newCache.push_back(v);
+                }
+            }
+
+            // The rest of the cache moves back behind the new triangle.
+            std::size_t fresh = newCache.size();
+            for (auto v : cache)
+            {
+                auto last = newCache.begin() + fresh;
+                if (std::find(newCache.begin(), last, v) == last)
+                {
+                    newCache.push_back(v);
+                }
+            }
+
+            // Update the scores of everything that moved in the cache,
+            // including the vertices that were pushed out of it.
+            for (std::size_t i = 0; i < newCache.size(); ++i)
+            {
+                auto v = newCache[i];
+                cachePosition[v] =
+                    (i < cacheSize) ? static_cast<int>(i) : -1;
+
+                float newScore = score(cachePosition[v], valence[v]);
+                float delta = newScore - vertexScores[v];
+                vertexScores[v] = newScore;
+
+                for (std::size_t a = offsets[v];
+                    a < offsets[v] + valence[v]; ++a)
+                {
+                    triangleScores[adjacency[a]] += delta;
+                }
+            }
+
+            if (newCache.size() > cacheSize)
+            {
+                newCache.resize(cacheSize);
+            }
+            cache.swap(newCache);
+
+            best = none;
+            float bestScore = -std::numeric_limits<float>::max();
+            for (auto v : cache)
+            {
+                for (std::size_t a = offsets[v];
+                    a < offsets[v] + valence[v]; ++a)
+                {
+                    auto t = adjacency[a];
+                    if (triangleScores[t] > bestScore)
+                    {
+                        bestScore = triangleScores[t];
+                        best = t;
+                    }
+                }
+            }
+        }
+
+        indices.swap(output);
+    }
+}
+
+namespace atlas
+{
+    namespace utils
+    {
+        float computeACMR(std::vector<GLuint> const& indices,
+            std::size_t cacheSize)
+        {
+            std::size_t numTriangles = indices.size() / 3;
+            if (numTriangles == 0 || cacheSize == 0)
+            {
+                return 0.0f;
+            }
+
+            // A vertex is in the FIFO if fewer than cacheSize vertices have
+            // been inserted since it was.
+            std::vector<std::size_t> insertTime(countVertices(indices), 0);
+            std::size_t time = cacheSize + 1;
+            std::size_t misses = 0;
+            for (auto index : indices)
+            {
+                if (time - insertTime[index] > cacheSize)
+                {
+                    insertTime[index] = time++;
+                    ++misses;
+                }
+            }
+
+            return static_cast<float>(misses) /
+                static_cast<float>(numTriangles);
+        }
+
+        void optimizeVertexCache(Mesh& mesh, std::size_t cacheSize)
+        {
+            reorderTriangles(mesh.indices(), cacheSize);
+        }
+
+        void optimizeVertexCache(Mesh& mesh,
+            std::vector<std::size_t> const& ranges, std::size_t cacheSize)
+        {
+            auto& indices = mesh.indices();
+            std::vector<GLuint> vertices, local;
+            for (std::size_t r = 0; r < ranges.size(); ++r)
+            {
+                std::size_t begin = ranges[r];
+                std::size_t end = (r + 1 < ranges.size()) ? ranges[r + 1] :
+                    indices.size();
+                if (begin >= end || end > indices.size() ||
+                    (end - begin) % 3 != 0)
+                {
+                    ERROR_LOG("Cannot reorder triangles in an invalid range.");
+                    return;
+                }
+
+                // The range is renumbered from 0 so the work only depends on
+                // its own size.
+                vertices.assign(indices.begin() + begin,
+                    indices.begin() + end);
+                std::sort(vertices.begin(), vertices.end());
+                vertices.erase(std::unique(vertices.begin(), vertices.end()),
+                    vertices.end());
+
+                local.resize(end - begin);
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    local[i - begin] = static_cast<GLuint>(
+                        std::lower_bound(vertices.begin(), vertices.end(),
+                            indices[i]) - vertices.begin());
+                }
+
+                reorderTriangles(local, cacheSize);
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    indices[i] = vertices[local[i - begin]];
+                }
+            }
+        }
+
+        void optimizeVertexFetch(Mesh& mesh)
+        {
+            auto& indices = mesh.indices();
+            std::size_t numVertices = mesh.vertices().size();
+            if (countVertices(indices) > numVertices)
+            {
+                ERROR_LOG("Cannot reorder mesh with out of range indices.");
+                return;
+            }
+
+            constexpr auto unused = std::numeric_limits<GLuint>::max();
+            std::vector<GLuint> remap(numVertices, unused);
+            GLuint next = 0;
+            for (auto& index : indices)
+            {
+                if (remap[index] == unused)
+                {
+                    remap[index] = next++;
+                }
+                index = remap[index];
+            }
+
+            for (auto& entry : remap)
+            {
+                if (entry == unused)
+                {
+                    entry = next++;
+                }
+            }
+
+            auto permute = [&remap](auto& data)
+            {
+                if (data.size() != remap.size())
+                {
+                    return;
+                }
+
+                std::remove_reference_t<decltype(data)> result(data.size());
+                for (std::size_t i = 0; i < data.size(); ++i)
+                {
+                    result[remap[i]] = data[i];
+                }
+                data.swap(result);
+            };
+
+            permute(mesh.vertices());
+            permute(mesh.normals());
+            permute(mesh.texCoords());
+        }
+    }
+}
@@ -0,0 +1,790 @@
+#include "atlas/utils/MeshSimplifier.hpp"
+#include "atlas/utils/MeshOptimizer.hpp"
+#include "atlas/utils/BBox.hpp"
+#include "atlas/core/Log.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+
+#include <tbb/parallel_for.h>
+
+namespace
+{
+    using atlas::math::Point;
+    using atlas::math::Normal;
+
+    // A symmetric 4x4 matrix that measures the sum of squared distances to
+    // a set of planes.
+    struct Quadric
+    {
+        Quadric()
+        {
+            std::fill(std::begin(a), std::end(a), 0.0);
+        }
+
+        Quadric(Normal const& n, float d)
+        {
+            double x = n.x, y = n.y, z = n.z, w = d;
+            a[0] = x * x; a[1] = x * y; a[2] = x * z; a[3] = x * w;
+            a[4] = y * y; a[5] = y * z; a[6] = y * w;
+            a[7] = z * z; a[8] = z * w;
+            a[9] = w * w;
+        }
+
+        Quadric& operator+=(Quadric const& q)
+        {
+            for (std::size_t i = 0; i < 10; ++i)
+            {
+                a[i] += q.a[i];
+            }
+            return *this;
+        }
+
+        double error(Point const& p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double e =
+                a[0] * x * x + 2.0 * a[1] * x * y + 2.0 * a[2] * x * z +
+                a[4] * y * y + 2.0 * a[5] * y * z + a[7] * z * z +
+                2.0 * (a[3] * x + a[6] * y + a[8] * z) + a[9];
+            return std::max(e, 0.0);
+        }
+
+        // Finds the point with the smallest error, if it is well defined.
+        bool minimum(Point& p) const
+        {
+            double det =
+                a[0] * (a[4] * a[7] - a[5] * a[5]) -
+                a[1] * (a[1] * a[7] - a[5] * a[2]) +
+                a[2] * (a[1] * a[5] - a[4] * a[2]);
+            if (std::abs(det) < 1e-12)
+            {
+                return false;
+            }
+
+            double bx = -a[3], by = -a[6], bz = -a[8];
+            double x =
+                bx * (a[4] * a[7] - a[5] * a[5]) -
+                a[1] * (by * a[7] - a[5] * bz) +
+                a[2] * (by * a[5] - a[4] * bz);
+            double y =
+                a[0] * (by * a[7] - bz * a[5]) -
+                bx * (a[1] * a[7] - a[5] * a[2]) +
+                a[2] * (a[1] * bz - by * a[2]);
+            double z =
+                a[0] * (a[4] * bz - a[5] * by) -
+                a[1] * (a[1] * bz - by * a[2]) +
+                bx * (a[1] * a[5] - a[4] * a[2]);
+            p = Point(x / det, y / det, z / det);
+            return true;
+        }
+
+        double a[10];
+    };
+
+    struct Collapse
+    {
+        bool operator>(Collapse const& rhs) const
+        {
+            return cost > rhs.cost;
+        }
+
+        double cost;
+        std::uint32_t from, to;
+        std::uint32_t fromStamp, toStamp;
+        Point position;
+    };
+
+    std::uint64_t edgeKey(GLuint a, GLuint b)
+    {
+        return (static_cast<std::uint64_t>(std::min(a, b)) << 32) |
+            std::max(a, b);
+    }
+}
+
+namespace atlas
+{
+    namespace utils
+    {
+        SimplifyStats::SimplifyStats() :
+            inputTriangles(0),
+            triangles(0),
+            targetTriangles(0),
+            lockedEdges(0),
+            linkRejections(0),
+            borderRejections(0),
+            flipRejections(0),
+            errorBound(false),
+            exhausted(false)
+        { }
+
+        SimplifyStats& SimplifyStats::operator+=(SimplifyStats const& rhs)
+        {
+            inputTriangles += rhs.inputTriangles;
+            triangles += rhs.triangles;
+            targetTriangles += rhs.targetTriangles;
+            lockedEdges += rhs.lockedEdges;
+            linkRejections += rhs.linkRejections;
+            borderRejections += rhs.borderRejections;
+            flipRejections += rhs.flipRejections;
+            errorBound = errorBound || rhs.errorBound;
+            exhausted = exhausted || rhs.exhausted;
+            return *this;
+        }
+
+        void logSimplifyStats(SimplifyStats const& stats)
+        {
+            // Summed over chunks, some may stop short while the total still
+            // reaches the target.
+            if ((!stats.errorBound && !stats.exhausted) ||
+                stats.triangles <= stats.targetTriangles)
+            {
+                INFO_LOG_V("Simplified mesh from %zu to %zu triangles.",
+                    stats.inputTriangles, stats.triangles);
+                return;
+            }
+
+            WARN_LOG_V("Simplified mesh from %zu to %zu triangles, short " \
+                "of the target of %zu. %s; rejected collapses: %zu by the " \
+                "link condition, %zu across the border, %zu by flips; %zu " \
+                "edges locked on the border.", stats.inputTriangles,
+                stats.triangles, stats.targetTriangles,
+                stats.errorBound ? "Reached the error bound" :
+                "Ran out of collapses", stats.linkRejections,
+                stats.borderRejections, stats.flipRejections,
+                stats.lockedEdges);
+        }
+
+        std::vector<bool> findBorderVertices(
+            std::vector<GLuint> const& indices, std::size_t numVertices)
+        {
+            std::vector<std::uint64_t> edges;
+            edges.reserve(indices.size());
+            for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+            {
+                for (std::size_t k = 0; k < 3; ++k)
+                {
+                    edges.push_back(edgeKey(indices[i + k],
+                        indices[i + (k + 1) % 3]));
+                }
+            }
+            std::sort(edges.begin(), edges.end());
+
+            std::vector<bool> border(numVertices, false);
+            for (std::size_t i = 0; i < edges.size();)
+            {
+                std::size_t j = i + 1;
+                while (j < edges.size() && edges[j] == edges[i])
+                {
+                    ++j;
+                }
+
+                if (j - i != 2)
+                {
+                    border[edges[i] >> 32] = true;
+                    border[edges[i] & 0xFFFFFFFF] = true;
+                }
+                i = j;
+            }
+
+            return border;
+        }
+
+        std::size_t simplifyTriangles(std::vector<math::Point>& vertices,
+            std::vector<math::Normal>& normals, std::vector<GLuint>& indices,
+            std::size_t targetTriangles, float maxError, SimplifyStats* stats)
+        {
+            std::size_t numVertices = vertices.size();
+            std::size_t numTriangles = indices.size() / 3;
+
+            SimplifyStats result;
+            result.inputTriangles = numTriangles;
+            result.triangles = numTriangles;
+            result.targetTriangles = targetTriangles;
+            if (numTriangles <= targetTriangles)
+            {
+                if (stats)
+                {
+                    *stats = result;
+                }
+                return numTriangles;
+            }
+
+            auto locked = findBorderVertices(indices, numVertices);
+            // Costs are sums of squared distances, so the limit is squared.
+            double maxCost = static_cast<double>(maxError) * maxError;
+
+            std::vector<Quadric> quadrics(numVertices);
+            std::vector<std::vector<std::uint32_t>> vertexTriangles(
+                numVertices);
+            std::vector<char> dead(numTriangles, 0);
+            std::size_t liveTriangles = numTriangles;
+
+            for (std::size_t t = 0; t < numTriangles; ++t)
+            {
+                auto a = indices[3 * t + 0];
+                auto b = indices[3 * t + 1];
+                auto c = indices[3 * t + 2];
+                if (a == b || b == c || c == a)
+                {
+                    dead[t] = 1;
+                    --liveTriangles;
+                    continue;
+                }
+
+                auto n = glm::cross(vertices[b] - vertices[a],
+                    vertices[c] - vertices[a]);
+                float length = glm::length(n);
+                if (length > 0.0f)
+                {
+                    n /= length;
+                    Quadric q(n, -glm::dot(n, vertices[a]));
+                    quadrics[a] += q;
+                    quadrics[b] += q;
+                    quadrics[c] += q;
+                }
+
+                vertexTriangles[a].push_back(static_cast<std::uint32_t>(t));
+                vertexTriangles[b].push_back(static_cast<std::uint32_t>(t));
+                vertexTriangles[c].push_back(static_cast<std::uint32_t>(t));
+            }
+
+            std::vector<std::uint32_t> stamps(numVertices, 0);
+            std::vector<char> removed(numVertices, 0);
+            std::priority_queue<Collapse, std::vector<Collapse>,
+                std::greater<Collapse>> heap;
+
+            auto pushCollapse = [&](std::uint32_t a, std::uint32_t b)
+            {
+                if (locked[a] && locked[b])
+                {
+                    ++result.lockedEdges;
+                    return;
+                }
+
+                Quadric q = quadrics[a];
+                q += quadrics[b];
+
+                // A border vertex can only absorb its neighbour in place.
+                Collapse c;
+                if (locked[a] || locked[b])
+                {
+                    c.to = locked[a] ? a : b;
+                    c.from = locked[a] ? b : a;
+                    c.position = vertices[c.to];
+                    c.cost = q.error(c.position);
+                }
+                else
+                {
+                    Point const& pa = vertices[a];
+                    Point const& pb = vertices[b];
+                    c.from = a;
+                    c.to = b;
+                    c.position = pb;
+                    c.cost = q.error(pb);
+
+                    Point candidates[2] = { pa, 0.5f * (pa + pb) };
+                    Point optimal;
+                    if (q.minimum(optimal) && glm::distance(optimal,
+                        candidates[1]) <= glm::distance(pa, pb))
+                    {
+                        candidates[1] = optimal;
+                    }
+
+                    for (std::size_t i = 0; i < 2; ++i)
+                    {
+                        double cost = q.error(candidates[i]);
+                        if (cost < c.cost)
+                        {
+                            c.cost = cost;
+                            c.position = candidates[i];
+                        }
+                    }
+                }
+
+                c.fromStamp = stamps[c.from];
+                c.toStamp = stamps[c.to];
+                heap.push(c);
+            };
+
+            // Every interior edge goes from the smaller to the larger index
+            // in exactly one of its two triangles.
+            for (std::size_t t = 0; t < numTriangles; ++t)
+            {
+                if (dead[t])
+                {
+                    continue;
+                }
+
+                for (std::size_t k = 0; k < 3; ++k)
+                {
+                    auto a = indices[3 * t + k];
+                    auto b = indices[3 * t + (k + 1) % 3];
+                    if (a < b)
+                    {
+                        pushCollapse(a, b);
+                    }
+                }
+            }
+
+            auto gatherNeighbours = [&](std::uint32_t v,
+                std::vector<std::uint32_t>& neighbours)
+            {
+                neighbours.clear();
+                for (auto t : vertexTriangles[v])
+                {
+                    for (std::size_t k = 0; !dead[t] && k < 3; ++k)
+                    {
+                        auto w = indices[3 * t + k];
+                        if (w != v)
+                        {
+                            neighbours.push_back(w);
+                        }
+                    }
+                }
+                std::sort(neighbours.begin(), neighbours.end());
+                neighbours.erase(std::unique(neighbours.begin(),
+                    neighbours.end()), neighbours.end());
+            };
+
+            // Moving a vertex must not flip or squash any triangle that
+            // survives the collapse.
+            auto keepsOrientation = [&](std::uint32_t v, std::uint32_t other,
+                Point const& position)
+            {
+                for (auto t : vertexTriangles[v])
+                {
+                    if (dead[t])
+                    {
+                        continue;
+                    }
+
+                    Point p[3];
+                    bool shared = false;
+                    for (std::size_t k = 0; k < 3; ++k)
+                    {
+                        auto w = indices[3 * t + k];
+                        shared = shared || (w == other);
+                        p[k] = vertices[w];
+                    }
+
+                    if (shared)
+                    {
+                        continue;
+                    }
+
+                    auto before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    if (glm::length(before) == 0.0f)
+                    {
+                        continue;
+                    }
+
+                    for (std::size_t k = 0; k < 3; ++k)
+                    {
+                        if (indices[3 * t + k] == v)
+                        {
+                            p[k] = position;
+                        }
+                    }
+                    auto after = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+                    if (glm::dot(before, after) <=
+                        0.05f * glm::length(before) * glm::length(after))
+                    {
+                        return false;
+                    }
+                }
+
+                return true;
+            };
+
+            std::vector<std::uint32_t> fromNeighbours, toNeighbours;
+            while (liveTriangles > targetTriangles && !heap.empty())
+            {
+                Collapse c = heap.top();
+                heap.pop();
+
+                if (c.cost > maxCost)
+                {
+                    result.errorBound = true;
+                    break;
+                }
+
+                if (removed[c.from] || removed[c.to] ||
+                    stamps[c.from] != c.fromStamp ||
+                    stamps[c.to] != c.toStamp)
+                {
+                    continue;
+                }
+
+                // The link condition keeps the surface manifold: the only
+                // vertices both ends share are the ones across the triangles
+                // on the edge.
+                gatherNeighbours(c.from, fromNeighbours);
+                gatherNeighbours(c.to, toNeighbours);
+                std::size_t sharedTriangles = 0;
+                for (auto t : vertexTriangles[c.from])
+                {
+                    if (!dead[t] && (indices[3 * t + 0] == c.to ||
+                        indices[3 * t + 1] == c.to ||
+                        indices[3 * t + 2] == c.to))
+                    {
+                        ++sharedTriangles;
+                    }
+                }
+
+                std::size_t common = 0;
+                for (std::size_t i = 0, j = 0; i < fromNeighbours.size() &&
+                    j < toNeighbours.size();)
+                {
+                    if (fromNeighbours[i] < toNeighbours[j])
+                    {
+                        ++i;
+                    }
+                    else if (toNeighbours[j] < fromNeighbours[i])
+                    {
+                        ++j;
+                    }
+                    else
+                    {
+                        ++common;
+                        ++i;
+                        ++j;
+                    }
+                }
+
+                if (sharedTriangles == 0 || common != sharedTriangles)
+                {
+                    ++result.linkRejections;
+                    continue;
+                }
+
+                // Joining two border vertices with a new edge would fold the
+                // piece over its own border.
+                bool bridgesBorder = false;
+                for (auto w : fromNeighbours)
+                {
+                    bridgesBorder = bridgesBorder || (locked[c.to] &&
+                        locked[w] && w != c.to && !std::binary_search(
+                            toNeighbours.begin(), toNeighbours.end(), w));
+                }
+
+                if (bridgesBorder)
+                {
+                    ++result.borderRejections;
+                    continue;
+                }
+
+                if (!keepsOrientation(c.from, c.to, c.position) ||
+                    !keepsOrientation(c.to, c.from, c.position))
+                {
+                    ++result.flipRejections;
+                    continue;
+                }
+
+                // Collapse the edge onto the kept vertex.
+                for (auto t : vertexTriangles[c.from])
+                {
+                    if (dead[t])
+                    {
+                        continue;
+                    }
+
+                    bool shared = false;
+                    for (std::size_t k = 0; k < 3; ++k)
+                    {
+                        shared = shared || (indices[3 * t + k] == c.to);
+                    }
+
+                    if (shared)
+                    {
+                        dead[t] = 1;
+                        --liveTriangles;
+                        continue;
+                    }
+
+                    for (std::size_t k = 0; k < 3; ++k)
+                    {
+                        if (indices[3 * t + k] == c.from)
+                        {
+                            indices[3 * t + k] = c.to;
+                        }
+                    }
+                    vertexTriangles[c.to].push_back(t);
+                }
+
+                auto& toTriangles = vertexTriangles[c.to];
+                toTriangles.erase(std::remove_if(toTriangles.begin(),
+                    toTriangles.end(), [&dead](std::uint32_t t)
+                {
+                    return dead[t] != 0;
+                }), toTriangles.end());
+                vertexTriangles[c.from].clear();
+                vertexTriangles[c.from].shrink_to_fit();
+
+                vertices[c.to] = c.position;
+                quadrics[c.to] += quadrics[c.from];
+                if (!locked[c.to] && normals.size() == numVertices)
+                {
+                    auto n = normals[c.to] + normals[c.from];
+                    float length = glm::length(n);
+                    normals[c.to] = (length > 0.0f) ? n / length :
+                        normals[c.to];
+                }
+
+                removed[c.from] = 1;
+                stamps[c.to]++;
+
+                gatherNeighbours(c.to, toNeighbours);
+                for (auto w : toNeighbours)
+                {
+                    pushCollapse(c.to, w);
+                }
+            }
+
+            std::vector<GLuint> live;
+            live.reserve(liveTriangles * 3);
+            for (std::size_t t = 0; t < numTriangles; ++t)
+            {
+                if (!dead[t])
+                {
+                    live.insert(live.end(), indices.begin() + 3 * t,
+                        indices.begin() + 3 * t + 3);
+                }
+            }
+            indices.swap(live);
+
+            result.triangles = liveTriangles;
+            result.exhausted = !result.errorBound &&
+                liveTriangles > targetTriangles;
+            if (stats)
+            {
+                *stats = result;
+            }
+            return liveTriangles;
+        }
+
+        // One parallel pass of simplifyMesh over a grid of cells, optionally
+        // shifted by half a cell.
+        static SimplifyStats simplifyCells(Mesh& mesh,
+            std::size_t targetTriangles, float maxError,
+            std::size_t partitions, bool shifted)
+        {
+            auto& vertices = mesh.vertices();
+            auto& normals = mesh.normals();
+            auto& indices = mesh.indices();
+
+            std::size_t numTriangles = indices.size() / 3;
+            bool hasNormals = normals.size() == vertices.size();
+
+            BBox box;
+            for (auto const& v : vertices)
+            {
+                box = join(box, BBox(v));
+            }
+            auto extent = box.pMax - box.pMin;
+
+            // Bin the triangles into cells by their centroid. The shifted grid
+            // has one more cell along each axis, so its cells are centred on
+            // the corners of the unshifted one.
+            std::size_t cellsPerAxis = partitions + (shifted ? 1 : 0);
+            float offset = shifted ? 0.5f : 0.0f;
+            std::size_t numCells = cellsPerAxis * cellsPerAxis * cellsPerAxis;
+            std::vector<std::uint32_t> cellOf(numTriangles);
+            std::vector<std::size_t> cellStart(numCells + 1, 0);
+            for (std::size_t t = 0; t < numTriangles; ++t)
+            {
+                auto centroid = (vertices[indices[3 * t + 0]] +
+                    vertices[indices[3 * t + 1]] +
+                    vertices[indices[3 * t + 2]]) / 3.0f;
+
+                std::size_t cell = 0;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    float u = (extent[axis] > 0.0f) ?
+                        (centroid[axis] - box.pMin[axis]) / extent[axis] : 0.0f;
+                    auto i = static_cast<std::size_t>(
+                        std::max(u * partitions + offset, 0.0f));
+                    cell = cell * cellsPerAxis + std::min(i, cellsPerAxis - 1);
+                }
+
+                cellOf[t] = static_cast<std::uint32_t>(cell);
+                cellStart[cell + 1]++;
+            }
+
+            for (std::size_t c = 0; c < numCells; ++c)
+            {
+                cellStart[c + 1] += cellStart[c];
+            }
+
+            std::vector<std::uint32_t> order(numTriangles);
+            {
+                std::vector<std::size_t> cursor(cellStart.begin(),
+                    cellStart.end() - 1);
+                for (std::size_t t = 0; t < numTriangles; ++t)
+                {
+                    order[cursor[cellOf[t]]++] = static_cast<std::uint32_t>(t);
+                }
+            }
+
+            // Cells only share border vertices, which are never moved, so
+            // each cell can write back its own vertices without locking.
+            std::vector<std::vector<GLuint>> cellIndices(numCells);
+            std::vector<SimplifyStats> cellStats(numCells);
+            double ratio = static_cast<double>(targetTriangles) /
+                static_cast<double>(numTriangles);
+            tbb::parallel_for(static_cast<std::size_t>(0), numCells,
+                [&](std::size_t c)
+            {
+                std::size_t begin = cellStart[c];
+                std::size_t end = cellStart[c + 1];
+                if (begin == end)
+                {
+                    return;
+                }
+
+                std::unordered_map<GLuint, GLuint> localIndex;
+                std::vector<GLuint> globalIndex;
+                std::vector<math::Point> localVertices;
+                std::vector<math::Normal> localNormals;
+                std::vector<GLuint> localIndices;
+                localIndices.reserve((end - begin) * 3);
+
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    auto t = order[i];
+                    for (std::size_t k = 0; k < 3; ++k)
+                    {
+                        auto v = indices[3 * t + k];
+                        auto entry = localIndex.find(v);
+                        if (entry == localIndex.end())
+                        {
+                            auto id = static_cast<GLuint>(globalIndex.size());
+                            entry = localIndex.insert(
+                                std::pair<GLuint, GLuint>(v, id)).first;
+                            globalIndex.push_back(v);
+                            localVertices.push_back(vertices[v]);
+                            if (hasNormals)
+                            {
+                                localNormals.push_back(normals[v]);
+                            }
+                        }
+                        localIndices.push_back((*entry).second);
+                    }
+                }
+
+                auto target = static_cast<std::size_t>(
+                    std::ceil(ratio * (end - begin)));
+                simplifyTriangles(localVertices, localNormals, localIndices,
+                    target, maxError, &cellStats[c]);
+
+                for (std::size_t v = 0; v < globalIndex.size(); ++v)
+                {
+                    auto g = globalIndex[v];
+                    if (std::memcmp(&vertices[g], &localVertices[v],
+                        sizeof(math::Point)) != 0)
+                    {
+                        vertices[g] = localVertices[v];
+                        if (hasNormals)
+                        {
+                            normals[g] = localNormals[v];
+                        }
+                    }
+                }
+
+                for (auto& index : localIndices)
+                {
+                    index = globalIndex[index];
+                }
+                cellIndices[c].swap(localIndices);
+            });
+
+            std::vector<GLuint> result;
+            for (auto const& cell : cellIndices)
+            {
+                result.insert(result.end(), cell.begin(), cell.end());
+            }
+            indices.swap(result);
+
+            SimplifyStats stats;
+            for (auto const& cell : cellStats)
+            {
+                stats += cell;
+            }
+            stats.inputTriangles = numTriangles;
+            stats.triangles = indices.size() / 3;
+            stats.targetTriangles = targetTriangles;
+            return stats;
+        }
+
+        SimplifyStats simplifyMesh(Mesh& mesh, std::size_t targetTriangles,
+            float maxError, std::size_t partitions)
+        {
+            auto& vertices = mesh.vertices();
+            auto& normals = mesh.normals();
+            auto& indices = mesh.indices();
+
+            SimplifyStats stats;
+            stats.inputTriangles = indices.size() / 3;
+            stats.triangles = stats.inputTriangles;
+            stats.targetTriangles = targetTriangles;
+            if (stats.inputTriangles <= targetTriangles)
+            {
+                return stats;
+            }
+
+            bool hasNormals = normals.size() == vertices.size();
+
+            // Small cells are mostly border, which cannot be collapsed.
+            while (partitions > 1 && partitions * partitions * partitions *
+                MinSimplifyCellTriangles > stats.inputTriangles)
+            {
+                --partitions;
+            }
+            partitions = std::max(partitions, static_cast<std::size_t>(1));
+
+            // The first pass cannot touch the edges on its cell borders, so
+            // if it falls short the second pass moves the borders. What the
+            // second pass ran into is what held the result back.
+            auto first = simplifyCells(mesh, targetTriangles, maxError,
+                partitions, false);
+            if (first.exhausted && first.triangles > targetTriangles)
+            {
+                stats = simplifyCells(mesh, targetTriangles, maxError,
+                    partitions, true);
+                stats.inputTriangles = first.inputTriangles;
+            }
+            else
+            {
+                stats = first;
+            }
+
+            // Drop the vertices that were collapsed away.
+            optimizeVertexFetch(mesh);
+            std::size_t numUsed = 0;
+            for (auto index : indices)
+            {
+                numUsed = std::max(numUsed, static_cast<std::size_t>(index) + 1);
+            }
+
+            vertices.resize(numUsed);
+            if (hasNormals)
+            {
+                normals.resize(numUsed);
+            }
+            if (mesh.texCoords().size() > numUsed)
+            {
+                mesh.texCoords().resize(numUsed);
+            }
+
+            stats.triangles = indices.size() / 3;
+            logSimplifyStats(stats);
+            return stats;
+        }
+    }
+}
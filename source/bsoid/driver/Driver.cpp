@@ -0,0 +1,887 @@
+#include "bsoid/driver/Driver.hpp"
+#include "bsoid/driver/Regression.hpp"
+#include "bsoid/driver/Scaling.hpp"
+#include "bsoid/models/Models.hpp"
+#include "bsoid/polygonizer/MeshSink.hpp"
+#include "bsoid/polygonizer/Utilization.hpp"
+#include "bsoid/Bsoid.hpp"
+
+#include <atlas/core/Log.hpp>
+#include <atlas/core/Memory.hpp>
+#include <atlas/core/Profiler.hpp>
+#include <atlas/core/Timer.hpp>
+#include <atlas/utils/MeshSimplifier.hpp>
+
+#include <tbb/task_arena.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <tuple>
+
+namespace
+{
+    std::vector<std::string> split(std::string const& value, char delim)
+    {
+        std::vector<std::string> result;
+        std::stringstream stream(value);
+        std::string item;
+        while (std::getline(stream, item, delim))
+        {
+            if (!item.empty())
+            {
+                result.push_back(item);
+            }
+        }
+
+        return result;
+    }
+
+    bool parseNumber(std::string const& value, long long& number)
+    {
+        char* end = nullptr;
+        number = std::strtoll(value.c_str(), &end, 10);
+        return !value.empty() && *end == '\0';
+    }
+
+    bool parseFloat(std::string const& value, float& number)
+    {
+        char* end = nullptr;
+        number = std::strtof(value.c_str(), &end);
+        return !value.empty() && *end == '\0';
+    }
+
+    // Accepts a list such as "64,128" where any item may also be an
+    // inclusive range "start:end:step".
+    bool parseSizes(std::string const& value, std::vector<std::size_t>& sizes)
+    {
+        sizes.clear();
+        for (auto& item : split(value, ','))
+        {
+            auto range = split(item, ':');
+            long long start, end, step = 1;
+            if (range.size() == 1 && parseNumber(range[0], start) &&
+                start > 0)
+            {
+                sizes.push_back(static_cast<std::size_t>(start));
+                continue;
+            }
+
+            if ((range.size() != 2 && range.size() != 3) ||
+                !parseNumber(range[0], start) || !parseNumber(range[1], end) ||
+                (range.size() == 3 && !parseNumber(range[2], step)) ||
+                start <= 0 || end < start || step <= 0)
+            {
+                return false;
+            }
+
+            for (long long i = start; i <= end; i += step)
+            {
+                sizes.push_back(static_cast<std::size_t>(i));
+            }
+        }
+
+        return !sizes.empty();
+    }
+
+    std::string escapeJson(std::string const& value)
+    {
+        std::string result;
+        for (auto c : value)
+        {
+            switch (c)
+            {
+            case '"':
+                result += "\\\"";
+                break;
+
+            case '\\':
+                result += "\\\\";
+                break;
+
+            case '\n':
+                result += "\\n";
+                break;
+
+            default:
+                result += c;
+            }
+        }
+
+        return result;
+    }
+
+    // Phase names in the order they first appear, so the CSV has the same
+    // columns whatever mix of algorithms was run.
+    std::vector<std::string> getPhaseNames(
+        std::vector<bsoid::driver::RunRecord> const& records)
+    {
+        std::vector<std::string> names;
+        for (auto& record : records)
+        {
+            for (auto& phase : record.phases)
+            {
+                bool found = false;
+                for (auto& name : names)
+                {
+                    found = found || (name == phase.name);
+                }
+
+                if (!found)
+                {
+                    names.push_back(phase.name);
+                }
+            }
+        }
+
+        return names;
+    }
+
+    // Counter names in the order they first appear, as with the phases.
+    std::vector<std::string> getCounterNames(
+        std::vector<bsoid::driver::RunRecord> const& records)
+    {
+        std::vector<std::string> names;
+        for (auto& record : records)
+        {
+            for (auto& counter : record.counters)
+            {
+                if (std::find(names.begin(), names.end(), counter.first) ==
+                    names.end())
+                {
+                    names.push_back(counter.first);
+                }
+            }
+        }
+
+        return names;
+    }
+
+    // Turns a model name, which may be a snapshot path, into something that
+    // can be part of a file name.
+    std::string sanitizeName(std::string const& name)
+    {
+        std::string result;
+        for (auto c : name)
+        {
+            bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                (c >= '0' && c <= '9') || c == '-' || c == '_';
+            result += valid ? c : '_';
+        }
+
+        return result;
+    }
+
+    // Appends the threads of a phase to its JSON object, if they were
+    // recorded.
+    void writeUtilizationJson(bsoid::polygonizer::PhaseStats const& phase,
+        std::ostream& out)
+    {
+        if (phase.workers.empty())
+        {
+            return;
+        }
+
+        double busy = 0.0, idle = 0.0, serial = 0.0;
+        std::uint64_t tasks = 0, entries = 0, exits = 0;
+        for (auto& worker : phase.workers)
+        {
+            busy += worker.busy;
+            idle += worker.idle;
+            serial += worker.serial;
+            tasks += worker.tasks;
+            entries += worker.entries;
+            exits += worker.exits;
+        }
+
+        out << ",\n          \"utilization\": { " <<
+            "\"threads\": " << phase.workers.size() << ", " <<
+            "\"busy_seconds\": " << busy << ", " <<
+            "\"idle_seconds\": " << idle << ", " <<
+            "\"serial_seconds\": " << serial << ", " <<
+            "\"tasks\": " << tasks << ", " <<
+            "\"arena_entries\": " << entries << ", " <<
+            "\"arena_exits\": " << exits << ",\n" <<
+            "            \"workers\": [";
+        for (std::size_t i = 0; i < phase.workers.size(); ++i)
+        {
+            auto const& worker = phase.workers[i];
+            out << ((i == 0) ? "\n" : ",\n");
+            out << "              { \"master\": " <<
+                (worker.master ? "true" : "false") << ", " <<
+                "\"active_seconds\": " << worker.active << ", " <<
+                "\"busy_seconds\": " << worker.busy << ", " <<
+                "\"idle_seconds\": " << worker.idle << ", " <<
+                "\"serial_seconds\": " << worker.serial << ", " <<
+                "\"tasks\": " << worker.tasks << ", " <<
+                "\"arena_entries\": " << worker.entries << ", " <<
+                "\"arena_exits\": " << worker.exits << " }";
+        }
+        out << "\n            ] }";
+    }
+
+    template <typename Polygonizer>
+    void measure(Polygonizer& polygonizer, bool optimize,
+        bsoid::driver::SimplifyOptions const& simplify, bool streamByDefault,
+        bsoid::driver::RunRecord& record)
+    {
+        using bsoid::polygonizer::MeshSink;
+        using bsoid::driver::SimplifyMode;
+
+        atlas::core::Timer<double> timer;
+        bool simplified = simplify.ratio < 1.0f;
+        bool streamed = (simplify.mode == SimplifyMode::Automatic) ?
+            streamByDefault : (simplify.mode == SimplifyMode::Stream);
+
+        timer.start();
+        auto& mesh = polygonizer.getMesh();
+        bsoid::polygonizer::MemoryMeshSink memory(mesh);
+        bsoid::polygonizer::SimplifyMeshSink simplifier(memory,
+            simplify.ratio, simplify.maxError);
+        polygonizer.polygonize((simplified && streamed) ?
+            static_cast<MeshSink&>(simplifier) : memory);
+        if (simplified && !streamed)
+        {
+            auto target = static_cast<std::size_t>(std::ceil(
+                simplify.ratio * (mesh.indices().size() / 3)));
+            atlas::utils::simplifyMesh(mesh, target, simplify.maxError);
+        }
+        if (optimize)
+        {
+            polygonizer.optimizeMesh();
+        }
+        record.total = timer.elapsed();
+
+        auto const& stats = polygonizer.getStats();
+        record.phases = stats.phases;
+        record.sections = stats.sections;
+        record.evaluations = stats.evaluations;
+        // Simplification removes vertices after the polygonizer counted
+        // them, so count what is left in the mesh.
+        record.vertices = polygonizer.getMesh().vertices().size();
+        record.triangles = polygonizer.getMesh().indices().size() / 3;
+        record.memory = polygonizer.size();
+        record.counters = stats.counters;
+
+        // Every phase resets the peaks, so the peaks of the whole run are
+        // the largest of the phases.
+        for (auto& phase : record.phases)
+        {
+            record.peakBytes = std::max(record.peakBytes, phase.peakBytes);
+            record.allocations += phase.allocations;
+            record.peakRSS = std::max(record.peakRSS, phase.peakRSS);
+        }
+    }
+}
+
+namespace bsoid
+{
+    namespace driver
+    {
+        Options::Options() :
+            models({ "particles" }),
+            algorithms({ "bsoid" }),
+            resolutions({ std::get<0>(models::currentResolution) }),
+            threads({ 0 }),
+            reps(1),
+            warmup(0),
+            optimize(true),
+            format("csv"),
+            updateBaseline(false),
+            utilization(false)
+        { }
+
+        SimplifyOptions::SimplifyOptions() :
+            ratio(1.0f),
+            maxError(std::numeric_limits<float>::max()),
+            mode(SimplifyMode::Automatic)
+        { }
+
+        RunRecord::RunRecord() :
+            resolution(0),
+            svResolution(0),
+            threads(0),
+            rep(0),
+            total(0.0),
+            evaluations(0),
+            vertices(0),
+            triangles(0),
+            memory(0),
+            peakBytes(0),
+            allocations(0),
+            peakRSS(0)
+        { }
+
+        bool parseOptions(int argc, char** argv, Options& options)
+        {
+            for (int i = 1; i < argc; ++i)
+            {
+                std::string arg(argv[i]);
+                auto equals = arg.find('=');
+                std::string name = arg.substr(0, equals);
+                std::string value = (equals == std::string::npos) ? "" :
+                    arg.substr(equals + 1);
+                long long number;
+
+                if (name == "--models")
+                {
+                    options.models = (value == "all") ?
+                        models::getModelNames() : split(value, ',');
+                }
+                else if (name == "--algo")
+                {
+                    options.algorithms = (value == "both") ?
+                        std::vector<std::string>{ "bsoid", "mc" } :
+                        split(value, ',');
+                    for (auto& algorithm : options.algorithms)
+                    {
+                        if (algorithm != "bsoid" && algorithm != "mc")
+                        {
+                            ERROR_LOG_V("Unknown algorithm: %s.",
+                                algorithm.c_str());
+                            return false;
+                        }
+                    }
+                }
+                else if (name == "--res")
+                {
+                    if (!parseSizes(value, options.resolutions))
+                    {
+                        ERROR_LOG_V("Invalid resolutions: %s.", value.c_str());
+                        return false;
+                    }
+                }
+                else if (name == "--sv-res")
+                {
+                    if (!parseSizes(value, options.svResolutions))
+                    {
+                        ERROR_LOG_V("Invalid supervoxel resolutions: %s.",
+                            value.c_str());
+                        return false;
+                    }
+                }
+                else if (name == "--threads")
+                {
+                    options.threads.clear();
+                    for (auto& item : split(value, ','))
+                    {
+                        if (!parseNumber(item, number) || number < 0)
+                        {
+                            ERROR_LOG_V("Invalid thread count: %s.",
+                                item.c_str());
+                            return false;
+                        }
+                        options.threads.push_back(static_cast<int>(number));
+                    }
+                }
+                else if (name == "--reps" || name == "--warmup")
+                {
+                    if (!parseNumber(value, number) || number < 0)
+                    {
+                        ERROR_LOG_V("Invalid count for %s: %s.", name.c_str(),
+                            value.c_str());
+                        return false;
+                    }
+                    auto& count = (name == "--reps") ? options.reps :
+                        options.warmup;
+                    count = static_cast<std::size_t>(number);
+                }
+                else if (name == "--no-optimize")
+                {
+                    options.optimize = false;
+                }
+                else if (name == "--format")
+                {
+                    if (value != "csv" && value != "json")
+                    {
+                        ERROR_LOG_V("Unknown format: %s.", value.c_str());
+                        return false;
+                    }
+                    options.format = value;
+                }
+                else if (name == "--output")
+                {
+                    options.output = value;
+                }
+                else if (name == "--trace")
+                {
+                    options.trace = value;
+                }
+                else if (name == "--heatmap")
+                {
+                    options.heatmap = value;
+                }
+                else if (name == "--check")
+                {
+                    options.baseline = value;
+                }
+                else if (name == "--update-baseline")
+                {
+                    options.updateBaseline = true;
+                }
+                else if (name == "--utilization")
+                {
+                    options.utilization = true;
+                }
+                else if (name == "--simplify")
+                {
+                    auto parts = split(value, ':');
+                    auto& simplify = options.simplify;
+                    if (parts.empty() || parts.size() > 2 ||
+                        !parseFloat(parts[0], simplify.ratio) ||
+                        !(simplify.ratio > 0.0f && simplify.ratio <= 1.0f) ||
+                        (parts.size() == 2 &&
+                        (!parseFloat(parts[1], simplify.maxError) ||
+                        !(simplify.maxError >= 0.0f))))
+                    {
+                        ERROR_LOG_V("Invalid simplification: %s.",
+                            value.c_str());
+                        return false;
+                    }
+                }
+                else if (name == "--simplify-mode")
+                {
+                    if (value != "auto" && value != "stream" &&
+                        value != "mesh")
+                    {
+                        ERROR_LOG_V("Unknown simplification mode: %s.",
+                            value.c_str());
+                        return false;
+                    }
+                    options.simplify.mode = (value == "stream") ?
+                        SimplifyMode::Stream : (value == "mesh") ?
+                        SimplifyMode::Mesh : SimplifyMode::Automatic;
+                }
+                else if (name == "--scaling")
+                {
+                    if (value != "strong" && value != "weak")
+                    {
+                        ERROR_LOG_V("Unknown scaling mode: %s.",
+                            value.c_str());
+                        return false;
+                    }
+                    options.scaling = value;
+                }
+                else
+                {
+                    ERROR_LOG_V("Unknown argument: %s.", arg.c_str());
+                    return false;
+                }
+            }
+
+            if (options.models.empty() || options.algorithms.empty() ||
+                options.threads.empty())
+            {
+                ERROR_LOG("At least one model, algorithm and thread count " \
+                    "is required.");
+                return false;
+            }
+
+            return true;
+        }
+
+        void printUsage(std::ostream& out)
+        {
+            out << "Usage: bsoid [options]\n";
+            out << "  --models=a,b      Models to run, or all. Names that are "
+                "not models are\n";
+            out << "                    loaded as tree snapshots.\n";
+            out << "  --algo=bsoid|mc|both\n";
+            out << "  --res=64,128      Grid resolutions, items may be "
+                "start:end:step.\n";
+            out << "  --sv-res=16,32    Supervoxel resolutions (default "
+                "res / 4).\n";
+            out << "  --threads=1,2,4   Thread counts, 0 for the default.\n";
+            out << "  --reps=N          Measured runs per configuration.\n";
+            out << "  --warmup=N        Unreported runs per configuration.\n";
+            out << "  --no-optimize     Skip the vertex cache optimization.\n";
+            out << "  --simplify=ratio[:error]\n";
+            out << "                    Keep a fraction of the triangles, " \
+                "moving no vertex\n";
+            out << "                    further than error from the " \
+                "surface.\n";
+            out << "  --simplify-mode=auto|stream|mesh\n";
+            out << "                    Simplify each chunk as it is made " \
+                "or the whole mesh\n";
+            out << "                    afterwards. Auto (default) streams " \
+                "marching cubes\n";
+            out << "                    and simplifies the whole mesh of " \
+                "Bsoid.\n";
+            out << "  --format=csv|json\n";
+            out << "  --output=file     Write results to a file instead of "
+                "stdout.\n";
+            out << "  --trace=file      Write profiler zones as a Chrome "
+                "trace.\n";
+            out << "  --heatmap=prefix  Write per-supervoxel counters of " \
+                "Bsoid runs to\n";
+            out << "                    prefix<model>_<res>_<sv-res>.csv.\n";
+            out << "  --check=file      Run the configurations of a baseline " \
+                "and exit with 1\n";
+            out << "                    if any of them regressed.\n";
+            out << "  --update-baseline With --check, store the new " \
+                "measurements instead.\n";
+            out << "  --scaling=strong|weak\n";
+            out << "                    Run every configuration on 1, 2, 4 " \
+                "... threads (or the\n";
+            out << "                    given ones) and report speedup, " \
+                "efficiency and\n";
+            out << "                    serial fraction per phase. Weak " \
+                "scaling grows the\n";
+            out << "                    resolution with the thread count.\n";
+            out << "  --utilization     Record busy, idle and serial time " \
+                "of every thread per phase.\n";
+            out << "Models:";
+            for (auto& name : models::getModelNames())
+            {
+                out << " " << name;
+            }
+            out << "\n";
+        }
+
+        bool runOnce(std::string const& model, std::string const& algorithm,
+            std::size_t resolution, std::size_t svResolution, int threads,
+            bool optimize, RunRecord& record, std::string const& heatmap,
+            SimplifyOptions const& simplify)
+        {
+            tree::BlobTree tree;
+            if (!models::makeModelTree(model, tree))
+            {
+                return false;
+            }
+
+            record.model = model;
+            record.algorithm = algorithm;
+            record.resolution = resolution;
+            record.svResolution = (algorithm == "bsoid") ? svResolution : 0;
+            record.threads = threads;
+
+            tbb::task_arena arena((threads > 0) ? threads :
+                static_cast<int>(tbb::task_arena::automatic));
+            arena.execute([&]()
+            {
+                if (algorithm == "bsoid")
+                {
+                    polygonizer::Bsoid soid(tree, model);
+                    soid.setResolution(resolution, svResolution);
+                    measure(soid, optimize, simplify, false, record);
+
+                    if (!heatmap.empty())
+                    {
+                        std::stringstream filename;
+                        filename << heatmap << sanitizeName(model) << "_" <<
+                            resolution << "_" << svResolution << ".csv";
+                        soid.saveSuperVoxelHeatmap(filename.str());
+                    }
+                }
+                else
+                {
+                    polygonizer::MarchingCubes mc(tree, model);
+                    mc.setResolution(static_cast<std::uint32_t>(resolution));
+                    measure(mc, optimize, simplify, true, record);
+                }
+            });
+
+            return true;
+        }
+
+        bool runAll(Options const& options, std::vector<RunRecord>& records)
+        {
+            for (auto& model : options.models)
+            {
+                for (auto& algorithm : options.algorithms)
+                {
+                    for (auto res : options.resolutions)
+                    {
+                        std::vector<std::size_t> svResolutions =
+                            options.svResolutions;
+                        if (svResolutions.empty() || algorithm == "mc")
+                        {
+                            svResolutions = { std::max<std::size_t>(
+                                res / 4, 1) };
+                        }
+
+                        for (auto svRes : svResolutions)
+                        {
+                            for (auto threads : options.threads)
+                            {
+                                INFO_LOG_V("Running %s with %s at %zu/%zu " \
+                                    "on %d threads.", model.c_str(),
+                                    algorithm.c_str(), res, svRes, threads);
+
+                                RunRecord record;
+                                for (std::size_t i = 0; i < options.warmup;
+                                    ++i)
+                                {
+                                    if (!runOnce(model, algorithm, res, svRes,
+                                        threads, options.optimize, record, "",
+                                        options.simplify))
+                                    {
+                                        return false;
+                                    }
+                                }
+
+                                for (std::size_t i = 0; i < options.reps; ++i)
+                                {
+                                    record = RunRecord();
+                                    if (!runOnce(model, algorithm, res, svRes,
+                                        threads, options.optimize, record,
+                                        options.heatmap, options.simplify))
+                                    {
+                                        return false;
+                                    }
+                                    record.rep = i;
+                                    records.push_back(record);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        void writeCsv(std::vector<RunRecord> const& records,
+            std::ostream& out)
+        {
+            auto phaseNames = getPhaseNames(records);
+            auto counterNames = getCounterNames(records);
+
+            out << "model,algorithm,resolution,sv_resolution,threads,rep";
+            for (auto& name : phaseNames)
+            {
+                out << "," << name << "_seconds," << name << "_peak_bytes," <<
+                    name << "_allocations";
+            }
+            out << ",total_seconds,evaluations,vertices,triangles," \
+                "memory_bytes,peak_bytes,allocations,peak_rss_bytes";
+            for (auto& name : counterNames)
+            {
+                out << "," << name;
+            }
+            out << "\n";
+
+            for (auto& record : records)
+            {
+                out << record.model << "," << record.algorithm << "," <<
+                    record.resolution << "," << record.svResolution << "," <<
+                    record.threads << "," << record.rep;
+
+                for (auto& name : phaseNames)
+                {
+                    auto phase = std::find_if(record.phases.begin(),
+                        record.phases.end(),
+                        [&name](polygonizer::PhaseStats const& p)
+                    {
+                        return p.name == name;
+                    });
+
+                    if (phase == record.phases.end())
+                    {
+                        out << ",,,";
+                        continue;
+                    }
+
+                    out << "," << phase->seconds << "," << phase->peakBytes <<
+                        "," << phase->allocations;
+                }
+
+                out << "," << record.total << "," << record.evaluations <<
+                    "," << record.vertices << "," << record.triangles << "," <<
+                    record.memory << "," << record.peakBytes << "," <<
+                    record.allocations << "," << record.peakRSS;
+
+                for (auto& name : counterNames)
+                {
+                    auto counter = std::find_if(record.counters.begin(),
+                        record.counters.end(),
+                        [&name](std::pair<std::string, std::uint64_t> const& c)
+                    {
+                        return c.first == name;
+                    });
+
+                    out << ",";
+                    if (counter != record.counters.end())
+                    {
+                        out << counter->second;
+                    }
+                }
+                out << "\n";
+            }
+        }
+
+        void writeJson(std::vector<RunRecord> const& records,
+            std::ostream& out)
+        {
+            out << "{\n";
+            out << "  \"version\": \"" << BSOID_VERSION_STRING << "\",\n";
+            out << "  \"runs\": [";
+
+            for (std::size_t i = 0; i < records.size(); ++i)
+            {
+                auto const& record = records[i];
+                out << ((i == 0) ? "\n" : ",\n");
+                out << "    {\n";
+                out << "      \"model\": \"" << escapeJson(record.model) <<
+                    "\",\n";
+                out << "      \"algorithm\": \"" << record.algorithm <<
+                    "\",\n";
+                out << "      \"resolution\": " << record.resolution << ",\n";
+                out << "      \"sv_resolution\": " << record.svResolution <<
+                    ",\n";
+                out << "      \"threads\": " << record.threads << ",\n";
+                out << "      \"rep\": " << record.rep << ",\n";
+
+                out << "      \"phases\": {";
+                for (std::size_t j = 0; j < record.phases.size(); ++j)
+                {
+                    auto const& phase = record.phases[j];
+                    out << ((j == 0) ? "\n" : ",\n");
+                    out << "        \"" << phase.name << "\": { " <<
+                        "\"seconds\": " << phase.seconds << ", " <<
+                        "\"bytes\": " << phase.bytes << ", " <<
+                        "\"peak_bytes\": " << phase.peakBytes << ", " <<
+                        "\"allocations\": " << phase.allocations << ", " <<
+                        "\"rss_bytes\": " << phase.rss << ", " <<
+                        "\"peak_rss_bytes\": " << phase.peakRSS;
+                    writeUtilizationJson(phase, out);
+                    out << " }";
+                }
+                out << "\n      },\n";
+
+                out << "      \"sections\": {";
+                for (std::size_t j = 0; j < record.sections.size(); ++j)
+                {
+                    auto const& section = record.sections[j];
+                    out << ((j == 0) ? "\n" : ",\n");
+                    out << "        \"" << section.first << "\": " <<
+                        section.second;
+                }
+                out << (record.sections.empty() ? "},\n" : "\n      },\n");
+
+                out << "      \"total_seconds\": " << record.total << ",\n";
+                out << "      \"evaluations\": " << record.evaluations <<
+                    ",\n";
+                out << "      \"vertices\": " << record.vertices << ",\n";
+                out << "      \"triangles\": " << record.triangles << ",\n";
+                out << "      \"memory_bytes\": " << record.memory << ",\n";
+                out << "      \"peak_bytes\": " << record.peakBytes << ",\n";
+                out << "      \"allocations\": " << record.allocations <<
+                    ",\n";
+                out << "      \"peak_rss_bytes\": " << record.peakRSS << ",\n";
+
+                out << "      \"counters\": {";
+                for (std::size_t j = 0; j < record.counters.size(); ++j)
+                {
+                    auto const& counter = record.counters[j];
+                    out << ((j == 0) ? "\n" : ",\n");
+                    out << "        \"" << counter.first << "\": " <<
+                        counter.second;
+                }
+                out << (record.counters.empty() ? "}\n" : "\n      }\n");
+                out << "    }";
+            }
+
+            out << "\n  ]\n";
+            out << "}\n";
+        }
+
+        int run(int argc, char** argv)
+        {
+            for (int i = 1; i < argc; ++i)
+            {
+                std::string arg(argv[i]);
+                if (arg == "--help" || arg == "-h")
+                {
+                    printUsage(std::cout);
+                    return 0;
+                }
+            }
+
+            Options options;
+            if (!parseOptions(argc, argv, options))
+            {
+                printUsage(std::cerr);
+                return 1;
+            }
+
+            INFO_LOG_V("Welcome to Bsoid %s", BSOID_VERSION_STRING);
+
+            if (!options.baseline.empty())
+            {
+                return checkBaseline(options.baseline,
+                    options.updateBaseline);
+            }
+
+            if (options.updateBaseline)
+            {
+                ERROR_LOG("--update-baseline requires --check.");
+                return 1;
+            }
+
+#if !defined(ATLAS_ENABLE_PROFILING)
+            if (!options.trace.empty())
+            {
+                WARN_LOG("Profiling is disabled, the trace will be empty.");
+            }
+#endif
+
+            polygonizer::utilization::setEnabled(options.utilization);
+            atlas::core::Profiler::clear();
+            std::vector<RunRecord> records;
+            std::vector<ScalingRecord> scaling;
+            if (options.scaling.empty() ? !runAll(options, records) :
+                !runScaling(options, scaling))
+            {
+                return 1;
+            }
+
+            if (!options.trace.empty() &&
+                !atlas::core::Profiler::saveChromeTrace(options.trace))
+            {
+                return 1;
+            }
+
+            std::ofstream file;
+            if (!options.output.empty())
+            {
+                file.open(options.output);
+                if (!file)
+                {
+                    ERROR_LOG_V("Could not open %s.", options.output.c_str());
+                    return 1;
+                }
+            }
+
+            // The log is written from a background thread, keep it from
+            // interleaving with the results.
+            atlas::core::Log::flush();
+            std::ostream& out = options.output.empty() ? std::cout : file;
+            if (!options.scaling.empty())
+            {
+                if (options.format == "json")
+                {
+                    writeScalingJson(scaling, options.scaling, out);
+                }
+                else
+                {
+                    writeScalingCsv(scaling, out);
+                }
+            }
+            else if (options.format == "json")
+            {
+                writeJson(records, out);
+            }
+            else
+            {
+                writeCsv(records, out);
+            }
+
+            return 0;
+        }
+    }
+}
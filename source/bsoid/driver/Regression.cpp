@@ -0,0 +1,679 @@
+#include "bsoid/driver/Regression.hpp"
+#include "bsoid/Bsoid.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <thread>
+
+namespace
+{
+    // Just enough JSON to read the baselines back: objects, arrays,
+    // strings without unicode escapes, numbers and booleans.
+    struct JsonValue
+    {
+        enum class Type
+        {
+            Null,
+            Boolean,
+            Number,
+            String,
+            Array,
+            Object
+        };
+
+        JsonValue() :
+            type(Type::Null),
+            boolean(false),
+            number(0.0)
+        { }
+
+        JsonValue const* find(std::string const& key) const
+        {
+            for (auto& member : members)
+            {
+                if (member.first == key)
+                {
+                    return &member.second;
+                }
+            }
+
+            return nullptr;
+        }
+
+        Type type;
+        bool boolean;
+        double number;
+        std::string string;
+        std::vector<JsonValue> elements;
+        std::vector<std::pair<std::string, JsonValue>> members;
+    };
+
+    class JsonParser
+    {
+    public:
+        JsonParser(std::string const& text) :
+            mText(text),
+            mPos(0)
+        { }
+
+        bool parse(JsonValue& value)
+        {
+            if (!parseValue(value))
+            {
+                return false;
+            }
+
+            skipSpace();
+            return mPos == mText.size();
+        }
+
+        std::size_t position() const
+        {
+            return mPos;
+        }
+
+    private:
+        void skipSpace()
+        {
+            while (mPos < mText.size() &&
+                std::isspace(static_cast<unsigned char>(mText[mPos])))
+            {
+                ++mPos;
+            }
+        }
+
+        bool consume(char c)
+        {
+            skipSpace();
+            if (mPos < mText.size() && mText[mPos] == c)
+            {
+                ++mPos;
+                return true;
+            }
+
+            return false;
+        }
+
+        bool consumeWord(const char* word)
+        {
+            std::string w(word);
+            if (mText.compare(mPos, w.size(), w) == 0)
+            {
+                mPos += w.size();
+                return true;
+            }
+
+            return false;
+        }
+
+        bool parseString(std::string& result)
+        {
+            if (!consume('"'))
+            {
+                return false;
+            }
+
+            result.clear();
+            while (mPos < mText.size() && mText[mPos] != '"')
+            {
+                char c = mText[mPos++];
+                if (c == '\\')
+                {
+                    if (mPos == mText.size())
+                    {
+                        return false;
+                    }
+
+                    c = mText[mPos++];
+                    c = (c == 'n') ? '\n' : (c == 't') ? '\t' : c;
+                }
+                result += c;
+            }
+
+            return consume('"');
+        }
+
+        bool parseValue(JsonValue& value)
+        {
+            skipSpace();
+            if (mPos == mText.size())
+            {
+                return false;
+            }
+
+            char c = mText[mPos];
+            if (c == '{')
+            {
+                ++mPos;
+                value.type = JsonValue::Type::Object;
+                if (consume('}'))
+                {
+                    return true;
+                }
+
+                do
+                {
+                    std::pair<std::string, JsonValue> member;
+                    if (!parseString(member.first) || !consume(':') ||
+                        !parseValue(member.second))
+                    {
+                        return false;
+                    }
+                    value.members.push_back(member);
+                } while (consume(','));
+
+                return consume('}');
+            }
+
+            if (c == '[')
+            {
+                ++mPos;
+                value.type = JsonValue::Type::Array;
+                if (consume(']'))
+                {
+                    return true;
+                }
+
+                do
+                {
+                    JsonValue element;
+                    if (!parseValue(element))
+                    {
+                        return false;
+                    }
+                    value.elements.push_back(element);
+                } while (consume(','));
+
+                return consume(']');
+            }
+
+            if (c == '"')
+            {
+                value.type = JsonValue::Type::String;
+                return parseString(value.string);
+            }
+
+            if (consumeWord("true"))
+            {
+                value.type = JsonValue::Type::Boolean;
+                value.boolean = true;
+                return true;
+            }
+
+            if (consumeWord("false"))
+            {
+                value.type = JsonValue::Type::Boolean;
+                value.boolean = false;
+                return true;
+            }
+
+            if (consumeWord("null"))
+            {
+                value.type = JsonValue::Type::Null;
+                return true;
+            }
+
+            const char* begin = mText.c_str() + mPos;
+            char* end = nullptr;
+            value.number = std::strtod(begin, &end);
+            if (end == begin)
+            {
+                return false;
+            }
+
+            value.type = JsonValue::Type::Number;
+            mPos += static_cast<std::size_t>(end - begin);
+            return true;
+        }
+
+        std::string const& mText;
+        std::size_t mPos;
+    };
+
+    template <typename T>
+    bool readNumber(JsonValue const& object, const char* key, T& result)
+    {
+        auto value = object.find(key);
+        if (!value || value->type != JsonValue::Type::Number)
+        {
+            return false;
+        }
+
+        result = static_cast<T>(value->number);
+        return true;
+    }
+
+    bool readString(JsonValue const& object, const char* key,
+        std::string& result)
+    {
+        auto value = object.find(key);
+        if (!value || value->type != JsonValue::Type::String)
+        {
+            return false;
+        }
+
+        result = value->string;
+        return true;
+    }
+
+    template <typename T>
+    T median(std::vector<T> values)
+    {
+        if (values.empty())
+        {
+            return T();
+        }
+
+        std::sort(values.begin(), values.end());
+        auto mid = values.size() / 2;
+        return (values.size() % 2 == 1) ? values[mid] :
+            static_cast<T>((values[mid - 1] + values[mid]) / 2);
+    }
+
+    bool sameConfiguration(bsoid::driver::BaselineEntry const& a,
+        bsoid::driver::BaselineEntry const& b)
+    {
+        return a.model == b.model && a.algorithm == b.algorithm &&
+            a.resolution == b.resolution &&
+            a.svResolution == b.svResolution && a.threads == b.threads;
+    }
+
+    // Relative change of a metric, positive when it got worse.
+    double relativeChange(double baseline, double measured)
+    {
+        if (baseline <= 0.0)
+        {
+            return (measured > 0.0) ? 1.0 : 0.0;
+        }
+
+        return (measured - baseline) / baseline;
+    }
+
+    std::string formatValue(double value, bool integral)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), integral ? "%.0f" : "%.6g",
+            value);
+        return buffer;
+    }
+
+    std::string formatChange(double change)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%+.1f%%", 100.0 * change);
+        return buffer;
+    }
+}
+
+namespace bsoid
+{
+    namespace driver
+    {
+        Tolerance::Tolerance() :
+            seconds(0.5),
+            evaluations(0.01),
+            peakBytes(0.1)
+        { }
+
+        BaselineEntry::BaselineEntry() :
+            resolution(0),
+            svResolution(0),
+            threads(0),
+            seconds(0.0),
+            evaluations(0),
+            peakBytes(0)
+        { }
+
+        Baseline::Baseline() :
+            reps(5),
+            warmup(1),
+            optimize(true)
+        { }
+
+        bool loadBaseline(std::string const& filename, Baseline& baseline)
+        {
+            std::ifstream file(filename);
+            if (!file)
+            {
+                ERROR_LOG_V("Could not open baseline %s.", filename.c_str());
+                return false;
+            }
+
+            std::string text((std::istreambuf_iterator<char>(file)),
+                std::istreambuf_iterator<char>());
+
+            JsonValue root;
+            JsonParser parser(text);
+            if (!parser.parse(root) || root.type != JsonValue::Type::Object)
+            {
+                ERROR_LOG_V("Could not parse baseline %s near byte %zu.",
+                    filename.c_str(), parser.position());
+                return false;
+            }
+
+            baseline = Baseline();
+            readNumber(root, "reps", baseline.reps);
+            readNumber(root, "warmup", baseline.warmup);
+            auto optimize = root.find("optimize");
+            if (optimize && optimize->type == JsonValue::Type::Boolean)
+            {
+                baseline.optimize = optimize->boolean;
+            }
+
+            auto tolerance = root.find("tolerance");
+            if (tolerance)
+            {
+                readNumber(*tolerance, "seconds", baseline.tolerance.seconds);
+                readNumber(*tolerance, "evaluations",
+                    baseline.tolerance.evaluations);
+                readNumber(*tolerance, "peak_bytes",
+                    baseline.tolerance.peakBytes);
+            }
+
+            auto runs = root.find("runs");
+            if (!runs || runs->type != JsonValue::Type::Array)
+            {
+                ERROR_LOG_V("Baseline %s has no runs.", filename.c_str());
+                return false;
+            }
+
+            for (auto& run : runs->elements)
+            {
+                BaselineEntry entry;
+                if (!readString(run, "model", entry.model) ||
+                    !readString(run, "algorithm", entry.algorithm) ||
+                    !readNumber(run, "resolution", entry.resolution))
+                {
+                    ERROR_LOG_V("Baseline %s has a run without a model, " \
+                        "algorithm or resolution.", filename.c_str());
+                    return false;
+                }
+
+                if (entry.algorithm != "bsoid" && entry.algorithm != "mc")
+                {
+                    ERROR_LOG_V("Unknown algorithm in baseline: %s.",
+                        entry.algorithm.c_str());
+                    return false;
+                }
+
+                // Values that are missing are filled in by an update.
+                readNumber(run, "sv_resolution", entry.svResolution);
+                readNumber(run, "threads", entry.threads);
+                readNumber(run, "median_seconds", entry.seconds);
+                readNumber(run, "evaluations", entry.evaluations);
+                readNumber(run, "peak_bytes", entry.peakBytes);
+
+                if (entry.algorithm == "mc")
+                {
+                    entry.svResolution = 0;
+                }
+                else if (entry.svResolution == 0)
+                {
+                    entry.svResolution =
+                        std::max<std::size_t>(entry.resolution / 4, 1);
+                }
+
+                baseline.entries.push_back(entry);
+            }
+
+            return true;
+        }
+
+        bool saveBaseline(std::string const& filename,
+            Baseline const& baseline)
+        {
+            std::ofstream file(filename);
+            if (!file)
+            {
+                ERROR_LOG_V("Could not open %s for writing.",
+                    filename.c_str());
+                return false;
+            }
+
+            file << "{\n";
+            file << "  \"version\": \"" << BSOID_VERSION_STRING << "\",\n";
+            file << "  \"reps\": " << baseline.reps << ",\n";
+            file << "  \"warmup\": " << baseline.warmup << ",\n";
+            file << "  \"optimize\": " <<
+                (baseline.optimize ? "true" : "false") << ",\n";
+            file << "  \"tolerance\": { " <<
+                "\"seconds\": " << baseline.tolerance.seconds << ", " <<
+                "\"evaluations\": " << baseline.tolerance.evaluations <<
+                ", " << "\"peak_bytes\": " << baseline.tolerance.peakBytes <<
+                " },\n";
+            file << "  \"runs\": [";
+
+            for (std::size_t i = 0; i < baseline.entries.size(); ++i)
+            {
+                auto const& entry = baseline.entries[i];
+                file << ((i == 0) ? "\n" : ",\n");
+                file << "    { \"model\": \"" << entry.model << "\", " <<
+                    "\"algorithm\": \"" << entry.algorithm << "\", " <<
+                    "\"resolution\": " << entry.resolution << ", " <<
+                    "\"sv_resolution\": " << entry.svResolution << ", " <<
+                    "\"threads\": " << entry.threads << ",\n";
+                file << "      \"median_seconds\": " << entry.seconds <<
+                    ", " << "\"evaluations\": " << entry.evaluations <<
+                    ", " << "\"peak_bytes\": " << entry.peakBytes << " }";
+            }
+
+            file << "\n  ]\n";
+            file << "}\n";
+            return static_cast<bool>(file);
+        }
+
+        std::vector<BaselineEntry> summarize(
+            std::vector<RunRecord> const& records)
+        {
+            std::vector<BaselineEntry> result;
+            std::vector<std::vector<RunRecord const*>> groups;
+            for (auto& record : records)
+            {
+                BaselineEntry entry;
+                entry.model = record.model;
+                entry.algorithm = record.algorithm;
+                entry.resolution = record.resolution;
+                entry.svResolution = record.svResolution;
+                entry.threads = record.threads;
+
+                auto it = std::find_if(result.begin(), result.end(),
+                    [&entry](BaselineEntry const& e)
+                {
+                    return sameConfiguration(e, entry);
+                });
+
+                if (it == result.end())
+                {
+                    result.push_back(entry);
+                    groups.emplace_back();
+                    it = result.end() - 1;
+                }
+
+                groups[it - result.begin()].push_back(&record);
+            }
+
+            for (std::size_t i = 0; i < result.size(); ++i)
+            {
+                std::vector<double> seconds;
+                std::vector<std::uint64_t> evaluations;
+                std::vector<std::size_t> peakBytes;
+                for (auto record : groups[i])
+                {
+                    seconds.push_back(record->total);
+                    evaluations.push_back(record->evaluations);
+                    peakBytes.push_back(record->peakBytes);
+                }
+
+                result[i].seconds = median(seconds);
+                result[i].evaluations = median(evaluations);
+                result[i].peakBytes = median(peakBytes);
+            }
+
+            return result;
+        }
+
+        bool measureBaseline(Baseline const& baseline,
+            std::vector<BaselineEntry>& measured)
+        {
+            auto cores = static_cast<int>(std::thread::hardware_concurrency());
+            std::vector<RunRecord> records;
+            for (auto& entry : baseline.entries)
+            {
+                INFO_LOG_V("Measuring %s with %s at %zu/%zu on %d threads.",
+                    entry.model.c_str(), entry.algorithm.c_str(),
+                    entry.resolution, entry.svResolution, entry.threads);
+                if (cores > 0 && entry.threads > cores)
+                {
+                    WARN_LOG_V("Only %d cores are available, so the run on " \
+                        "%d threads does not measure a parallel run.", cores,
+                        entry.threads);
+                }
+
+                RunRecord record;
+                for (std::size_t i = 0; i < baseline.warmup; ++i)
+                {
+                    if (!runOnce(entry.model, entry.algorithm,
+                        entry.resolution, entry.svResolution, entry.threads,
+                        baseline.optimize, record))
+                    {
+                        return false;
+                    }
+                }
+
+                for (std::size_t i = 0; i < std::max<std::size_t>(
+                    baseline.reps, 1); ++i)
+                {
+                    record = RunRecord();
+                    if (!runOnce(entry.model, entry.algorithm,
+                        entry.resolution, entry.svResolution, entry.threads,
+                        baseline.optimize, record))
+                    {
+                        return false;
+                    }
+                    record.rep = i;
+                    records.push_back(record);
+                }
+            }
+
+            measured = summarize(records);
+            return true;
+        }
+
+        bool compareBaseline(Baseline const& baseline,
+            std::vector<BaselineEntry> const& measured, std::ostream& out)
+        {
+            auto const& tolerance = baseline.tolerance;
+            auto cores = static_cast<int>(std::thread::hardware_concurrency());
+            bool passed = true;
+
+            out << "model,algorithm,resolution,sv_resolution,threads," \
+                "metric,baseline,measured,change,status\n";
+            for (auto& expected : baseline.entries)
+            {
+                auto it = std::find_if(measured.begin(), measured.end(),
+                    [&expected](BaselineEntry const& e)
+                {
+                    return sameConfiguration(e, expected);
+                });
+
+                if (it == measured.end())
+                {
+                    ERROR_LOG_V("No measurement for %s with %s at %zu.",
+                        expected.model.c_str(), expected.algorithm.c_str(),
+                        expected.resolution);
+                    passed = false;
+                    continue;
+                }
+
+                // A negative limit only reports the metric.
+                auto report = [&](const char* metric, double base,
+                    double value, double limit, bool integral)
+                {
+                    double change = relativeChange(base, value);
+                    bool regressed = limit >= 0.0 && change > limit;
+                    out << expected.model << "," << expected.algorithm <<
+                        "," << expected.resolution << "," <<
+                        expected.svResolution << "," << expected.threads <<
+                        "," << metric << "," <<
+                        formatValue(base, integral) << "," <<
+                        formatValue(value, integral) << "," <<
+                        formatChange(change) << "," <<
+                        (regressed ? "REGRESSED" : (limit >= 0.0) ? "ok" :
+                        "info") << "\n";
+
+                    if (regressed)
+                    {
+                        ERROR_LOG_V("%s with %s at %zu on %d threads: %s " \
+                            "went from %s to %s (%s, limit %+.1f%%).",
+                            expected.model.c_str(),
+                            expected.algorithm.c_str(), expected.resolution,
+                            expected.threads, metric,
+                            formatValue(base, integral).c_str(),
+                            formatValue(value, integral).c_str(),
+                            formatChange(change).c_str(), 100.0 * limit);
+                        passed = false;
+                    }
+                };
+
+                // Threads that share a core only measure the scheduler.
+                bool timed = cores <= 0 || expected.threads <= cores;
+                report("median_seconds", expected.seconds, it->seconds,
+                    timed ? tolerance.seconds : -1.0, false);
+                report("evaluations",
+                    static_cast<double>(expected.evaluations),
+                    static_cast<double>(it->evaluations),
+                    tolerance.evaluations, true);
+                report("peak_bytes", static_cast<double>(expected.peakBytes),
+                    static_cast<double>(it->peakBytes), tolerance.peakBytes,
+                    true);
+            }
+
+            return passed;
+        }
+
+        int checkBaseline(std::string const& filename, bool update)
+        {
+            Baseline baseline;
+            if (!loadBaseline(filename, baseline))
+            {
+                return 1;
+            }
+
+            std::vector<BaselineEntry> measured;
+            if (!measureBaseline(baseline, measured))
+            {
+                return 1;
+            }
+
+            if (update)
+            {
+                baseline.entries = measured;
+                if (!saveBaseline(filename, baseline))
+                {
+                    return 1;
+                }
+
+                INFO_LOG_V("Updated baseline %s.", filename.c_str());
+                return 0;
+            }
+
+            if (!compareBaseline(baseline, measured, std::cout))
+            {
+                ERROR_LOG_V("Performance regressed against %s.",
+                    filename.c_str());
+                return 1;
+            }
+
+            INFO_LOG_V("All runs are within the tolerances of %s.",
+                filename.c_str());
+            return 0;
+        }
+    }
+}
@@ -0,0 +1,363 @@
+#include "bsoid/driver/Scaling.hpp"
+#include "bsoid/Bsoid.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace
+{
+    double median(std::vector<double> values)
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+
+        std::sort(values.begin(), values.end());
+        auto mid = values.size() / 2;
+        return (values.size() % 2 == 1) ? values[mid] :
+            (values[mid - 1] + values[mid]) / 2.0;
+    }
+
+    // Time of a component in a run, or a negative value if the run does
+    // not have it.
+    double getComponentSeconds(bsoid::driver::RunRecord const& record,
+        std::string const& component)
+    {
+        if (component == "total")
+        {
+            return record.total;
+        }
+
+        for (auto& phase : record.phases)
+        {
+            if (phase.name == component)
+            {
+                return phase.seconds;
+            }
+        }
+
+        for (auto& section : record.sections)
+        {
+            if (section.first == component)
+            {
+                return section.second;
+            }
+        }
+
+        return -1.0;
+    }
+
+    std::vector<std::string> getComponents(
+        std::vector<bsoid::driver::RunRecord> const& records)
+    {
+        std::vector<std::string> components = { "total" };
+        auto add = [&components](std::string const& name)
+        {
+            if (std::find(components.begin(), components.end(), name) ==
+                components.end())
+            {
+                components.push_back(name);
+            }
+        };
+
+        for (auto& record : records)
+        {
+            for (auto& phase : record.phases)
+            {
+                add(phase.name);
+            }
+
+            for (auto& section : record.sections)
+            {
+                add(section.first);
+            }
+        }
+
+        return components;
+    }
+
+    // Fills in the relative values of one curve, whose points are sorted by
+    // thread count.
+    void analyzeCurve(std::vector<bsoid::driver::ScalingRecord>& curve,
+        bool weak)
+    {
+        auto const& base = curve.front();
+        double numerator = 0.0;
+        double denominator = 0.0;
+
+        // Least squares of T(n) = a + b / n for Amdahl's law.
+        double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+
+        for (auto& point : curve)
+        {
+            double n = static_cast<double>(point.threads) / base.threads;
+            double ratio = (point.seconds > 0.0) ?
+                base.seconds / point.seconds : 0.0;
+
+            point.speedup = weak ? n * ratio : ratio;
+            point.efficiency = point.speedup / n;
+            point.serialFraction = 0.0;
+            if (n > 1.0 && point.speedup > 0.0)
+            {
+                point.serialFraction = weak ?
+                    (n - point.speedup) / (n - 1.0) :
+                    (1.0 / point.speedup - 1.0 / n) / (1.0 - 1.0 / n);
+            }
+
+            // Gustafson: S(n) = n - alpha (n - 1).
+            numerator += (n - 1.0) * (n - point.speedup);
+            denominator += (n - 1.0) * (n - 1.0);
+
+            double x = 1.0 / n;
+            sumX += x;
+            sumY += point.seconds;
+            sumXX += x * x;
+            sumXY += x * point.seconds;
+        }
+
+        double fraction = 0.0;
+        if (weak)
+        {
+            fraction = (denominator > 0.0) ? numerator / denominator : 0.0;
+        }
+        else
+        {
+            double count = static_cast<double>(curve.size());
+            double det = count * sumXX - sumX * sumX;
+            if (det > 0.0)
+            {
+                double b = (count * sumXY - sumX * sumY) / det;
+                double a = (sumY - b * sumX) / count;
+                fraction = (a + b != 0.0) ? a / (a + b) : 0.0;
+            }
+        }
+
+        fraction = std::min(std::max(fraction, 0.0), 1.0);
+        for (auto& point : curve)
+        {
+            point.fittedSerialFraction = fraction;
+        }
+    }
+}
+
+namespace bsoid
+{
+    namespace driver
+    {
+        ScalingRecord::ScalingRecord() :
+            resolution(0),
+            svResolution(0),
+            threads(0),
+            seconds(0.0),
+            speedup(0.0),
+            efficiency(0.0),
+            serialFraction(0.0),
+            fittedSerialFraction(0.0)
+        { }
+
+        std::vector<int> getScalingThreads(std::vector<int> const& threads)
+        {
+            std::vector<int> result;
+            if (threads.size() == 1 && threads[0] == 0)
+            {
+                int max = std::max(static_cast<int>(
+                    std::thread::hardware_concurrency()), 1);
+                for (int i = 1; i < max; i *= 2)
+                {
+                    result.push_back(i);
+                }
+                result.push_back(max);
+                return result;
+            }
+
+            result = threads;
+            std::sort(result.begin(), result.end());
+            result.erase(std::unique(result.begin(), result.end()),
+                result.end());
+            return result;
+        }
+
+        std::size_t getWeakResolution(std::size_t resolution,
+            std::string const& algorithm, double scale)
+        {
+            double exponent = (algorithm == "bsoid") ? 1.0 / 2.0 : 1.0 / 3.0;
+            return static_cast<std::size_t>(std::round(
+                resolution * std::pow(scale, exponent)));
+        }
+
+        bool runScaling(Options const& options,
+            std::vector<ScalingRecord>& records)
+        {
+            bool weak = (options.scaling == "weak");
+            auto threads = getScalingThreads(options.threads);
+            if (threads.size() < 2 || threads.front() <= 0)
+            {
+                ERROR_LOG("Scaling needs at least two thread counts, none " \
+                    "of which is 0.");
+                return false;
+            }
+
+            for (auto& model : options.models)
+            {
+                for (auto& algorithm : options.algorithms)
+                {
+                    for (auto res : options.resolutions)
+                    {
+                        std::vector<std::size_t> svResolutions =
+                            options.svResolutions;
+                        if (svResolutions.empty() || algorithm == "mc")
+                        {
+                            svResolutions = { std::max<std::size_t>(
+                                res / 4, 1) };
+                        }
+
+                        for (auto svRes : svResolutions)
+                        {
+                            std::vector<RunRecord> runs;
+                            for (auto count : threads)
+                            {
+                                double scale = static_cast<double>(count) /
+                                    threads.front();
+                                std::size_t r = weak ? getWeakResolution(res,
+                                    algorithm, scale) : res;
+                                std::size_t s = std::max<std::size_t>(
+                                    svRes * r / res, 1);
+
+                                INFO_LOG_V("Scaling %s with %s at %zu/%zu " \
+                                    "on %d threads.", model.c_str(),
+                                    algorithm.c_str(), r, s, count);
+
+                                RunRecord record;
+                                for (std::size_t i = 0; i < options.warmup;
+                                    ++i)
+                                {
+                                    if (!runOnce(model, algorithm, r, s,
+                                        count, options.optimize, record))
+                                    {
+                                        return false;
+                                    }
+                                }
+
+                                for (std::size_t i = 0; i < std::max<
+                                    std::size_t>(options.reps, 1); ++i)
+                                {
+                                    record = RunRecord();
+                                    if (!runOnce(model, algorithm, r, s,
+                                        count, options.optimize, record))
+                                    {
+                                        return false;
+                                    }
+                                    record.rep = i;
+                                    runs.push_back(record);
+                                }
+                            }
+
+                            for (auto& component : getComponents(runs))
+                            {
+                                std::vector<ScalingRecord> curve;
+                                for (auto count : threads)
+                                {
+                                    ScalingRecord point;
+                                    std::vector<double> seconds;
+                                    for (auto& run : runs)
+                                    {
+                                        double t = getComponentSeconds(run,
+                                            component);
+                                        if (run.threads == count && t >= 0.0)
+                                        {
+                                            point.resolution = run.resolution;
+                                            point.svResolution =
+                                                run.svResolution;
+                                            seconds.push_back(t);
+                                        }
+                                    }
+
+                                    if (seconds.empty())
+                                    {
+                                        continue;
+                                    }
+
+                                    point.model = model;
+                                    point.algorithm = algorithm;
+                                    point.threads = count;
+                                    point.component = component;
+                                    point.seconds = median(seconds);
+                                    curve.push_back(point);
+                                }
+
+                                if (curve.empty())
+                                {
+                                    continue;
+                                }
+
+                                analyzeCurve(curve, weak);
+                                INFO_LOG_V("%s with %s, %s: speedup %.2f " \
+                                    "on %d threads, serial fraction %.3f.",
+                                    model.c_str(), algorithm.c_str(),
+                                    component.c_str(), curve.back().speedup,
+                                    curve.back().threads,
+                                    curve.back().fittedSerialFraction);
+                                records.insert(records.end(), curve.begin(),
+                                    curve.end());
+                            }
+                        }
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        void writeScalingCsv(std::vector<ScalingRecord> const& records,
+            std::ostream& out)
+        {
+            out << "model,algorithm,resolution,sv_resolution,threads," \
+                "component,seconds,speedup,efficiency,serial_fraction," \
+                "fitted_serial_fraction\n";
+            for (auto& record : records)
+            {
+                out << record.model << "," << record.algorithm << "," <<
+                    record.resolution << "," << record.svResolution << "," <<
+                    record.threads << "," << record.component << "," <<
+                    record.seconds << "," << record.speedup << "," <<
+                    record.efficiency << "," << record.serialFraction << "," <<
+                    record.fittedSerialFraction << "\n";
+            }
+        }
+
+        void writeScalingJson(std::vector<ScalingRecord> const& records,
+            std::string const& mode, std::ostream& out)
+        {
+            out << "{\n";
+            out << "  \"version\": \"" << BSOID_VERSION_STRING << "\",\n";
+            out << "  \"scaling\": \"" << mode << "\",\n";
+            out << "  \"points\": [";
+
+            for (std::size_t i = 0; i < records.size(); ++i)
+            {
+                auto const& record = records[i];
+                out << ((i == 0) ? "\n" : ",\n");
+                out << "    { \"model\": \"" << record.model << "\", " <<
+                    "\"algorithm\": \"" << record.algorithm << "\", " <<
+                    "\"resolution\": " << record.resolution << ", " <<
+                    "\"sv_resolution\": " << record.svResolution << ", " <<
+                    "\"threads\": " << record.threads << ",\n";
+                out << "      \"component\": \"" << record.component <<
+                    "\", " << "\"seconds\": " << record.seconds << ", " <<
+                    "\"speedup\": " << record.speedup << ", " <<
+                    "\"efficiency\": " << record.efficiency << ",\n";
+                out << "      \"serial_fraction\": " <<
+                    record.serialFraction << ", " <<
+                    "\"fitted_serial_fraction\": " <<
+                    record.fittedSerialFraction << " }";
+            }
+
+            out << "\n  ]\n";
+            out << "}\n";
+        }
+    }
+}
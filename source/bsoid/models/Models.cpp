@@ -11,11 +11,12 @@
 #include "bsoid/tree/BlobTree.hpp"
 #include "bsoid/polygonizer/Bsoid.hpp"
 
+#include <atlas/core/Log.hpp>
 #include <atlas/math/RandomGenerator.hpp>
 
 #include <tuple>
 #include <numeric>
-#include <chrono>
+#include <utility>
 
 namespace bsoid
 {
@@ -28,7 +29,7 @@ namespace bsoid
         using polygonizer::Bsoid;
         using polygonizer::MarchingCubes;
 
-        polygonizer::Bsoid makeSphere(Resolution const& res)
+        tree::BlobTree makeSphereTree()
         {
             using fields::Sphere;
 
@@ -39,7 +40,12 @@ namespace bsoid
             tree.insertFieldTree(sphere);
             tree.insertSkeletalField(sphere);
 
-            Bsoid soid(tree, "sphere");
+            return tree;
+        }
+
+        polygonizer::Bsoid makeSphere(Resolution const& res)
+        {
+            Bsoid soid(makeSphereTree(), "sphere");
             soid.setResolution(std::get<0>(res),
                 std::get<1>(res));
             return soid;
@@ -47,21 +53,12 @@ namespace bsoid
 
         polygonizer::MarchingCubes makeMCSphere(Resolution const& res)
         {
-            using fields::Sphere;
-
-            ImplicitFieldPtr sphere = std::make_shared<Sphere>();
-            BlobTree tree;
-            tree.insertField(sphere);
-            tree.insertNodeTree({ { -1 } });
-            tree.insertFieldTree(sphere);
-            tree.insertSkeletalField(sphere);
-
-            MarchingCubes mc(tree, "sphere");
+            MarchingCubes mc(makeSphereTree(), "sphere");
             mc.setResolution(std::get<0>(res));
             return mc;
         }
 
-        polygonizer::Bsoid makeTorus(Resolution const& res)
+        tree::BlobTree makeTorusTree()
         {
             using atlas::math::Point;
             using fields::Torus;
@@ -73,7 +70,12 @@ namespace bsoid
             tree.insertFieldTree(torus);
             tree.insertSkeletalField(torus);
 
-            Bsoid soid(tree, "torus");
+            return tree;
+        }
+
+        polygonizer::Bsoid makeTorus(Resolution const& res)
+        {
+            Bsoid soid(makeTorusTree(), "torus");
             soid.setResolution(std::get<0>(res),
                 std::get<1>(res));
             return soid;
@@ -81,22 +83,12 @@ namespace bsoid
 
         polygonizer::MarchingCubes makeMCTorus(Resolution const& res)
         {
-            using atlas::math::Point;
-            using fields::Torus;
-
-            ImplicitFieldPtr torus = std::make_shared<Torus>();
-            BlobTree tree;
-            tree.insertField(torus);
-            tree.insertNodeTree({ { -1 } });
-            tree.insertFieldTree(torus);
-            tree.insertSkeletalField(torus);
-
-            MarchingCubes mc(tree, "torus");
+            MarchingCubes mc(makeTorusTree(), "torus");
             mc.setResolution(std::get<0>(res));
             return mc;
         }
 
-        polygonizer::Bsoid makeBlend(Resolution const& res)
+        tree::BlobTree makeBlendTree()
         {
             using atlas::math::Point;
             using fields::Sphere;
@@ -115,7 +107,12 @@ namespace bsoid
             tree.insertFieldTree(blend);
             tree.insertSkeletalFields({ sphere1, sphere2 });
 
-            Bsoid soid(tree, "blend");
+            return tree;
+        }
+
+        polygonizer::Bsoid makeBlend(Resolution const& res)
+        {
+            Bsoid soid(makeBlendTree(), "blend");
             soid.setResolution(std::get<0>(res),
                 std::get<1>(res));
             return soid;
@@ -123,30 +120,12 @@ namespace bsoid
 
         polygonizer::MarchingCubes makeMCBlend(Resolution const& res)
         {
-            using atlas::math::Point;
-            using fields::Sphere;
-            using operators::Blend;
-
-            ImplicitFieldPtr sphere1 =
-                std::make_shared<Sphere>(1.0f, Point(1.0f, 0, 0));
-            ImplicitFieldPtr sphere2 =
-                std::make_shared<Sphere>(1.0f, Point(-1.0f, 0, 0));
-            ImplicitOperatorPtr blend = std::make_shared<Blend>();
-            blend->insertFields({ sphere1, sphere2 });
-
-            BlobTree tree;
-            tree.insertFields({ sphere1, sphere2, blend });
-            tree.insertNodeTree({ { -1 }, { -1 }, { 0, 1 } });
-            tree.insertFieldTree(blend);
-            tree.insertSkeletalFields({ sphere1, sphere2 });
-
-            MarchingCubes mc(tree, "blend");
+            MarchingCubes mc(makeBlendTree(), "blend");
             mc.setResolution(std::get<0>(res));
-
             return mc;
         }
 
-        polygonizer::Bsoid makeIntersection(Resolution const& res)
+        tree::BlobTree makeIntersectionTree()
         {
             using atlas::math::Point;
             using fields::Sphere;
@@ -165,8 +144,12 @@ namespace bsoid
             tree.insertFieldTree(intersection);
             tree.insertSkeletalFields({ sphere1, sphere2 });
 
+            return tree;
+        }
 
-            Bsoid soid(tree, "intersection");
+        polygonizer::Bsoid makeIntersection(Resolution const& res)
+        {
+            Bsoid soid(makeIntersectionTree(), "intersection");
             soid.setResolution(std::get<0>(res),
                 std::get<1>(res));
             return soid;
@@ -174,30 +157,12 @@ namespace bsoid
 
         polygonizer::MarchingCubes makeMCIntersection(Resolution const& res)
         {
-            using atlas::math::Point;
-            using fields::Sphere;
-            using operators::Intersection;
-
-            ImplicitFieldPtr sphere1 =
-                std::make_shared<Sphere>(1.0f, Point(0.5f, 0, 0));
-            ImplicitFieldPtr sphere2 =
-                std::make_shared<Sphere>(1.0f, Point(-0.5f, 0, 0));
-            ImplicitOperatorPtr intersection = std::make_shared<Intersection>();
-            intersection->insertFields({ sphere1, sphere2 });
-
-            BlobTree tree;
-            tree.insertFields({ sphere1, sphere2, intersection });
-            tree.insertNodeTree({ { -1 }, { -1 }, { 0, 1 } });
-            tree.insertFieldTree(intersection);
-            tree.insertSkeletalFields({ sphere1, sphere2 });
-
-            MarchingCubes mc(tree, "intersection");
+            MarchingCubes mc(makeIntersectionTree(), "intersection");
             mc.setResolution(std::get<0>(res));
-
             return mc;
         }
 
-        polygonizer::Bsoid makeUnion(Resolution const& res)
+        tree::BlobTree makeUnionTree()
         {
             using atlas::math::Point;
             using fields::Sphere;
@@ -216,7 +181,12 @@ namespace bsoid
             tree.insertFieldTree(op);
             tree.insertSkeletalFields({ sphere1, sphere2 });
 
-            Bsoid soid(tree, "union");
+            return tree;
+        }
+
+        polygonizer::Bsoid makeUnion(Resolution const& res)
+        {
+            Bsoid soid(makeUnionTree(), "union");
             soid.setResolution(std::get<0>(res),
                 std::get<1>(res));
             return soid;
@@ -224,29 +194,12 @@ namespace bsoid
 
         polygonizer::MarchingCubes makeMCUnion(Resolution const& res)
         {
-            using atlas::math::Point;
-            using fields::Sphere;
-            using operators::Union;
-
-            ImplicitFieldPtr sphere1 =
-                std::make_shared<Sphere>(1.0f, Point(0.5f, 0, 0));
-            ImplicitFieldPtr sphere2 =
-                std::make_shared<Sphere>(1.0f, Point(-0.5f, 0, 0));
-            ImplicitOperatorPtr op = std::make_shared<Union>();
-            op->insertFields({ sphere1, sphere2 });
-
-            BlobTree tree;
-            tree.insertFields({ sphere1, sphere2, op });
-            tree.insertNodeTree({ { -1 }, { -1 }, { 0, 1 } });
-            tree.insertFieldTree(op);
-            tree.insertSkeletalFields({ sphere1, sphere2 });
-
-            MarchingCubes mc(tree, "union");
+            MarchingCubes mc(makeUnionTree(), "union");
             mc.setResolution(std::get<0>(res));
             return mc;
         }
 
-        polygonizer::Bsoid makeTransform(Resolution const& res)
+        tree::BlobTree makeTransformTree()
         {
             using atlas::math::Matrix4;
             using atlas::math::Vector;
@@ -268,7 +221,12 @@ namespace bsoid
             tree.insertFieldTree(op);
             tree.insertSkeletalField(torus);
 
-            Bsoid soid(tree, "transform");
+            return tree;
+        }
+
+        polygonizer::Bsoid makeTransform(Resolution const& res)
+        {
+            Bsoid soid(makeTransformTree(), "transform");
             soid.setResolution(std::get<0>(res),
                 std::get<1>(res));
             return soid;
@@ -276,32 +234,12 @@ namespace bsoid
 
         polygonizer::MarchingCubes makeMCTransform(Resolution const& res)
         {
-            using atlas::math::Matrix4;
-            using atlas::math::Vector;
-            using fields::Torus;
-            using operators::Transform;
-
-            ImplicitFieldPtr torus =
-                std::make_shared<Torus>();
-            ImplicitOperatorPtr op = std::make_shared<Transform>(
-                glm::translate(Matrix4(1.0f), Vector(0.0f, 0.0f, 3.0f)) * 
-                glm::rotate(Matrix4(1.0f), glm::radians(90.0f), Vector(1, 0, 0)) * 
-                glm::scale(Matrix4(1.0f), Vector(0.5f)) * 
-                glm::scale(Matrix4(1.0f), Vector(2.5f, 1.0f, 1.0f)));
-            op->insertField(torus);
-
-            BlobTree tree;
-            tree.insertFields({ op });
-            tree.insertNodeTree({ { -1 } });
-            tree.insertFieldTree(op);
-            tree.insertSkeletalField(torus);
-
-            MarchingCubes mc(tree, "transform");
+            MarchingCubes mc(makeTransformTree(), "transform");
             mc.setResolution(std::get<0>(res));
             return mc;
         }
 
-        polygonizer::Bsoid makeButterfly(Resolution const& res)
+        tree::BlobTree makeButterflyTree()
         {
             using atlas::math::Matrix4;
             using atlas::math::Vector;
@@ -368,7 +306,12 @@ namespace bsoid
             tree.insertFieldTree(butterfly);
             tree.insertSkeletalFields({ sphere, torus });
 
-            Bsoid soid(tree, "butterfly");
+            return tree;
+        }
+
+        polygonizer::Bsoid makeButterfly(Resolution const& res)
+        {
+            Bsoid soid(makeButterflyTree(), "butterfly");
             soid.setResolution(std::get<0>(res),
                 std::get<1>(res));
             return soid;
@@ -376,77 +319,12 @@ namespace bsoid
 
         polygonizer::MarchingCubes makeMCButterfly(Resolution const& res)
         {
-            using atlas::math::Matrix4;
-            using atlas::math::Vector;
-
-            using fields::Torus;
-            using fields::Sphere;
-
-            using operators::Blend;
-            using operators::Transform;
-            using operators::Union;
-
-            // Base primitives.
-            ImplicitFieldPtr sphere = std::make_shared<Sphere>();
-            ImplicitFieldPtr torus = std::make_shared<Torus>();
-
-            // Butterfly body.
-            ImplicitOperatorPtr head = std::make_shared<Transform>(
-                glm::translate(Matrix4(1.0f), Vector(-1.0f, 0.0f, 0.0f)));
-            ImplicitOperatorPtr torso = std::make_shared<Transform>(
-                glm::translate(Matrix4(1.0f), Vector(1.0f, 0.0f, 0.0f)) *
-                glm::scale(Matrix4(1.0f), Vector(2.0f, 1.0f, 1.0f)));
-            ImplicitOperatorPtr tail = std::make_shared<Transform>(
-                glm::translate(Matrix4(1.0f), Vector(3.0f, 0.0f, 0.0f)) *
-                glm::scale(Matrix4(1.0f), Vector(4.0f, 1.0f, 1.0f)));
-
-            head->insertField(sphere);
-            torso->insertField(sphere);
-            tail->insertField(sphere);
-
-            ImplicitOperatorPtr body = std::make_shared<Union>();
-            body->insertFields({ head, torso, tail });
-
-            // Now make the wings.
-            ImplicitOperatorPtr topWing = std::make_shared<Transform>(
-                glm::translate(Matrix4(1.0f), Vector(0.0f, 0.0f, 3.0f)) *
-                glm::rotate(Matrix4(1.0f), glm::radians(90.0f), Vector(1, 0, 0)) * 
-                glm::rotate(Matrix4(1.0f), glm::radians(45.0f), Vector(0, 0, -1)) * 
-                glm::scale(Matrix4(1.0f), Vector(0.5f)) *
-                glm::scale(Matrix4(1.0f), Vector(2.5f, 1.0f, 1.0f)));
-
-            ImplicitOperatorPtr bottomWing = std::make_shared<Transform>(
-                glm::translate(Matrix4(1.0f), Vector(3.0f, 0.0f, 2.5f)) *
-                glm::rotate(Matrix4(1.0f), glm::radians(-90.0f), Vector(1, 0, 0)) *
-                glm::rotate(Matrix4(1.0f), glm::radians(-90.0f), Vector(0, 0, -1)) *
-                glm::scale(Matrix4(1.0f), Vector(0.5f)) *
-                glm::scale(Matrix4(1.0f), Vector(2.0f, 1.0f, 1.0f)));
-
-            topWing->insertField(torus);
-            bottomWing->insertField(torus);
-
-            ImplicitOperatorPtr wingR = std::make_shared<Blend>();
-            wingR->insertFields({ topWing, bottomWing });
-
-            ImplicitOperatorPtr wingL = std::make_shared<Transform>(
-                glm::rotate(Matrix4(1.0f), glm::radians(180.0f), Vector(1, 0, 0)));
-            wingL->insertField(wingR);
-
-            ImplicitOperatorPtr butterfly = std::make_shared<Union>();
-            butterfly->insertFields({ body, wingR, wingL });
-
-            BlobTree tree;
-            tree.insertFields({ body, wingR, wingL, butterfly });
-            tree.insertNodeTree({ { -1 }, { -1 }, { -1 }, { 0, 1, 2 } });
-            tree.insertFieldTree(butterfly);
-            tree.insertSkeletalFields({ sphere, torus });
-
-            MarchingCubes mc(tree, "butterfly");
+            MarchingCubes mc(makeButterflyTree(), "butterfly");
             mc.setResolution(std::get<0>(res));
             return mc;
         }
 
-        bsoid::polygonizer::Bsoid makeParticles(Resolution const& res)
+        tree::BlobTree makeParticlesTree()
         {
             using atlas::math::Matrix4;
             using atlas::math::Vector;
@@ -455,8 +333,6 @@ namespace bsoid
             using operators::Blend;
             using atlas::math::RandomGenerator;
 
-            auto seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-
             RandomGenerator<float> random{ 2018 };
             static constexpr auto numParticles = 100;
             static constexpr auto maxVal = 10.0f;
@@ -488,60 +364,25 @@ namespace bsoid
             tree.insertNodeTree(nodes);
             tree.insertFieldTree(blend);
 
-            Bsoid soid(tree, "particles");
-            soid.setResolution(std::get<0>(res), 
+            return tree;
+        }
+
+        polygonizer::Bsoid makeParticles(Resolution const& res)
+        {
+            Bsoid soid(makeParticlesTree(), "particles");
+            soid.setResolution(std::get<0>(res),
                 std::get<1>(res));
             return soid;
         }
 
-        bsoid::polygonizer::MarchingCubes makeMCParticles(Resolution const& res)
+        polygonizer::MarchingCubes makeMCParticles(Resolution const& res)
         {
-            using atlas::math::Matrix4;
-            using atlas::math::Vector;
-
-            using fields::Sphere;
-            using operators::Blend;
-            using atlas::math::RandomGenerator;
-
-//            auto seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-            RandomGenerator<float> random{ 2018 };
-            static constexpr auto numParticles = 100;
-            static constexpr auto maxVal = 10.0f;
-            static constexpr auto minVal = -10.0f;
-            std::vector<bsoid::fields::ImplicitFieldPtr> particles;
-            std::vector<std::vector<int>> nodes;
-            for (int i = 0; i < numParticles; ++i)
-            {
-                float x = random.getRandomReal(minVal, maxVal);
-                float y = random.getRandomReal(minVal, maxVal);
-                float z = random.getRandomReal(minVal, maxVal);
-
-                particles.emplace_back(std::make_shared<Sphere>(1.0f,
-                    Vector(x, y, z)));
-                nodes.push_back({ -1 });
-                printf("%d: %f%f%f\n",i,x,y,z);
-            }
-
-            ImplicitOperatorPtr blend = std::make_shared<Blend>();
-            blend->insertFields(particles);
-            std::vector<int> parent(nodes.size());
-            std::iota(parent.begin(), parent.end(), 0);
-            nodes.push_back(parent);
-
-            BlobTree tree;
-            tree.insertSkeletalFields(particles);
-
-            particles.push_back(blend);
-            tree.insertFields(particles);
-            tree.insertNodeTree(nodes);
-            tree.insertFieldTree(blend);
-
-            MarchingCubes mc(tree, "particles");
+            MarchingCubes mc(makeParticlesTree(), "particles");
             mc.setResolution(std::get<0>(res));
             return mc;
         }
 
-        bsoid::polygonizer::Bsoid makeChain(Resolution const& res)
+        tree::BlobTree makeChainTree()
         {
             using atlas::math::Point;
             using fields::Sphere;
@@ -574,49 +415,77 @@ namespace bsoid
             tree.insertNodeTree(nodes);
             tree.insertFieldTree(blend);
 
-            Bsoid soid(tree, "chain");
+            return tree;
+        }
+
+        polygonizer::Bsoid makeChain(Resolution const& res)
+        {
+            Bsoid soid(makeChainTree(), "chain");
             soid.setResolution(std::get<0>(res),
                 std::get<1>(res));
             return soid;
         }
 
-        bsoid::polygonizer::MarchingCubes makeMCChain(Resolution const& res)
+        polygonizer::MarchingCubes makeMCChain(Resolution const& res)
         {
-            using atlas::math::Point;
-            using fields::Sphere;
-            using operators::Blend;
+            MarchingCubes mc(makeChainTree(), "chain");
+            mc.setResolution(std::get<0>(res));
+            return mc;
+        }
 
-            static constexpr auto chainLength = 20;
+        namespace
+        {
+            using TreeFn = tree::BlobTree(*)();
 
-            std::vector<ImplicitFieldPtr> chain;
-            std::vector<std::vector<int>> nodes;
-            for (int i = 0; i < chainLength; ++i)
+            std::vector<std::pair<std::string, TreeFn>> const& getRegistry()
             {
-                chain.emplace_back(std::make_shared<Sphere>(1.0f,
-                    Point(-10.0f + 2.0f * i, 0, 0)));
-
-                nodes.push_back({ -1 });
+                static const std::vector<std::pair<std::string, TreeFn>>
+                    registry =
+                {
+                    { "sphere", makeSphereTree },
+                    { "torus", makeTorusTree },
+                    { "blend", makeBlendTree },
+                    { "intersection", makeIntersectionTree },
+                    { "union", makeUnionTree },
+                    { "transform", makeTransformTree },
+                    { "butterfly", makeButterflyTree },
+                    { "particles", makeParticlesTree },
+                    { "chain", makeChainTree }
+                };
+
+                return registry;
             }
+        }
 
-            ImplicitOperatorPtr blend = std::make_shared<Blend>();
-            blend->insertFields(chain);
-
-            std::vector<int> roots(chainLength);
-            std::iota(roots.begin(), roots.end(), 0);
-            nodes.push_back(roots);
+        std::vector<std::string> getModelNames()
+        {
+            std::vector<std::string> names;
+            for (auto& entry : getRegistry())
+            {
+                names.push_back(entry.first);
+            }
 
-            BlobTree tree;
-            tree.insertSkeletalFields(chain);
+            return names;
+        }
 
-            chain.push_back(blend);
-            tree.insertFields(chain);
-            tree.insertNodeTree(nodes);
-            tree.insertFieldTree(blend);
+        bool makeModelTree(std::string const& name, tree::BlobTree& tree)
+        {
+            for (auto& entry : getRegistry())
+            {
+                if (entry.first == name)
+                {
+                    tree = entry.second();
+                    return true;
+                }
+            }
 
+            if (!BlobTree::fromFile(name, tree))
+            {
+                ERROR_LOG_V("Unknown model or snapshot: %s.", name.c_str());
+                return false;
+            }
 
-            MarchingCubes mc(tree, "chain");
-            mc.setResolution(std::get<0>(res));
-            return mc;
+            return true;
         }
     }
 }
@@ -1,37 +1,84 @@
 #include "bsoid/polygonizer/Bsoid.hpp"
 #include "bsoid/polygonizer/Hash.hpp"
 #include "bsoid/polygonizer/Tables.hpp"
+#include "bsoid/polygonizer/MeshSink.hpp"
+#include "bsoid/operators/ImplicitOperator.hpp"
 
 #include <atlas/core/Timer.hpp>
 #include <atlas/core/Macros.hpp>
 #include <atlas/core/Assert.hpp>
 #include <atlas/core/Log.hpp>
 #include <atlas/core/Float.hpp>
+#include <atlas/core/Profiler.hpp>
+#include <atlas/core/Memory.hpp>
+#include <atlas/utils/MeshOptimizer.hpp>
 
 #include <numeric>
 #include <functional>
 #include <unordered_set>
 #include <fstream>
 #include <queue>
+#include <algorithm>
+#include <tuple>
 
 #include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
 #include <glm/gtx/component_wise.hpp>
 
 #define DISABLE_PARALLEL 0
 
+namespace
+{
+    // The corners joined by each of the 12 edges of the edge table.
+    const int TriangleEdges[12][2] =
+    {
+        { 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 },
+        { 4, 5 }, { 5, 6 }, { 6, 7 }, { 7, 4 },
+        { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }
+    };
+
+    // Number of fields in the tree rooted at the given field.
+    std::size_t countFields(bsoid::fields::ImplicitFieldPtr const& field)
+    {
+        std::size_t count = 1;
+        auto op = std::dynamic_pointer_cast<
+            bsoid::operators::ImplicitOperator>(field);
+        if (op)
+        {
+            for (auto& child : op->getFields())
+            {
+                count += countFields(child);
+            }
+        }
+
+        return count;
+    }
+}
 
 namespace bsoid
 {
     namespace polygonizer
     {
         Bsoid::Bsoid() :
+            mVoxels(&mMemory),
+            mSeenVoxels(&mMemory),
+            mSeenPoints(&mMemory),
+            mSuperVoxels(&mMemory),
+            mComputedPoints(&mMemory),
+            mProgress(nullptr),
             mName("model")
         { }
 
         Bsoid::Bsoid(tree::BlobTree const& model, std::string const& name,
             float isoValue) :
             mMagic(isoValue),
+            mVoxels(&mMemory),
+            mSeenVoxels(&mMemory),
+            mSeenPoints(&mMemory),
+            mSuperVoxels(&mMemory),
+            mComputedPoints(&mMemory),
             mTree(std::make_unique<tree::BlobTree>(model)),
+            mProgress(nullptr),
             mName(name)
         { }
 
@@ -43,9 +90,17 @@ namespace bsoid
             mGridSize(b.mGridSize),
             mSvSize(b.mSvSize),
             mMagic(b.mMagic),
+            mVoxels(&mMemory),
+            mSeenVoxels(&mMemory),
+            mSeenPoints(&mMemory),
+            mSuperVoxels(&mMemory),
+            mComputedPoints(&mMemory),
             mLattice(std::move(b.mLattice)),
             mTree(std::move(b.mTree)),
             mMesh(std::move(b.mMesh)),
+            mChunks(std::move(b.mChunks)),
+            mStats(std::move(b.mStats)),
+            mProgress(b.mProgress),
             mLog(std::move(b.mLog)),
             mName(b.mName)
         { }
@@ -90,14 +145,33 @@ namespace bsoid
         
         void Bsoid::constructMesh()
         {
-            makeTriangles();
+            MemoryMeshSink sink(mMesh, mChunks);
+            constructMesh(sink);
+        }
+
+        void Bsoid::constructMesh(MeshSink& sink)
+        {
+            sink.begin();
+            makeTriangles(sink);
+            sink.end();
         }
 
         void Bsoid::polygonize()
+        {
+            MemoryMeshSink sink(mMesh, mChunks);
+            polygonize(sink);
+            optimizeMesh();
+        }
+
+        void Bsoid::polygonize(MeshSink& sink)
         {
             using atlas::core::Timer;
 
+            PROFILE_ZONE("Bsoid::polygonize");
             Timer<float> global;
+            mStats = PolygonizerStats();
+            mCounters.clear();
+            auto evaluations = mTree->getEvaluationCount();
 
             mLog << "Polygonizing model: " << mName << "\n";
             mLog << "Resolution: " << std::to_string(mGridSize) << ", "
@@ -109,23 +183,34 @@ namespace bsoid
             // Generate lattices.
             {
                 Timer<float> section;
+                beginPhase();
                 section.start();
                 makeVoxels();
+                endPhase("voxels", section.elapsed());
             }
             INFO_LOG("Bsoid: Lattice generation done.");
 
             INFO_LOG("Bsoid: Starting mesh generation.");
+            std::size_t numVertices = 0;
             {
                 Timer<float> section;
+                beginPhase();
                 section.start();
-                constructMesh();
+                sink.begin();
+                numVertices = makeTriangles(sink);
+                sink.end();
+                endPhase("triangles", section.elapsed());
             }
             INFO_LOG("Bsoid: Mesh generation done.");
 
             mLog << "\nSummary:\n";
             mLog << "#===========================#\n";
+            mStats.evaluations = mTree->getEvaluationCount() - evaluations;
+            mStats.vertices = numVertices;
+            recordCounters();
+
             mLog << "Total runtime: " << global.elapsed() << " seconds\n";
-            mLog << "Total vertices generated: " << mMesh.vertices().size() << "\n";
+            mLog << "Total vertices generated: " << numVertices << "\n";
             mLog << "Total memory usage: " << size() << " bytes\n";
             mLog << mTree->getFieldSummary();
         }
@@ -135,11 +220,51 @@ namespace bsoid
             return mLattice;
         }
 
+        void Bsoid::optimizeMesh()
+        {
+            using atlas::core::Timer;
+            using atlas::utils::computeACMR;
+
+            PROFILE_ZONE("Bsoid::optimizeMesh");
+            Timer<float> timer;
+            beginPhase();
+            timer.start();
+            INFO_LOG("Bsoid: Starting mesh optimization.");
+            if (mProgress)
+            {
+                mProgress->beginStep("optimize", 0);
+            }
+            float before = computeACMR(mMesh.indices());
+            auto offsets = getChunkOffsets(mChunks, mMesh.indices().size());
+            if (offsets.empty())
+            {
+                atlas::utils::optimizeVertexCache(mMesh);
+            }
+            else
+            {
+                atlas::utils::optimizeVertexCache(mMesh, offsets);
+            }
+            atlas::utils::optimizeVertexFetch(mMesh);
+            float after = computeACMR(mMesh.indices());
+            INFO_LOG_V("Bsoid: Mesh optimization done. ACMR: %f -> %f.", before,
+                after);
+
+            float elapsed = timer.elapsed();
+            endPhase("optimize", elapsed);
+            mLog << "Vertex cache ACMR: " << before << " -> " << after <<
+                " (" << elapsed << " seconds)\n";
+        }
+
         atlas::utils::Mesh& Bsoid::getMesh()
         {
             return mMesh;
         }
 
+        std::vector<MeshChunkRange>& Bsoid::getChunks()
+        {
+            return mChunks;
+        }
+
         void Bsoid::setName(std::string const& name)
         {
             mName = name;
@@ -155,30 +280,196 @@ namespace bsoid
             return mLog.str();
         }
 
+        PolygonizerStats const& Bsoid::getStats() const
+        {
+            return mStats;
+        }
+
+        void Bsoid::setProgress(Progress* progress)
+        {
+            mProgress = progress;
+        }
+
+        void Bsoid::beginPhase()
+        {
+            mMemory.reset();
+            atlas::core::resetPeakRSS();
+
+            // Created for every phase so it watches the arena the phase runs
+            // in.
+            mObserver.reset();
+            if (utilization::isEnabled())
+            {
+                mObserver = std::make_unique<UtilizationObserver>();
+                mObserver->beginPhase();
+            }
+        }
+
+        void Bsoid::endPhase(std::string const& name, double seconds)
+        {
+            PhaseStats phase;
+            phase.name = name;
+            phase.seconds = seconds;
+            phase.bytes = mMemory.getCurrent();
+            phase.peakBytes = mMemory.getPeak();
+            phase.allocations = mMemory.getAllocations();
+            phase.rss = atlas::core::getCurrentRSS();
+            phase.peakRSS = atlas::core::getPeakRSS();
+            if (mObserver)
+            {
+                mObserver->endPhase(phase);
+                mObserver.reset();
+            }
+            mStats.phases.push_back(phase);
+
+            mLog << "Phase " << name << ": " << seconds << " seconds, " <<
+                phase.bytes << " bytes (peak " << phase.peakBytes << "), " <<
+                phase.allocations << " allocations, RSS " << phase.rss <<
+                " bytes (peak " << phase.peakRSS << ")\n";
+            writeUtilization(phase, mLog);
+        }
+
+        void Bsoid::countEvaluation(Counters& counters, SuperVoxel const& sv)
+        {
+            if (counters.svEvaluations.empty())
+            {
+                counters.svEvaluations.resize(mSuperVoxels.size(), 0);
+            }
+            ++counters.svEvaluations[sv.index];
+        }
+
+        void Bsoid::recordCounters()
+        {
+            Counters total;
+            for (auto& counters : mCounters)
+            {
+                total.pointHits += counters.pointHits;
+                total.pointMisses += counters.pointMisses;
+                total.redundantPoints += counters.redundantPoints;
+                total.edgeHits += counters.edgeHits;
+                total.edgeMisses += counters.edgeMisses;
+                total.redundantEdges += counters.redundantEdges;
+                total.voxelsVisited += counters.voxelsVisited;
+                total.voxelsRevisited += counters.voxelsRevisited;
+                total.voxelsAccepted += counters.voxelsAccepted;
+            }
+
+            mStats.counters =
+            {
+                { "point_hits", total.pointHits },
+                { "point_misses", total.pointMisses },
+                { "redundant_points", total.redundantPoints },
+                { "edge_hits", total.edgeHits },
+                { "edge_misses", total.edgeMisses },
+                { "redundant_edges", total.redundantEdges },
+                { "voxels_visited", total.voxelsVisited },
+                { "voxels_revisited", total.voxelsRevisited },
+                { "voxels_accepted", total.voxelsAccepted },
+                { "supervoxels", mSuperVoxels.size() }
+            };
+
+            auto hitRate = [](std::uint64_t hits, std::uint64_t misses)
+            {
+                auto total = hits + misses;
+                return (total > 0) ? 100.0 * hits / total : 0.0;
+            };
+
+            mLog << "Corner cache: " << total.pointHits << " hits, " <<
+                total.pointMisses << " misses (" <<
+                hitRate(total.pointHits, total.pointMisses) << "% hits), " <<
+                total.redundantPoints << " redundant evaluations\n";
+            mLog << "Edge cache: " << total.edgeHits << " hits, " <<
+                total.edgeMisses << " misses (" <<
+                hitRate(total.edgeHits, total.edgeMisses) << "% hits), " <<
+                total.redundantEdges << " redundant evaluations\n";
+            mLog << "Voxels: " << total.voxelsVisited << " visited, " <<
+                total.voxelsRevisited << " revisited, " <<
+                total.voxelsAccepted << " accepted\n";
+        }
+
+        std::vector<SuperVoxelStats> Bsoid::getSuperVoxelStats() const
+        {
+            std::unordered_map<std::uint64_t, SuperVoxelStats> stats;
+            for (auto& entry : mSuperVoxels)
+            {
+                SuperVoxelStats sv;
+                sv.x = entry.second.id.x;
+                sv.y = entry.second.id.y;
+                sv.z = entry.second.id.z;
+                sv.fields = entry.second.fieldCount;
+                for (auto& counters : mCounters)
+                {
+                    if (!counters.svEvaluations.empty())
+                    {
+                        sv.evaluations +=
+                            counters.svEvaluations[entry.second.index];
+                    }
+                }
+                stats.insert({ entry.first, sv });
+            }
+
+            // Voxels are assigned to supervoxels the same way as in
+            // makeTriangles.
+            for (auto& voxel : mVoxels)
+            {
+                auto sv = stats.find(voxel.points[0].svHash);
+                if (sv != stats.end())
+                {
+                    ++sv->second.voxels;
+                }
+            }
+
+            std::vector<SuperVoxelStats> result;
+            result.reserve(stats.size());
+            for (auto& entry : stats)
+            {
+                result.push_back(entry.second);
+            }
+
+            std::sort(result.begin(), result.end(),
+                [](SuperVoxelStats const& a, SuperVoxelStats const& b)
+            {
+                return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+            });
+
+            return result;
+        }
+
+        bool Bsoid::saveSuperVoxelHeatmap(std::string const& filename) const
+        {
+            std::ofstream file(filename);
+            if (!file)
+            {
+                ERROR_LOG_V("Could not open %s for writing.",
+                    filename.c_str());
+                return false;
+            }
+
+            file << "x,y,z,evaluations,fields,voxels\n";
+            for (auto& sv : getSuperVoxelStats())
+            {
+                file << sv.x << "," << sv.y << "," << sv.z << "," <<
+                    sv.evaluations << "," << sv.fields << "," << sv.voxels <<
+                    "\n";
+            }
+
+            return static_cast<bool>(file);
+        }
+
         void Bsoid::clearLog()
         {
             mLog.str(std::string());
         }
 
-        void Bsoid::saveMesh()
+        void Bsoid::saveMesh(atlas::utils::MeshFormat format)
         {
-            mMesh.saveToFile(mName + ".obj");
+            mMesh.saveToFile(mName + atlas::utils::getFormatExtension(format),
+                format);
         }
 
         std::size_t Bsoid::size() const
         {
-            std::size_t voxelSize = mVoxels.size() * sizeof(Voxel);
-            std::size_t seenVoxelSize = mSeenVoxels.size() *
-                sizeof(std::pair<std::uint64_t, VoxelId>);
-            std::size_t seenPointsSize = mSeenPoints.size() *
-                sizeof(std::pair<std::uint64_t, VoxelId>);
-            std::size_t svSize = mSuperVoxels.size() *
-                sizeof(std::pair<std::uint64_t, VoxelId>);
-            std::size_t computedSize = mComputedPoints.size() *
-                sizeof(std::pair<std::uint128_t, LinePoint>);
-
-            return voxelSize + seenVoxelSize + seenPointsSize + svSize +
-                computedSize;
+            return mMemory.getCurrent();
         }
 
         void Bsoid::makeVoxels()
@@ -186,59 +477,94 @@ namespace bsoid
             using atlas::math::Point;
             using atlas::utils::BBox;
 
-            atlas::core::Timer<float> global;
-            atlas::core::Timer<float> t;
+            PROFILE_ZONE("Bsoid::makeVoxels");
 
-#if (DISABLE_PARALLEL)
-            for (std::size_t x = 0; x < mSvSize; ++x)
+            // First construct the grid of super-voxels.
             {
-                for (std::size_t y = 0; y < mSvSize; ++y)
+                PROFILE_ZONE("supervoxels");
+                atlas::core::Timer<double> supervoxels;
+                supervoxels.start();
+                if (mProgress)
+                {
+                    mProgress->beginStep("supervoxels", mSvSize * mSvSize);
+                }
+#if (DISABLE_PARALLEL)
+                for (std::size_t x = 0; x < mSvSize; ++x)
                 {
-                    for (std::size_t z = 0; z < mSvSize; ++z)
+                    for (std::size_t y = 0; y < mSvSize; ++y)
                     {
-                        auto pt = createCellPoint(x, y, z, mSvDelta);
-                        BBox cell(pt, pt + mSvDelta);
-
-                        SuperVoxel sv;
-                        sv.field = mTree->getSubTree(cell);
-                        sv.id = { x, y, z };
+                        for (std::size_t z = 0; z < mSvSize; ++z)
+                        {
+                            auto pt = createCellPoint(x, y, z, mSvDelta);
+                            BBox cell(pt, pt + mSvDelta);
+
+                            SuperVoxel sv;
+                            sv.field = mTree->getSubTree(cell);
+                            sv.id = { x, y, z };
+
+                            if (sv.field)
+                            {
+                                sv.fieldCount = countFields(sv.field);
+                                auto idx = BsoidHash64::hash(x, y, z);
+                                mSuperVoxels.insert({ idx, sv });
+                            }
+                        }
 
-                        if (sv.field)
+                        if (mProgress)
                         {
-                            auto idx = BsoidHash64::hash(x, y, z);
-                            mSuperVoxels.insert({ idx, sv });
+                            mProgress->advance();
                         }
                     }
                 }
-            }
 
 #else
-            // First construct the grid of super-voxels.
-            tbb::parallel_for(static_cast<std::uint64_t>(0), mSvSize, 
-                [this](std::uint64_t x) {
-                tbb::parallel_for(static_cast<std::uint64_t>(0), mSvSize,
-                    [this, x](std::uint64_t y) {
+                UTILIZATION_PARALLEL();
+                tbb::parallel_for(static_cast<std::uint64_t>(0), mSvSize, 
+                    [this](std::uint64_t x) {
                     tbb::parallel_for(static_cast<std::uint64_t>(0), mSvSize,
-                        [this, x, y](std::uint64_t z)
-                    {
-                        auto pt = createCellPoint(x, y, z, mSvDelta);
-                        BBox cell(pt, pt + mSvDelta);
-
-                        SuperVoxel sv;
-                        sv.field = mTree->getSubTree(cell);
-                        sv.id = { x, y, z };
-
-                        if (sv.field)
+                        [this, x](std::uint64_t y) {
+                        PROFILE_ZONE("supervoxel row");
+                        tbb::parallel_for(static_cast<std::uint64_t>(0),
+                            mSvSize,
+                            [this, x, y](std::uint64_t z)
                         {
-                            // critical section.
-                            std::lock_guard<std::mutex> lock(mSvMutex);
-                            auto idx = BsoidHash64::hash(x, y, z);
-                            mSuperVoxels.insert({ idx, sv });
+                            UTILIZATION_TASK();
+                            auto pt = createCellPoint(x, y, z, mSvDelta);
+                            BBox cell(pt, pt + mSvDelta);
+
+                            SuperVoxel sv;
+                            sv.field = mTree->getSubTree(cell);
+                            sv.id = { x, y, z };
+
+                            if (sv.field)
+                            {
+                                sv.fieldCount = countFields(sv.field);
+
+                                // critical section.
+                                std::lock_guard<std::mutex> lock(mSvMutex);
+                                auto idx = BsoidHash64::hash(x, y, z);
+                                mSuperVoxels.insert({ idx, sv });
+                            }
+                        });
+
+                        if (mProgress)
+                        {
+                            mProgress->advance();
                         }
                     });
                 });
-            });
 #endif
+                // The grid is complete, so the supervoxels can be numbered
+                // densely for the per-thread evaluation counters.
+                std::size_t index = 0;
+                for (auto& entry : mSuperVoxels)
+                {
+                    entry.second.index = index++;
+                }
+
+                mStats.sections.push_back({ "supervoxels",
+                    supervoxels.elapsed() });
+            }
 
 
             // Now that we have the grid of super-voxels, we can grab the seeds
@@ -258,9 +584,11 @@ namespace bsoid
                 ++i;
             }
 #else
+            UTILIZATION_PARALLEL();
             tbb::parallel_for(static_cast<std::size_t>(0), seedVoxels.size(),
                 [this, seedPoints, &seedVoxels](std::size_t i) 
             {
+                UTILIZATION_TASK();
                 auto pt = seedPoints[i];
                 auto v = (pt - mMin) / mGridDelta;
                 PointId id;
@@ -292,42 +620,48 @@ namespace bsoid
             return createCellPoint(p.x, p.y, p.z, delta);
         }
 
+        std::uint64_t Bsoid::getSuperVoxelHash(atlas::math::Point const& pt)
+        {
+            PointId svId;
+            auto v = (pt - mMin) / mSvDelta;
+            svId.x = static_cast<std::uint64_t>(v.x);
+            svId.y = static_cast<std::uint64_t>(v.y);
+            svId.z = static_cast<std::uint64_t>(v.z);
+
+            // Check any of the coordinates of the id are beyond the edge
+            // of the grid.
+            svId.x = (svId.x < mSvSize) ? svId.x : svId.x - 1;
+            svId.y = (svId.y < mSvSize) ? svId.y : svId.y - 1;
+            svId.z = (svId.z < mSvSize) ? svId.z : svId.z - 1;
+            return BsoidHash64::hash(svId.x, svId.y, svId.z);
+        }
+
         FieldPoint Bsoid::findVoxelPoint(PointId const& id)
         {
             using atlas::math::Point4;
             using atlas::math::Point;
 
             // First check if we have seen this point before.
+            auto& counters = mCounters.local();
             auto entry = mSeenPoints.find(BsoidHash64::hash(id.x, id.y, id.z));
             if (entry != mSeenPoints.end())
             {
+                ++counters.pointHits;
                 return (*entry).second;
             }
             else
             {
+                ++counters.pointMisses;
                 auto pt = createCellPoint(id, mGridDelta);
 
-                PointId svId;
-                {
-                    auto v = (pt - mMin) / mSvDelta;
-                    svId.x = static_cast<std::uint64_t>(v.x);
-                    svId.y = static_cast<std::uint64_t>(v.y);
-                    svId.z = static_cast<std::uint64_t>(v.z);
-
-                    // Check any of the coordinates of the id are beyond the edge
-                    // of the grid.
-                    svId.x = (svId.x < mSvSize) ? svId.x : svId.x - 1;
-                    svId.y = (svId.y < mSvSize) ? svId.y : svId.y - 1;
-                    svId.z = (svId.z < mSvSize) ? svId.z : svId.z - 1;
-                }
-
                 FieldPoint fp;
                 {
-                    auto svHash = BsoidHash64::hash(svId.x, svId.y, svId.z);
+                    auto svHash = getSuperVoxelHash(pt);
                     SuperVoxel sv = mSuperVoxels.at(svHash);
                     auto val = sv.eval(pt);
                     auto g = sv.grad(pt);
                     fp = { pt, val, g, svHash };
+                    countEvaluation(counters, sv);
                 }
 
                 // Now that we have the point, let's add it to our list and
@@ -335,8 +669,9 @@ namespace bsoid
                 {
                     std::lock_guard<std::mutex> lock(mSeenPointsMutex);
                     auto hash = BsoidHash64::hash(id.x, id.y, id.z);
-                    mSeenPoints.insert(
+                    auto inserted = mSeenPoints.insert(
                         std::pair<std::uint64_t, FieldPoint>(hash, fp));
+                    counters.redundantPoints += inserted.second ? 0 : 1;
                 }
 
                 return fp;
@@ -354,8 +689,10 @@ namespace bsoid
                 ++d;
             }
 #else
+            UTILIZATION_PARALLEL();
             tbb::parallel_for(static_cast<std::size_t>(0), 
                 VoxelDecals.size(), [this, &v](std::size_t d) {
+                UTILIZATION_TASK();
                 auto decalId = v.id + VoxelDecals[d];
                 v.points[d] = findVoxelPoint(decalId);
             });
@@ -388,6 +725,7 @@ namespace bsoid
             auto sv = mSuperVoxels[hash];
             auto val = sv.eval(pt);
             auto grad = sv.grad(pt);
+            countEvaluation(mCounters.local(), sv);
             return FieldPoint(pt, val, grad, hash);
         }
 
@@ -400,12 +738,14 @@ namespace bsoid
             auto edgeHash1 = BsoidHash128::hash(h1, h2);
             auto edgeHash2 = BsoidHash128::hash(h2, h1);
 
+            auto& counters = mCounters.local();
             auto entry1 = mComputedPoints.find(edgeHash1);
             auto entry2 = mComputedPoints.find(edgeHash2);
 
             if (entry1 != mComputedPoints.end() ||
                 entry2 != mComputedPoints.end())
             {
+                ++counters.edgeHits;
                 if (entry1 != mComputedPoints.end())
                 {
                     return (*entry1).second;
@@ -415,13 +755,15 @@ namespace bsoid
             }
             else
             {
+                ++counters.edgeMisses;
                 auto edgeHash = edgeHash1;
                 auto pt = interpolate(fp1, fp2);
 
                 LinePoint p(pt, edgeHash);
                 std::lock_guard<std::mutex> lock(mPointMutex);
-                mComputedPoints.insert(
+                auto inserted = mComputedPoints.insert(
                     std::pair<std::uint128_t, LinePoint>(edgeHash, p));
+                counters.redundantEdges += inserted.second ? 0 : 1;
                 return p;
             }
         }
@@ -453,9 +795,11 @@ namespace bsoid
                     edgeId++;
                 }
 #else
+                UTILIZATION_PARALLEL();
                 tbb::parallel_for(static_cast<std::size_t>(0), EdgeDecals.size(),
                     [this, &edges, &edgesMutex, &v](std::size_t edgeId)
                     {
+                        UTILIZATION_TASK();
                         FieldPoint start, end;
                         auto decal = EdgeDecals[edgeId];
                         start = v.points[decal.x];
@@ -484,6 +828,10 @@ namespace bsoid
             std::queue<VoxelId> frontier;
             std::mutex frontierMutex;
             {
+                PROFILE_ZONE("seeding");
+                atlas::core::Timer<double> seeding;
+                seeding.start();
+
                 auto containsSurface = [this, getEdges](Voxel const& v)
                 {
                     Voxel voxel = v;
@@ -500,7 +848,7 @@ namespace bsoid
 
                     while (!found)
                     {
-                        auto cPos = (2llu * current.id) + glm::u64vec3(1, 1, 1);
+                        auto cPos = (static_cast<std::uint64_t>(2) * current.id) + glm::u64vec3(1, 1, 1);
                         Point origin = createCellPoint(cPos, mGridDelta / 2.0f);
                         float originVal = mTree->eval(origin);
                         auto norm = mTree->grad(origin);
@@ -546,9 +894,12 @@ namespace bsoid
                     ++i;
                 }
 #else
+                UTILIZATION_PARALLEL();
                 tbb::parallel_for(static_cast<std::size_t>(0), seeds.size(),
                     [this, containsSurface, findSurface, &frontierMutex, 
                     &frontier, seeds](std::size_t i) {
+                    PROFILE_ZONE("seed");
+                    UTILIZATION_TASK();
                     auto& seed = seeds[i];
                     auto v = seeds[i];
                     if (!containsSurface(seed))
@@ -566,6 +917,7 @@ namespace bsoid
                     }
                 });
 #endif
+                mStats.sections.push_back({ "seeding", seeding.elapsed() });
             }
 
             // See whether there is a sensible way of parallelizing this later.
@@ -575,18 +927,33 @@ namespace bsoid
                 return;
             }
 
+            PROFILE_ZONE("tracking");
+            atlas::core::Timer<double> tracking;
+            tracking.start();
+            if (mProgress)
+            {
+                mProgress->beginStep("tracking", 0);
+            }
+
             while (!frontier.empty())
             {
                 auto top = frontier.front();
                 frontier.pop();
 
+                auto& counters = mCounters.local();
                 if (seenVoxel(top))
                 {
+                    ++counters.voxelsRevisited;
                     continue;
                 }
 
                 Voxel v(top);
                 fillVoxel(v);
+                ++counters.voxelsVisited;
+                if (mProgress)
+                {
+                    mProgress->advance();
+                }
 
                 auto edges = getEdges(v);
                 if (edges.empty())
@@ -611,9 +978,11 @@ namespace bsoid
                     frontier.push(neighbourDecal);
                 }
 #else
+                UTILIZATION_PARALLEL();
                 tbb::parallel_for(static_cast<std::size_t>(0), edges.size(),
                     [v, &frontier, &frontierMutex, edges, this](std::size_t i)
                 {
+                    UTILIZATION_TASK();
                     auto decal = NeighbourDecals[edges[i]];
 
                     auto neighbourDecal = v.id;
@@ -634,332 +1003,255 @@ namespace bsoid
 #endif
 
                 mVoxels.push_back(v);
+                ++counters.voxelsAccepted;
             }
+            mStats.sections.push_back({ "tracking", tracking.elapsed() });
         }
 
-        void Bsoid::makeTriangles()
+        std::size_t Bsoid::makeTriangles(MeshSink& sink)
         {
-            using atlas::math::Point;
-            using atlas::math::Normal;
-
-            // Iterate over the set of voxels.
-            std::map<std::uint128_t, std::uint32_t> indexMap;
+            using atlas::utils::BBox;
 
+            PROFILE_ZONE("Bsoid::makeTriangles");
 
-#if (DISABLE_PARALLEL)
-            for (auto& voxel : mVoxels)
+            // Each supervoxel becomes one chunk, so sort the voxels by the
+            // supervoxel that contains them.
+            Vector<std::uint32_t> order(mVoxels.size(), 0, &mMemory);
+            std::iota(order.begin(), order.end(), 0);
             {
-                std::uint32_t voxelIndex = 0;
-                std::vector<std::uint32_t> coeffs =
-                { 1, 2, 4, 8, 16, 32, 64, 128 };
-                for (std::size_t i = 0; i < voxel.points.size(); ++i)
-                {
-                    voxelIndex |= (voxel.points[i].value.w < mMagic) ?
-                        coeffs[i] : 0;
-                }
-
-                if (EdgeTable[voxelIndex] == 0)
-                {
-                    continue;
-                }
-
-                std::vector<LinePoint> vertList(12);
-                if (EdgeTable[voxelIndex] & 1)
+                UTILIZATION_PARALLEL();
+                tbb::parallel_sort(order.begin(), order.end(),
+                    [this](std::uint32_t a, std::uint32_t b)
                 {
-                    vertList[0] = generateLinePoint(
-                        voxel.id + VoxelDecals[0],
-                        voxel.id + VoxelDecals[1],
-                        voxel.points[0],
-                        voxel.points[1]);
-                }
+                    auto svA = mVoxels[a].points[0].svHash;
+                    auto svB = mVoxels[b].points[0].svHash;
+                    return (svA != svB) ? svA < svB : a < b;
+                });
+            }
 
-                if (EdgeTable[voxelIndex] & 2)
+            Vector<std::size_t> groups(&mMemory);
+            for (std::size_t i = 0; i < order.size(); ++i)
+            {
+                if (i == 0 || mVoxels[order[i]].points[0].svHash !=
+                    mVoxels[order[i - 1]].points[0].svHash)
                 {
-                    vertList[1] = generateLinePoint(
-                        voxel.id + VoxelDecals[1],
-                        voxel.id + VoxelDecals[2],
-                        voxel.points[1],
-                        voxel.points[2]);
+                    groups.push_back(i);
                 }
+            }
+            groups.push_back(order.size());
+
+            // Triangles are first built per supervoxel with local indices.
+            // Vertices are identified by the edge they lie on. Only vertices
+            // on an edge that a voxel of another supervoxel also contains can
+            // be shared between chunks, so only those are flagged for
+            // welding.
+            struct LocalChunk
+            {
+                LocalChunk(atlas::core::MemoryCounter* memory) :
+                    id(0),
+                    edges(memory),
+                    onFace(memory),
+                    points(memory),
+                    indices(memory)
+                { }
+
+                std::uint64_t id;
+                BBox bounds;
+                Vector<std::uint128_t> edges;
+                Vector<std::uint8_t> onFace;
+                Vector<LinePoint> points;
+                Vector<std::uint32_t> indices;
+            };
 
-                if (EdgeTable[voxelIndex] & 4)
+            // The four voxels around an edge start at its smaller end point
+            // moved back along the other two axes. Each of them belongs to
+            // the supervoxel of its first corner, just as the voxels were
+            // grouped above.
+            auto isOnFace = [this](PointId const& p1, PointId const& p2,
+                std::uint64_t svHash)
+            {
+                auto p = glm::min(p1, p2);
+                auto d = glm::max(p1, p2) - p;
+                PointId u = (d.x != 0) ? PointId(0, 1, 0) : PointId(1, 0, 0);
+                PointId w = (d.z != 0) ? PointId(0, 1, 0) : PointId(0, 0, 1);
+                for (std::uint64_t i = 0; i < 4; ++i)
                 {
-                    vertList[2] = generateLinePoint(
-                        voxel.id + VoxelDecals[2],
-                        voxel.id + VoxelDecals[3],
-                        voxel.points[2],
-                        voxel.points[3]);
-                }
+                    auto back = u * (i & 1) + w * (i >> 1);
+                    if (glm::any(glm::lessThan(p, back)))
+                    {
+                        continue;
+                    }
 
-                if (EdgeTable[voxelIndex] & 8)
-                {
-                    vertList[3] = generateLinePoint(
-                        voxel.id + VoxelDecals[3],
-                        voxel.id + VoxelDecals[0],
-                        voxel.points[3],
-                        voxel.points[0]);
+                    auto id = p - back;
+                    if (getSuperVoxelHash(createCellPoint(id, mGridDelta)) !=
+                        svHash)
+                    {
+                        return true;
+                    }
                 }
 
-                if (EdgeTable[voxelIndex] & 16)
-                {
-                    vertList[4] = generateLinePoint(
-                        voxel.id + VoxelDecals[4],
-                        voxel.id + VoxelDecals[5],
-                        voxel.points[4],
-                        voxel.points[5]);
-                }
+                return false;
+            };
 
-                if (EdgeTable[voxelIndex] & 32)
-                {
-                    vertList[5] = generateLinePoint(
-                        voxel.id + VoxelDecals[5],
-                        voxel.id + VoxelDecals[6],
-                        voxel.points[5],
-                        voxel.points[6]);
-                }
+            auto makeLocal = [this, &order, &groups, &isOnFace](std::size_t g,
+                LocalChunk& local)
+            {
+                PROFILE_ZONE("triangulate chunk");
+                UTILIZATION_TASK();
+                Map<std::uint128_t, std::uint32_t> localMap(&mMemory);
+                local.id = mVoxels[order[groups[g]]].points[0].svHash;
 
-                if (EdgeTable[voxelIndex] & 64)
+                for (std::size_t i = groups[g]; i < groups[g + 1]; ++i)
                 {
-                    vertList[6] = generateLinePoint(
-                        voxel.id + VoxelDecals[6],
-                        voxel.id + VoxelDecals[7],
-                        voxel.points[6],
-                        voxel.points[7]);
-                }
+                    Voxel const& voxel = mVoxels[order[i]];
+                    std::uint32_t voxelIndex = 0;
+                    for (std::size_t c = 0; c < voxel.points.size(); ++c)
+                    {
+                        voxelIndex |= (voxel.points[c].value.w < mMagic) ?
+                            (1 << c) : 0;
+                    }
 
-                if (EdgeTable[voxelIndex] & 128)
-                {
-                    vertList[7] = generateLinePoint(
-                        voxel.id + VoxelDecals[7],
-                        voxel.id + VoxelDecals[4],
-                        voxel.points[7],
-                        voxel.points[4]);
-                }
+                    if (EdgeTable[voxelIndex] == 0)
+                    {
+                        continue;
+                    }
 
-                if (EdgeTable[voxelIndex] & 256)
-                {
-                    vertList[8] = generateLinePoint(
-                        voxel.id + VoxelDecals[0],
-                        voxel.id + VoxelDecals[4],
-                        voxel.points[0],
-                        voxel.points[4]);
-                }
+                    std::uint32_t vertList[12];
+                    for (int e = 0; e < 12; ++e)
+                    {
+                        if (!(EdgeTable[voxelIndex] & (1 << e)))
+                        {
+                            continue;
+                        }
 
-                if (EdgeTable[voxelIndex] & 512)
-                {
-                    vertList[9] = generateLinePoint(
-                        voxel.id + VoxelDecals[1],
-                        voxel.id + VoxelDecals[5],
-                        voxel.points[1],
-                        voxel.points[5]);
-                }
+                        auto c1 = TriangleEdges[e][0];
+                        auto c2 = TriangleEdges[e][1];
+                        auto p1 = voxel.id + VoxelDecals[c1];
+                        auto p2 = voxel.id + VoxelDecals[c2];
 
-                if (EdgeTable[voxelIndex] & 1024)
-                {
-                    vertList[10] = generateLinePoint(
-                        voxel.id + VoxelDecals[2],
-                        voxel.id + VoxelDecals[6],
-                        voxel.points[2],
-                        voxel.points[6]);
-                }
+                        auto h1 = BsoidHash64::hash(p1.x, p1.y, p1.z);
+                        auto h2 = BsoidHash64::hash(p2.x, p2.y, p2.z);
+                        auto edge = BsoidHash128::hash(std::min(h1, h2),
+                            std::max(h1, h2));
 
-                if (EdgeTable[voxelIndex] & 2048)
-                {
-                    vertList[11] = generateLinePoint(
-                        voxel.id + VoxelDecals[3],
-                        voxel.id + VoxelDecals[7],
-                        voxel.points[3],
-                        voxel.points[7]);
-                }
+                        auto entry = localMap.find(edge);
+                        if (entry != localMap.end())
+                        {
+                            vertList[e] = (*entry).second;
+                            continue;
+                        }
 
-                for (int i = 0; TriangleTable[voxelIndex][i] != -1; i += 3)
-                {
-                    std::vector<LinePoint> pts;
-                    pts.push_back(vertList[TriangleTable[voxelIndex][i + 0]]);
-                    pts.push_back(vertList[TriangleTable[voxelIndex][i + 1]]);
-                    pts.push_back(vertList[TriangleTable[voxelIndex][i + 2]]);
+                        auto pt = generateLinePoint(p1, p2,
+                            voxel.points[c1], voxel.points[c2]);
+                        vertList[e] =
+                            static_cast<std::uint32_t>(local.points.size());
+                        localMap.insert(
+                            std::pair<std::uint128_t, std::uint32_t>(edge,
+                                vertList[e]));
+                        local.edges.push_back(edge);
+                        local.onFace.push_back(
+                            isOnFace(p1, p2, local.id) ? 1 : 0);
+                        local.points.push_back(pt);
+                        local.bounds = join(local.bounds,
+                            BBox(pt.point.value.xyz()));
+                    }
 
-                    for (auto& pt : pts)
+                    for (int t = 0; TriangleTable[voxelIndex][t] != -1; ++t)
                     {
-                        // Check if we have seen this point before.
-                        auto entry = indexMap.find(pt.edge);
-                        if (entry != indexMap.end())
-                        {
-                            // We have, so just insert the index.
-                            mMesh.indices().push_back((*entry).second);
-                        }
-                        else
-                        {
-                            // We haven't, so insert it.
-                            mMesh.vertices().push_back(pt.point.value.xyz());
-                            mMesh.normals().push_back(-pt.point.g);
-                            mMesh.indices().push_back(mMesh.vertices().size() - 1);
-                            indexMap.insert(
-                                std::pair<std::uint128_t, std::uint32_t>(pt.edge,
-                                    mMesh.vertices().size() - 1));
-                        }
+                        local.indices.push_back(
+                            vertList[TriangleTable[voxelIndex][t]]);
                     }
                 }
+            };
 
+            // Supervoxels are processed in batches so only a bounded number
+            // of chunks are alive at once. Vertices shared with previous
+            // chunks are then resolved in order through the edge map, which
+            // only holds the face vertices.
+            constexpr std::size_t batchSize = 64;
+            std::size_t numGroups = groups.size() - 1;
+            Map<std::uint128_t, std::uint32_t> indexMap(&mMemory);
+            std::uint32_t numVertices = 0;
+            if (mProgress)
+            {
+                mProgress->beginStep("triangles", numGroups);
             }
-#else
-            std::mutex indexMapMutex;
-            auto loop = [&indexMap, &indexMapMutex, this](std::size_t i)
-            {
-                Voxel& voxel = mVoxels[i];
-                std::uint32_t voxelIndex = 0;
-                std::vector<std::uint32_t> coeffs =
-                { 1, 2, 4, 8, 16, 32, 64, 128 };
-                for (std::size_t i = 0; i < voxel.points.size(); ++i)
-                {
-                    voxelIndex |= (voxel.points[i].value.w < mMagic) ?
-                        coeffs[i] : 0;
-                }
-
-                if (EdgeTable[voxelIndex] == 0)
-                {
-                    return;
-                }
 
-                std::vector<LinePoint> vertList(12);
-                if (EdgeTable[voxelIndex] & 1)
-                {
-                    vertList[0] = generateLinePoint(
-                        voxel.id + VoxelDecals[0],
-                        voxel.id + VoxelDecals[1],
-                        voxel.points[0],
-                        voxel.points[1]);
-                }
-
-                if (EdgeTable[voxelIndex] & 2)
-                {
-                    vertList[1] = generateLinePoint(
-                        voxel.id + VoxelDecals[1],
-                        voxel.id + VoxelDecals[2],
-                        voxel.points[1],
-                        voxel.points[2]);
-                }
-
-                if (EdgeTable[voxelIndex] & 4)
-                {
-                    vertList[2] = generateLinePoint(
-                        voxel.id + VoxelDecals[2],
-                        voxel.id + VoxelDecals[3],
-                        voxel.points[2],
-                        voxel.points[3]);
-                }
+            for (std::size_t start = 0; start < numGroups; start += batchSize)
+            {
+                std::size_t end = std::min(start + batchSize, numGroups);
+                Vector<LocalChunk> locals(end - start, LocalChunk(&mMemory),
+                    &mMemory);
 
-                if (EdgeTable[voxelIndex] & 8)
+#if (DISABLE_PARALLEL)
+                for (std::size_t g = start; g < end; ++g)
                 {
-                    vertList[3] = generateLinePoint(
-                        voxel.id + VoxelDecals[3],
-                        voxel.id + VoxelDecals[0],
-                        voxel.points[3],
-                        voxel.points[0]);
+                    makeLocal(g, locals[g - start]);
                 }
-
-                if (EdgeTable[voxelIndex] & 16)
+#else
                 {
-                    vertList[4] = generateLinePoint(
-                        voxel.id + VoxelDecals[4],
-                        voxel.id + VoxelDecals[5],
-                        voxel.points[4],
-                        voxel.points[5]);
+                    UTILIZATION_PARALLEL();
+                    tbb::parallel_for(start, end,
+                        [&makeLocal, &locals, start](std::size_t g)
+                    {
+                        makeLocal(g, locals[g - start]);
+                    });
                 }
+#endif
 
-                if (EdgeTable[voxelIndex] & 32)
+                PROFILE_ZONE("weld chunks");
+                for (auto& local : locals)
                 {
-                    vertList[5] = generateLinePoint(
-                        voxel.id + VoxelDecals[5],
-                        voxel.id + VoxelDecals[6],
-                        voxel.points[5],
-                        voxel.points[6]);
-                }
+                    if (local.indices.empty())
+                    {
+                        continue;
+                    }
 
-                if (EdgeTable[voxelIndex] & 64)
-                {
-                    vertList[6] = generateLinePoint(
-                        voxel.id + VoxelDecals[6],
-                        voxel.id + VoxelDecals[7],
-                        voxel.points[6],
-                        voxel.points[7]);
-                }
+                    MeshChunk chunk;
+                    chunk.id = local.id;
+                    chunk.vertexOffset = numVertices;
+                    chunk.bounds = local.bounds;
 
-                if (EdgeTable[voxelIndex] & 128)
-                {
-                    vertList[7] = generateLinePoint(
-                        voxel.id + VoxelDecals[7],
-                        voxel.id + VoxelDecals[4],
-                        voxel.points[7],
-                        voxel.points[4]);
-                }
+                    Vector<std::uint32_t> globalIndex(local.points.size(), 0,
+                        &mMemory);
+                    for (std::size_t v = 0; v < local.points.size(); ++v)
+                    {
+                        if (local.onFace[v])
+                        {
+                            auto entry = indexMap.find(local.edges[v]);
+                            if (entry != indexMap.end())
+                            {
+                                globalIndex[v] = (*entry).second;
+                                continue;
+                            }
 
-                if (EdgeTable[voxelIndex] & 256)
-                {
-                    vertList[8] = generateLinePoint(
-                        voxel.id + VoxelDecals[0],
-                        voxel.id + VoxelDecals[4],
-                        voxel.points[0],
-                        voxel.points[4]);
-                }
+                            indexMap.insert(
+                                std::pair<std::uint128_t, std::uint32_t>(
+                                    local.edges[v], numVertices));
+                        }
 
-                if (EdgeTable[voxelIndex] & 512)
-                {
-                    vertList[9] = generateLinePoint(
-                        voxel.id + VoxelDecals[1],
-                        voxel.id + VoxelDecals[5],
-                        voxel.points[1],
-                        voxel.points[5]);
-                }
+                        globalIndex[v] = numVertices++;
+                        chunk.vertices.push_back(
+                            local.points[v].point.value.xyz());
+                        chunk.normals.push_back(-local.points[v].point.g);
+                    }
 
-                if (EdgeTable[voxelIndex] & 1024)
-                {
-                    vertList[10] = generateLinePoint(
-                        voxel.id + VoxelDecals[2],
-                        voxel.id + VoxelDecals[6],
-                        voxel.points[2],
-                        voxel.points[6]);
-                }
+                    chunk.indices.reserve(local.indices.size());
+                    for (auto index : local.indices)
+                    {
+                        chunk.indices.push_back(globalIndex[index]);
+                    }
 
-                if (EdgeTable[voxelIndex] & 2048)
-                {
-                    vertList[11] = generateLinePoint(
-                        voxel.id + VoxelDecals[3],
-                        voxel.id + VoxelDecals[7],
-                        voxel.points[3],
-                        voxel.points[7]);
+                    sink.write(chunk);
                 }
 
-                for (int i = 0; TriangleTable[voxelIndex][i] != -1; i += 3)
+                if (mProgress)
                 {
-                    std::vector<LinePoint> pts;
-                    pts.push_back(vertList[TriangleTable[voxelIndex][i + 0]]);
-                    pts.push_back(vertList[TriangleTable[voxelIndex][i + 1]]);
-                    pts.push_back(vertList[TriangleTable[voxelIndex][i + 2]]);
-
-                    std::lock_guard<std::mutex> lock(indexMapMutex);
-                    for (auto& pt : pts)
-                    {
-                        auto entry = indexMap.find(pt.edge);
-                        if (entry != indexMap.end())
-                        {
-                            mMesh.indices().push_back((*entry).second);
-                        }
-                        else
-                        {
-                            mMesh.vertices().push_back(pt.point.value.xyz());
-                            mMesh.normals().push_back(-pt.point.g);
-                            mMesh.indices().push_back(mMesh.vertices().size() - 1);
-                            indexMap.insert(
-                                std::pair<std::uint128_t, std::uint32_t>(
-                                    pt.edge, mMesh.vertices().size() - 1));
-                        }
-                    }
+                    mProgress->advance(end - start);
                 }
-            };
+            }
 
-            tbb::parallel_for(static_cast<std::size_t>(0), mVoxels.size(), loop);
-#endif
+            return numVertices;
         }
 
         bool Bsoid::validVoxel(Voxel const& v)
@@ -1,120 +1,114 @@
 #include "bsoid/polygonizer/Lattice.hpp"
+#include "bsoid/polygonizer/Hash.hpp"
+#include "bsoid/polygonizer/Tables.hpp"
 
-#include <functional>
-#include <unordered_set>
+#include <algorithm>
+
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
 
 namespace bsoid
 {
     namespace polygonizer
     {
-        void Lattice::makeLattice(std::vector<Voxel> const& voxels)
+        void Lattice::makeLattice(VoxelList const& voxels,
+            bool uniqueEdges)
         {
-            using atlas::math::Point;
-
-            struct LatticePoint
+            // The 12 edges of a voxel, in terms of the VoxelDecals order.
+            static const std::array<std::uint32_t, 24> voxelEdges =
             {
-                LatticePoint(Point const& p) :
-                    point(p)
-                { }
+                0, 1, 1, 2, 2, 3, 3, 0,
+                4, 5, 5, 6, 6, 7, 7, 4,
+                0, 4, 1, 5, 2, 6, 3, 7
+            };
 
-                LatticePoint(Point const& p, std::uint32_t i) :
-                    point(p),
-                    index(i)
-                { }
+            clearBuffers();
 
-                bool operator==(LatticePoint const& rhs) const
+            // Corners are identified by their integer grid position, so two
+            // voxels that share a corner always produce the same key. Each
+            // key is paired with the corner that produced it so that the
+            // position can be recovered once the keys are sorted.
+            std::size_t numCorners = 8 * voxels.size();
+            std::vector<std::pair<std::uint64_t, std::uint64_t>> corners(
+                numCorners);
+            tbb::parallel_for(std::size_t(0), voxels.size(), [&](std::size_t v)
+            {
+                auto const& id = voxels[v].id;
+                for (std::size_t c = 0; c < 8; ++c)
                 {
-                    return point == rhs.point;
+                    auto pt = id + VoxelDecals[c];
+                    corners[8 * v + c] = { BsoidHash64::hash(pt.x, pt.y, pt.z),
+                        8 * v + c };
                 }
+            });
 
-                bool operator!=(LatticePoint const& rhs) const
-                {
-                    return !(*this == rhs);
-                }
+            auto uniqueCorners = corners;
+            tbb::parallel_sort(uniqueCorners.begin(), uniqueCorners.end());
+            uniqueCorners.erase(std::unique(uniqueCorners.begin(),
+                uniqueCorners.end(),
+                [](auto const& lhs, auto const& rhs)
+            {
+                return lhs.first == rhs.first;
+            }), uniqueCorners.end());
 
-                Point point;
-                std::uint32_t index;
-            };
+            vertices.resize(uniqueCorners.size());
+            tbb::parallel_for(std::size_t(0), uniqueCorners.size(),
+                [&](std::size_t i)
+            {
+                auto corner = uniqueCorners[i].second;
+                vertices[i] = voxels[corner / 8].points[corner % 8].value.xyz();
+            });
 
-            struct LatticeHash
+            std::vector<std::uint32_t> cornerIndex(numCorners);
+            tbb::parallel_for(std::size_t(0), numCorners, [&](std::size_t i)
             {
-                std::size_t operator()(LatticePoint const& p) const
+                auto it = std::lower_bound(uniqueCorners.begin(),
+                    uniqueCorners.end(), corners[i].first,
+                    [](auto const& entry, std::uint64_t key)
                 {
-                    return std::hash<float>()(p.point.x + p.point.y + 
-                        p.point.z);
-                }
-            };
-
-            clearBuffers();
+                    return entry.first < key;
+                });
+                cornerIndex[i] = static_cast<std::uint32_t>(
+                    it - uniqueCorners.begin());
+            });
 
-            std::vector<Point> verts;
-            std::vector<std::uint32_t> idxs;
-            std::uint32_t idxStart = 0;
-            for (auto& voxel : voxels)
+            if (!uniqueEdges)
             {
-                for (auto& pt : voxel.points)
+                indices.resize(24 * voxels.size());
+                tbb::parallel_for(std::size_t(0), voxels.size(),
+                    [&](std::size_t v)
                 {
-                    verts.push_back(pt.value.xyz());
-                }
-
-                idxs.push_back(idxStart + 0);
-                idxs.push_back(idxStart + 1);
-
-                idxs.push_back(idxStart + 1);
-                idxs.push_back(idxStart + 2);
-
-                idxs.push_back(idxStart + 2);
-                idxs.push_back(idxStart + 3);
-
-                idxs.push_back(idxStart + 3);
-                idxs.push_back(idxStart + 0);
-
-                idxs.push_back(idxStart + 4);
-                idxs.push_back(idxStart + 5);
-
-                idxs.push_back(idxStart + 5);
-                idxs.push_back(idxStart + 6);
-
-                idxs.push_back(idxStart + 6);
-                idxs.push_back(idxStart + 7);
-
-                idxs.push_back(idxStart + 7);
-                idxs.push_back(idxStart + 4);
-
-                idxs.push_back(idxStart + 0);
-                idxs.push_back(idxStart + 4);
-
-                idxs.push_back(idxStart + 1);
-                idxs.push_back(idxStart + 5);
-
-                idxs.push_back(idxStart + 2);
-                idxs.push_back(idxStart + 6);
-                
-                idxs.push_back(idxStart + 3);
-                idxs.push_back(idxStart + 7);
-
-                idxStart = static_cast<std::uint32_t>(verts.size());
+                    for (std::size_t e = 0; e < voxelEdges.size(); ++e)
+                    {
+                        indices[24 * v + e] = cornerIndex[8 * v + voxelEdges[e]];
+                    }
+                });
+                return;
             }
 
-            std::unordered_set<LatticePoint, LatticeHash> uniqueVertices;
-            std::uint32_t current = vertices.size();
-            for (auto& idx : idxs)
+            // Neighbouring voxels share their faces, so most edges appear
+            // more than once. Each edge is keyed by its (smaller, larger)
+            // vertex pair and only one copy is kept.
+            std::vector<std::uint64_t> edges(12 * voxels.size());
+            tbb::parallel_for(std::size_t(0), voxels.size(), [&](std::size_t v)
             {
-                auto pt = verts[idx];
-                if (uniqueVertices.find(pt) == uniqueVertices.end())
-                {
-                    indices.push_back(current);
-                    vertices.push_back(pt);
-
-                    uniqueVertices.emplace(pt, current);
-                    current++;
-                }
-                else
+                for (std::size_t e = 0; e < 12; ++e)
                 {
-                    auto uniqueV = *uniqueVertices.find(pt);
-                    indices.push_back(uniqueV.index);
+                    std::uint64_t a = cornerIndex[8 * v + voxelEdges[2 * e]];
+                    std::uint64_t b = cornerIndex[8 * v + voxelEdges[2 * e + 1]];
+                    edges[12 * v + e] = (std::min(a, b) << 32) | std::max(a, b);
                 }
-            }
+            });
+
+            tbb::parallel_sort(edges.begin(), edges.end());
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+            indices.resize(2 * edges.size());
+            tbb::parallel_for(std::size_t(0), edges.size(), [&](std::size_t e)
+            {
+                indices[2 * e + 0] = static_cast<std::uint32_t>(edges[e] >> 32);
+                indices[2 * e + 1] = static_cast<std::uint32_t>(edges[e]);
+            });
         }
 
         void Lattice::clearBuffers()
@@ -123,4 +117,4 @@ namespace bsoid
             indices.clear();
         }
     }
-}
\ No newline at end of file
+}
@@ -1,10 +1,15 @@
 #include "bsoid/polygonizer/MarchingCubes.hpp"
+#include "bsoid/polygonizer/MeshSink.hpp"
 
 #include <atlas/core/Timer.hpp>
 #include <atlas/core/Log.hpp>
+#include <atlas/core/Profiler.hpp>
+#include <atlas/core/Memory.hpp>
+#include <atlas/utils/MeshOptimizer.hpp>
 
 #include <cinttypes>
-#include <numeric>
+#include <algorithm>
+#include <unordered_map>
 
 #include <tbb/parallel_for.h>
 
@@ -28,6 +33,13 @@ namespace bsoid
             { 0, 1, 1 }
         };
 
+        constexpr int EdgeCorners[12][2] =
+        {
+            { 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 },
+            { 4, 5 }, { 5, 6 }, { 6, 7 }, { 7, 4 },
+            { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }
+        };
+
         constexpr std::uint32_t EdgeTable[256] =
         {
             0x0  , 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c,
@@ -325,23 +337,45 @@ namespace bsoid
         };
 
 
+        constexpr std::uint32_t MarchingCubes::ChunkSize;
+
+        // 21 bits per coordinate, which is more blocks than a grid can hold.
+        static std::uint64_t getChunkId(glm::u32vec3 const& block)
+        {
+            return (static_cast<std::uint64_t>(block.x) << 42) |
+                (static_cast<std::uint64_t>(block.y) << 21) | block.z;
+        }
+
+        glm::u32vec3 MarchingCubes::getChunkBlock(std::uint64_t id)
+        {
+            constexpr std::uint64_t mask = (1 << 21) - 1;
+            return glm::u32vec3(id >> 42, (id >> 21) & mask, id & mask);
+        }
+
         MarchingCubes::MarchingCubes() :
+            mGrid(&mMemory),
+            mProgress(nullptr),
             mName("model")
         { }
 
         MarchingCubes::MarchingCubes(tree::BlobTree const& model,
             std::string const& name, float isoValue) :
+            mGrid(&mMemory),
             mTree(std::make_unique<tree::BlobTree>(model)),
             mMagic(isoValue),
+            mProgress(nullptr),
             mName(name)
         { }
 
         MarchingCubes::MarchingCubes(MarchingCubes&& mc) :
             mResolution(mc.mResolution),
-            mMesh(std::move(mMesh)),
-            mGrid(mc.mGrid),
+            mMesh(std::move(mc.mMesh)),
+            mChunks(std::move(mc.mChunks)),
+            mGrid(mc.mGrid, &mMemory),
             mTree(std::move(mc.mTree)),
             mMagic(mc.mMagic),
+            mStats(std::move(mc.mStats)),
+            mProgress(mc.mProgress),
             mLog(std::move(mc.mLog)),
             mName(mc.mName)
         { }
@@ -361,12 +395,36 @@ namespace bsoid
             mResolution = glm::u32vec3(res);
         }
 
+        tree::BlobTree* MarchingCubes::tree() const
+        {
+            return mTree.get();
+        }
+
+        float MarchingCubes::getIsoValue() const
+        {
+            return mMagic;
+        }
+
+        glm::u32vec3 MarchingCubes::getResolution() const
+        {
+            return mResolution;
+        }
+
         void MarchingCubes::polygonize()
         {
-            using atlas::utils::Mesh;
+            MemoryMeshSink sink(mMesh, mChunks);
+            polygonize(sink);
+            optimizeMesh();
+        }
+
+        void MarchingCubes::polygonize(MeshSink& sink)
+        {
             using atlas::core::Timer;
 
+            PROFILE_ZONE("MarchingCubes::polygonize");
             Timer<float> global;
+            mStats = PolygonizerStats();
+            auto evaluations = mTree->getEvaluationCount();
 
             mLog << "Polygonizing model: " << mName << "\n";
             mLog << "Resolution: " << std::to_string(mResolution.x) << ".\n";
@@ -377,34 +435,82 @@ namespace bsoid
             INFO_LOG("MC: Starting grid construction.");
             {
                 Timer<float> section;
+                beginPhase();
                 section.start();
                 constructGrid();
+                endPhase("grid", section.elapsed());
             }
             INFO_LOG("MC: Grid construction done.");
 
-            INFO_LOG("MC: Starting soup generation.");
+            INFO_LOG("MC: Starting mesh generation.");
+            std::size_t numVertices = 0;
             {
                 Timer<float> section;
+                beginPhase();
                 section.start();
-                createTriangles();
+                sink.begin();
+                numVertices = createTriangles(sink);
+                sink.end();
+                endPhase("triangles", section.elapsed());
             }
-            INFO_LOG("MC: Soup generation done.");
-
-            Mesh::fromTriangleSoup(mVertices, mIndices, mMesh, mNormals);
+            INFO_LOG("MC: Mesh generation done.");
 
             mLog << "\nSummary:\n";
             mLog << "#===========================#\n";
+            mStats.evaluations = mTree->getEvaluationCount() - evaluations;
+            mStats.vertices = numVertices;
+
             mLog << "Total runtime: " << global.elapsed() << " seconds\n";
-            mLog << "Total vertices generated: " << mMesh.vertices().size() << "\n";
+            mLog << "Total vertices generated: " << numVertices << "\n";
             mLog << "Total memory usage: " << size() << " bytes.\n";
             mLog << mTree->getFieldSummary();
         }
 
+        void MarchingCubes::optimizeMesh()
+        {
+            using atlas::core::Timer;
+            using atlas::utils::computeACMR;
+
+            PROFILE_ZONE("MarchingCubes::optimizeMesh");
+            Timer<float> timer;
+            beginPhase();
+            timer.start();
+            INFO_LOG("MC: Starting mesh optimization.");
+            if (mProgress)
+            {
+                mProgress->beginStep("optimize", 0);
+            }
+            float before = computeACMR(mMesh.indices());
+            auto offsets = getChunkOffsets(mChunks, mMesh.indices().size());
+            if (offsets.empty())
+            {
+                atlas::utils::optimizeVertexCache(mMesh);
+            }
+            else
+            {
+                atlas::utils::optimizeVertexCache(mMesh, offsets);
+            }
+            atlas::utils::optimizeVertexFetch(mMesh);
+            float after = computeACMR(mMesh.indices());
+            INFO_LOG_V("MC: Mesh optimization done. ACMR: %f -> %f.", before,
+                after);
+
+            float elapsed = timer.elapsed();
+            endPhase("optimize", elapsed);
+            mLog << "Vertex cache ACMR: " << before << " -> " << after <<
+                " (" << elapsed << " seconds)\n";
+        }
+
         atlas::utils::Mesh& MarchingCubes::getMesh()
         {
             return mMesh;
         }
 
+        std::vector<MeshChunkRange>& MarchingCubes::getChunks()
+        {
+            return mChunks;
+        }
+
         void MarchingCubes::setName(std::string const& name)
         {
             mName = name;
@@ -420,38 +526,85 @@ namespace bsoid
             return mLog.str();
         }
 
+        PolygonizerStats const& MarchingCubes::getStats() const
+        {
+            return mStats;
+        }
+
+        void MarchingCubes::setProgress(Progress* progress)
+        {
+            mProgress = progress;
+        }
+
+        void MarchingCubes::beginPhase()
+        {
+            mMemory.reset();
+            atlas::core::resetPeakRSS();
+
+            // Created for every phase so it watches the arena the phase runs
+            // in.
+            mObserver.reset();
+            if (utilization::isEnabled())
+            {
+                mObserver = std::make_unique<UtilizationObserver>();
+                mObserver->beginPhase();
+            }
+        }
+
+        void MarchingCubes::endPhase(std::string const& name, double seconds)
+        {
+            PhaseStats phase;
+            phase.name = name;
+            phase.seconds = seconds;
+            phase.bytes = mMemory.getCurrent();
+            phase.peakBytes = mMemory.getPeak();
+            phase.allocations = mMemory.getAllocations();
+            phase.rss = atlas::core::getCurrentRSS();
+            phase.peakRSS = atlas::core::getPeakRSS();
+            if (mObserver)
+            {
+                mObserver->endPhase(phase);
+                mObserver.reset();
+            }
+            mStats.phases.push_back(phase);
+
+            mLog << "Phase " << name << ": " << seconds << " seconds, " <<
+                phase.bytes << " bytes (peak " << phase.peakBytes << "), " <<
+                phase.allocations << " allocations, RSS " << phase.rss <<
+                " bytes (peak " << phase.peakRSS << ")\n";
+            writeUtilization(phase, mLog);
+        }
+
         void MarchingCubes::clearLog()
         {
             mLog.str(std::string());
         }
 
-        void MarchingCubes::saveMesh()
+        void MarchingCubes::saveMesh(atlas::utils::MeshFormat format)
         {
-            mMesh.saveToFile(mName + "_mc.obj");
+            mMesh.saveToFile(
+                mName + "_mc" + atlas::utils::getFormatExtension(format),
+                format);
         }
 
         std::size_t MarchingCubes::size() const
         {
-            std::size_t gridSize = mGrid.size() * mGrid.size() * mGrid.size() * 
-                sizeof(VoxelPoint);
-            std::size_t vertsSize = mVertices.size() * sizeof(atlas::math::Point);
-            std::size_t normsSize = mNormals.size() * sizeof(atlas::math::Normal);
-            std::size_t idxSize = mIndices.size() * sizeof(std::uint32_t);
-            return gridSize + vertsSize + normsSize + idxSize;
+            return mMemory.getCurrent();
         }
 
         void MarchingCubes::constructGrid()
         {
             using atlas::math::Point;
 
+            PROFILE_ZONE("MarchingCubes::constructGrid");
+
             auto modelBox = mTree->getTreeBox();
             auto start = modelBox.pMin;
             auto end = modelBox.pMax;
 
             // Initialize the grid to the set resolution.
-            mGrid.resize(mResolution.x,
-                std::vector<std::vector<VoxelPoint>>(mResolution.y,
-                    std::vector<VoxelPoint>(mResolution.z)));
+            mGrid.resize(mResolution.x, GridSlice(mResolution.y,
+                GridColumn(mResolution.z, &mMemory), &mMemory));
 
             // Compute the seize of each voxel.
             glm::vec3 delta = (glm::abs(start - end));
@@ -459,12 +612,21 @@ namespace bsoid
             delta.y /= mResolution.y - 1;
             delta.z /= mResolution.z - 1;
 
+            if (mProgress)
+            {
+                mProgress->beginStep("grid",
+                    static_cast<std::uint64_t>(mResolution.x) * mResolution.y);
+            }
+
+            UTILIZATION_PARALLEL();
             tbb::parallel_for(static_cast<std::uint32_t>(0), mResolution.x,
                 [this, start, delta](std::uint32_t x) {
                 tbb::parallel_for(static_cast<std::uint32_t>(0), mResolution.y,
                     [this, start, delta, x](std::uint32_t y) {
+                    PROFILE_ZONE("grid row");
                     tbb::parallel_for(static_cast<std::uint32_t>(0), mResolution.z,
                         [this, start, delta, x, y](std::uint32_t z) {
+                        UTILIZATION_TASK();
                         Point pt =
                         {
                             start.x + x * delta.x,
@@ -475,206 +637,274 @@ namespace bsoid
                         mGrid[x][y][z].data.w = mTree->eval(pt);
                         mGrid[x][y][z].data.xyz = pt;
                     });
+
+                    if (mProgress)
+                    {
+                        mProgress->advance();
+                    }
                 });
             });
         }
         
-        void MarchingCubes::createTriangles()
+        std::size_t MarchingCubes::createTriangles(MeshSink& sink)
         {
             using atlas::math::Point;
+            using atlas::utils::BBox;
 
+            PROFILE_ZONE("MarchingCubes::createTriangles");
             auto interpolateVertices = [this](Point const& p1, Point const& p2, 
                 float val1, float val2)
             {
                 return glm::mix(p1, p2, (mMagic - val1) / (val2 - val1));
             };
 
-            struct Voxel
+            // Vertices are identified by the grid edge they lie on, which is
+            // the grid point with the smallest coordinates plus the axis.
+            auto edgeKey = [this](glm::u32vec3 const& p, std::uint32_t axis)
             {
-                Voxel() :
-                    vertices(8)
-                { }
-
-                std::vector<VoxelPoint> vertices;
+                std::uint64_t id = (static_cast<std::uint64_t>(p.x) *
+                    mResolution.y + p.y) * mResolution.z + p.z;
+                return id * 3 + axis;
             };
 
-            tbb::parallel_for(static_cast<std::uint32_t>(0), mResolution.x,
-                [this, interpolateVertices](std::uint32_t x) {
-                tbb::parallel_for(static_cast<std::uint32_t>(0), mResolution.y,
-                    [this, interpolateVertices, x](std::uint32_t y) {
-                    tbb::parallel_for(static_cast<std::uint32_t>(0), mResolution.z,
-                        [this, interpolateVertices, x, y](std::uint32_t z) {
-                        Voxel v;
-                        for (std::size_t i = 0; i < 8; ++i)
-                        {
-                            std::size_t newX = x + VoxelDecals[i][0];
-                            std::size_t newY = y + VoxelDecals[i][1];
-                            std::size_t newZ = z + VoxelDecals[i][2];
-
-                            newX = (newX < mResolution.x) ?
-                                newX : mResolution.x - 1;
-                            newY = (newY < mResolution.y) ?
-                                newY : mResolution.y - 1;
-                            newZ = (newZ < mResolution.z) ?
-                                newZ : mResolution.z - 1;
-                            v.vertices[i] = mGrid[newX][newY][newZ];
-                        }
-
-                        std::uint32_t voxelIndex = 0;
-                        std::vector<std::uint32_t> coeffs =
-                        { 1, 2, 4, 8, 16, 32, 64, 128 };
-                        for (std::size_t i = 0; i < 8; ++i)
-                        {
-                            voxelIndex |=
-                                (v.vertices[i].data.w < mMagic) ?
-                                coeffs[i] : 0;
-                        }
+            // The grid is split into blocks of voxels and every block becomes
+            // one chunk, whose triangles are first built with local indices.
+            // Only vertices on the faces of a block can be shared with other
+            // blocks, so only those are flagged for welding.
+            constexpr std::uint32_t blockSize = ChunkSize;
+            constexpr std::uint8_t onFace = 1;
+            constexpr std::uint8_t onNextSlab = 2;
+            struct LocalChunk
+            {
+                LocalChunk(atlas::core::MemoryCounter* memory) :
+                    edges(memory),
+                    shared(memory),
+                    vertices(memory),
+                    normals(memory),
+                    indices(memory)
+                { }
 
-                        if (EdgeTable[voxelIndex] == 0)
-                        {
-                            return;
-                        }
+                BBox bounds;
+                Vector<std::uint64_t> edges;
+                Vector<std::uint8_t> shared;
+                Vector<Point> vertices;
+                Vector<atlas::math::Normal> normals;
+                Vector<std::uint32_t> indices;
+            };
 
-                        std::vector<Point> vertList(12);
-                        if (EdgeTable[voxelIndex] & 1)
-                        {
-                            vertList[0] = interpolateVertices(
-                                v.vertices[0].data.xyz(),
-                                v.vertices[1].data.xyz(),
-                                v.vertices[0].data.w,
-                                v.vertices[1].data.w);
-                        }
+            auto numBlocks = [](std::uint32_t res)
+            {
+                return (res > 1) ? (res - 2) / blockSize + 1 : 0;
+            };
+            glm::u32vec3 blocks(numBlocks(mResolution.x),
+                numBlocks(mResolution.y), numBlocks(mResolution.z));
 
-                        if (EdgeTable[voxelIndex] & 2)
-                        {
-                            vertList[1] = interpolateVertices(
-                                v.vertices[1].data.xyz(),
-                                v.vertices[2].data.xyz(),
-                                v.vertices[1].data.w,
-                                v.vertices[2].data.w);
-                        }
+            auto getBlock = [blocks](std::uint32_t block)
+            {
+                return glm::u32vec3(block / (blocks.y * blocks.z),
+                    (block / blocks.z) % blocks.y, block % blocks.z);
+            };
 
-                        if (EdgeTable[voxelIndex] & 4)
+            auto makeLocal = [this, interpolateVertices, edgeKey, getBlock](
+                std::uint32_t block, LocalChunk& local)
+            {
+                PROFILE_ZONE("triangulate chunk");
+                UTILIZATION_TASK();
+                glm::u32vec3 begin = getBlock(block) * blockSize;
+                auto end = glm::min(begin + blockSize, mResolution - 1u);
+
+                HashMap<std::uint64_t, std::uint32_t> localMap(&mMemory);
+                for (std::uint32_t x = begin.x; x < end.x; ++x)
+                {
+                    for (std::uint32_t y = begin.y; y < end.y; ++y)
+                    {
+                        for (std::uint32_t z = begin.z; z < end.z; ++z)
                         {
-                            vertList[2] = interpolateVertices(
-                                v.vertices[2].data.xyz(),
-                                v.vertices[3].data.xyz(),
-                                v.vertices[2].data.w,
-                                v.vertices[3].data.w);
-                        }
+                            glm::u32vec3 corners[8];
+                            for (std::size_t i = 0; i < 8; ++i)
+                            {
+                                corners[i] = glm::u32vec3(
+                                    x + VoxelDecals[i][0],
+                                    y + VoxelDecals[i][1],
+                                    z + VoxelDecals[i][2]);
+                            }
 
-                        if (EdgeTable[voxelIndex] & 8)
-                        {
-                            vertList[3] = interpolateVertices(
-                                v.vertices[3].data.xyz(),
-                                v.vertices[0].data.xyz(),
-                                v.vertices[3].data.w,
-                                v.vertices[0].data.w);
-                        }
+                            auto corner = [this, &corners](std::size_t i)
+                            {
+                                auto const& c = corners[i];
+                                return mGrid[c.x][c.y][c.z].data;
+                            };
 
-                        if (EdgeTable[voxelIndex] & 16)
-                        {
-                            vertList[4] = interpolateVertices(
-                                v.vertices[4].data.xyz(),
-                                v.vertices[5].data.xyz(),
-                                v.vertices[4].data.w,
-                                v.vertices[5].data.w);
-                        }
+                            std::uint32_t voxelIndex = 0;
+                            for (std::size_t i = 0; i < 8; ++i)
+                            {
+                                voxelIndex |=
+                                    (corner(i).w < mMagic) ? (1 << i) : 0;
+                            }
 
-                        if (EdgeTable[voxelIndex] & 32)
-                        {
-                            vertList[5] = interpolateVertices(
-                                v.vertices[5].data.xyz(),
-                                v.vertices[6].data.xyz(),
-                                v.vertices[5].data.w,
-                                v.vertices[6].data.w);
-                        }
+                            if (EdgeTable[voxelIndex] == 0)
+                            {
+                                continue;
+                            }
 
-                        if (EdgeTable[voxelIndex] & 64)
-                        {
-                            vertList[6] = interpolateVertices(
-                                v.vertices[6].data.xyz(),
-                                v.vertices[7].data.xyz(),
-                                v.vertices[6].data.w,
-                                v.vertices[7].data.w);
-                        }
+                            std::uint32_t vertList[12];
+                            for (int e = 0; e < 12; ++e)
+                            {
+                                if (!(EdgeTable[voxelIndex] & (1 << e)))
+                                {
+                                    continue;
+                                }
+
+                                auto c1 = EdgeCorners[e][0];
+                                auto c2 = EdgeCorners[e][1];
+                                auto p = glm::min(corners[c1], corners[c2]);
+                                auto d = corners[c1] - corners[c2];
+                                std::uint32_t axis = (d.x != 0) ? 0 :
+                                    ((d.y != 0) ? 1 : 2);
+                                auto key = edgeKey(p, axis);
+
+                                auto entry = localMap.find(key);
+                                if (entry != localMap.end())
+                                {
+                                    vertList[e] = (*entry).second;
+                                    continue;
+                                }
+
+                                auto v1 = corner(c1);
+                                auto v2 = corner(c2);
+                                auto vert = interpolateVertices(v1.xyz(),
+                                    v2.xyz(), v1.w, v2.w);
+
+                                std::uint8_t shared = 0;
+                                if ((axis != 0 && p.x % blockSize == 0) ||
+                                    (axis != 1 && p.y % blockSize == 0) ||
+                                    (axis != 2 && p.z % blockSize == 0))
+                                {
+                                    shared |= onFace;
+                                }
+                                if (axis != 0 && p.x == begin.x + blockSize)
+                                {
+                                    shared |= onNextSlab;
+                                }
+
+                                vertList[e] = static_cast<std::uint32_t>(
+                                    local.vertices.size());
+                                localMap.insert(
+                                    std::pair<std::uint64_t, std::uint32_t>(key,
+                                        vertList[e]));
+                                local.edges.push_back(key);
+                                local.shared.push_back(shared);
+                                local.vertices.push_back(vert);
+                                local.normals.push_back(-mTree->grad(vert));
+                                local.bounds = join(local.bounds, BBox(vert));
+                            }
 
-                        if (EdgeTable[voxelIndex] & 128)
-                        {
-                            vertList[7] = interpolateVertices(
-                                v.vertices[7].data.xyz(),
-                                v.vertices[4].data.xyz(),
-                                v.vertices[7].data.w,
-                                v.vertices[4].data.w);
+                            for (int t = 0;
+                                TriangleTable[voxelIndex][t] != -1; ++t)
+                            {
+                                local.indices.push_back(
+                                    vertList[TriangleTable[voxelIndex][t]]);
+                            }
                         }
+                    }
+                }
+            };
 
-                        if (EdgeTable[voxelIndex] & 256)
-                        {
-                            vertList[8] = interpolateVertices(
-                                v.vertices[0].data.xyz(),
-                                v.vertices[4].data.xyz(),
-                                v.vertices[0].data.w,
-                                v.vertices[4].data.w);
-                        }
+            // Every slab of blocks along x is processed as one batch. Only
+            // the face vertices of the slab being processed and those shared
+            // with the next slab need to be remembered across chunks.
+            std::uint32_t batchSize = blocks.y * blocks.z;
+            std::uint32_t numChunks = blocks.x * batchSize;
+            HashMap<std::uint64_t, std::uint32_t> indexMap(&mMemory);
+            HashMap<std::uint64_t, std::uint32_t> nextMap(&mMemory);
+            std::uint32_t numVertices = 0;
+            if (mProgress)
+            {
+                mProgress->beginStep("triangles", numChunks);
+            }
 
-                        if (EdgeTable[voxelIndex] & 512)
+            for (std::uint32_t start = 0; start < numChunks; start += batchSize)
+            {
+                std::uint32_t end = start + batchSize;
+                Vector<LocalChunk> locals(batchSize, LocalChunk(&mMemory),
+                    &mMemory);
+
+                {
+                    UTILIZATION_PARALLEL();
+                    tbb::parallel_for(start, end,
+                        [&makeLocal, &locals, start](std::uint32_t block)
+                    {
+                        makeLocal(block, locals[block - start]);
+                    });
+                }
+
+                PROFILE_ZONE("weld chunks");
+                for (std::uint32_t block = start; block < end; ++block)
+                {
+                    auto& local = locals[block - start];
+                    if (local.indices.empty())
+                    {
+                        continue;
+                    }
+
+                    MeshChunk chunk;
+                    chunk.id = getChunkId(getBlock(block));
+                    chunk.vertexOffset = numVertices;
+                    chunk.bounds = local.bounds;
+
+                    Vector<std::uint32_t> globalIndex(local.vertices.size(),
+                        0, &mMemory);
+                    for (std::size_t v = 0; v < local.vertices.size(); ++v)
+                    {
+                        if (local.shared[v] & onFace)
                         {
-                            vertList[9] = interpolateVertices(
-                                v.vertices[1].data.xyz(),
-                                v.vertices[5].data.xyz(),
-                                v.vertices[1].data.w,
-                                v.vertices[5].data.w);
+                            auto entry = indexMap.find(local.edges[v]);
+                            if (entry != indexMap.end())
+                            {
+                                globalIndex[v] = (*entry).second;
+                                continue;
+                            }
                         }
 
-                        if (EdgeTable[voxelIndex] & 1024)
-                        {
-                            vertList[10] = interpolateVertices(
-                                v.vertices[2].data.xyz(),
-                                v.vertices[6].data.xyz(),
-                                v.vertices[2].data.w,
-                                v.vertices[6].data.w);
-                        }
+                        globalIndex[v] = numVertices++;
+                        chunk.vertices.push_back(local.vertices[v]);
+                        chunk.normals.push_back(local.normals[v]);
 
-                        if (EdgeTable[voxelIndex] & 2048)
+                        if (local.shared[v] & onFace)
                         {
-                            vertList[11] = interpolateVertices(
-                                v.vertices[3].data.xyz(),
-                                v.vertices[7].data.xyz(),
-                                v.vertices[3].data.w,
-                                v.vertices[7].data.w);
+                            indexMap.insert(
+                                std::pair<std::uint64_t, std::uint32_t>(
+                                    local.edges[v], globalIndex[v]));
                         }
-
-                        // Critical section
+                        if (local.shared[v] & onNextSlab)
                         {
-                            std::lock_guard<std::mutex> lock(mDataMutex);
-                            for (int i = 0; TriangleTable[voxelIndex][i] != -1;
-                                i += 3)
-                            {
-                                auto vert = 
-                                    vertList[TriangleTable[voxelIndex][i + 0]];
-                                auto normal = mTree->grad(vert);
-                                mVertices.push_back(vert);
-                                mNormals.push_back(-normal);
-
-                                vert = 
-                                    vertList[TriangleTable[voxelIndex][i + 1]];
-                                normal = mTree->grad(vert);
-                                mVertices.push_back(vert);
-                                mNormals.push_back(-normal);
-
-                                vert = 
-                                    vertList[TriangleTable[voxelIndex][i + 2]];
-                                normal = mTree->grad(vert);
-                                mVertices.push_back(vert);
-                                mNormals.push_back(-normal);
-                            }
+                            nextMap.insert(
+                                std::pair<std::uint64_t, std::uint32_t>(
+                                    local.edges[v], globalIndex[v]));
                         }
-                    });
-                });
-            });
+                    }
+
+                    chunk.indices.reserve(local.indices.size());
+                    for (auto index : local.indices)
+                    {
+                        chunk.indices.push_back(globalIndex[index]);
+                    }
+
+                    sink.write(chunk);
+                }
+
+                // Vertices on the face shared with the next slab went into
+                // nextMap when they were created.
+                indexMap.swap(nextMap);
+                nextMap.clear();
+
+                if (mProgress)
+                {
+                    mProgress->advance(end - start);
+                }
+            }
 
-            mIndices.resize(mVertices.size());
-            std::iota(std::begin(mIndices), std::end(mIndices), 0);
+            return numVertices;
         }
     }
 }
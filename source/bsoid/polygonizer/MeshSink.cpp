@@ -0,0 +1,558 @@
+#include "bsoid/polygonizer/MeshSink.hpp"
+
+#include <atlas/core/Log.hpp>
+#include <atlas/utils/MeshSimplifier.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    using atlas::math::Normal;
+    using bsoid::polygonizer::NormalFormat;
+
+    // Signed normalized 10-bit components with x in the low bits. The w
+    // component is left at 0.
+    std::uint32_t packNormal(Normal const& normal)
+    {
+        float length = glm::length(normal);
+        Normal n = (length > 0.0f) ? normal / length : Normal(0.0f);
+
+        auto pack = [](float value)
+        {
+            auto i = static_cast<std::int32_t>(
+                std::round(glm::clamp(value, -1.0f, 1.0f) * 511.0f));
+            return static_cast<std::uint32_t>(i) & 0x3FF;
+        };
+
+        return pack(n.x) | (pack(n.y) << 10) | (pack(n.z) << 20);
+    }
+}
+
+namespace bsoid
+{
+    namespace polygonizer
+    {
+        std::size_t getVertexStride(NormalFormat format)
+        {
+            return sizeof(atlas::math::Point) +
+                ((format == NormalFormat::Packed) ? sizeof(std::uint32_t) :
+                sizeof(atlas::math::Normal));
+        }
+
+        void writeInterleaved(atlas::math::Point const* positions,
+            atlas::math::Normal const* normals, std::size_t count,
+            NormalFormat format, void* out)
+        {
+            auto stride = getVertexStride(format);
+            auto bytes = static_cast<unsigned char*>(out);
+            using Range = tbb::blocked_range<std::size_t>;
+            tbb::parallel_for(Range(0, count, 4096),
+                [positions, normals, format, stride, bytes](Range const& range)
+            {
+                for (auto i = range.begin(); i != range.end(); ++i)
+                {
+                    auto vertex = bytes + i * stride;
+                    std::memcpy(vertex, &positions[i],
+                        sizeof(atlas::math::Point));
+                    vertex += sizeof(atlas::math::Point);
+
+                    if (format == NormalFormat::Packed)
+                    {
+                        auto packed = packNormal(normals[i]);
+                        std::memcpy(vertex, &packed, sizeof(packed));
+                    }
+                    else
+                    {
+                        std::memcpy(vertex, &normals[i],
+                            sizeof(atlas::math::Normal));
+                    }
+                }
+            });
+        }
+
+        std::vector<std::size_t> getChunkOffsets(
+            std::vector<MeshChunkRange> const& chunks, std::size_t numIndices)
+        {
+            std::vector<std::size_t> offsets;
+            std::size_t next = 0;
+            for (auto& chunk : chunks)
+            {
+                if (chunk.firstIndex != next)
+                {
+                    return {};
+                }
+
+                offsets.push_back(chunk.firstIndex);
+                next += chunk.numIndices;
+            }
+
+            if (next != numIndices)
+            {
+                return {};
+            }
+
+            return offsets;
+        }
+
+        MemoryMeshSink::MemoryMeshSink(atlas::utils::Mesh& mesh) :
+            mMesh(mesh),
+            mChunks(nullptr)
+        { }
+
+        MemoryMeshSink::MemoryMeshSink(atlas::utils::Mesh& mesh,
+            std::vector<MeshChunkRange>& chunks) :
+            mMesh(mesh),
+            mChunks(&chunks)
+        { }
+
+        void MemoryMeshSink::begin()
+        {
+            mMesh.vertices().clear();
+            mMesh.normals().clear();
+            mMesh.texCoords().clear();
+            mMesh.indices().clear();
+            if (mChunks)
+            {
+                mChunks->clear();
+            }
+        }
+
+        void MemoryMeshSink::write(MeshChunk const& chunk)
+        {
+            if (mChunks)
+            {
+                MeshChunkRange range;
+                range.id = chunk.id;
+                range.firstIndex =
+                    static_cast<std::uint32_t>(mMesh.indices().size());
+                range.numIndices =
+                    static_cast<std::uint32_t>(chunk.indices.size());
+                range.bounds = chunk.bounds;
+                mChunks->push_back(range);
+            }
+
+            mMesh.vertices().insert(mMesh.vertices().end(),
+                chunk.vertices.begin(), chunk.vertices.end());
+            mMesh.normals().insert(mMesh.normals().end(),
+                chunk.normals.begin(), chunk.normals.end());
+            mMesh.indices().insert(mMesh.indices().end(),
+                chunk.indices.begin(), chunk.indices.end());
+        }
+
+        // The element counts are only known at the end, so they are written
+        // as fixed-width fields that can be patched in place.
+        static const char* kCountPlaceholder = "0000000000";
+        static const std::size_t kCountWidth = 10;
+
+        FileMeshSink::FileMeshSink(std::string const& filename) :
+            mFilename(filename),
+            mFacesFilename(filename + ".faces"),
+            mVertexCountOffset(0),
+            mFaceCountOffset(0),
+            mNumVertices(0),
+            mNumFaces(0),
+            mGood(false)
+        { }
+
+        FileMeshSink::~FileMeshSink()
+        {
+            if (mFaces)
+            {
+                mFaces.reset();
+                std::remove(mFacesFilename.c_str());
+            }
+        }
+
+        void FileMeshSink::begin()
+        {
+            using atlas::utils::BlockWriter;
+
+            mNumVertices = 0;
+            mNumFaces = 0;
+            mFile = std::make_unique<BlockWriter>(mFilename);
+            mFaces = std::make_unique<BlockWriter>(mFacesFilename);
+            mGood = mFile->isOpen() && mFaces->isOpen();
+
+            std::string header = "ply\n";
+            header += "format binary_little_endian 1.0\n";
+            header += "element vertex ";
+            mVertexCountOffset = header.size();
+            header += kCountPlaceholder;
+            header += "\n";
+            header += "property float x\n";
+            header += "property float y\n";
+            header += "property float z\n";
+            header += "property float nx\n";
+            header += "property float ny\n";
+            header += "property float nz\n";
+            header += "element face ";
+            mFaceCountOffset = header.size();
+            header += kCountPlaceholder;
+            header += "\n";
+            header += "property list uchar int vertex_indices\n";
+            header += "end_header\n";
+            mFile->write(header.data(), header.size());
+        }
+
+        void FileMeshSink::write(MeshChunk const& chunk)
+        {
+            if (!mGood)
+            {
+                return;
+            }
+
+            float record[6];
+            for (std::size_t i = 0; i < chunk.vertices.size(); ++i)
+            {
+                auto const& v = chunk.vertices[i];
+                auto const& n = chunk.normals[i];
+                record[0] = v.x;
+                record[1] = v.y;
+                record[2] = v.z;
+                record[3] = n.x;
+                record[4] = n.y;
+                record[5] = n.z;
+                mFile->write(record, sizeof(record));
+            }
+
+            constexpr std::size_t faceSize = 1 + 3 * sizeof(std::uint32_t);
+            char face[faceSize];
+            face[0] = 3;
+            for (std::size_t i = 0; i + 2 < chunk.indices.size(); i += 3)
+            {
+                std::memcpy(face + 1, &chunk.indices[i],
+                    3 * sizeof(std::uint32_t));
+                mFaces->write(face, faceSize);
+            }
+
+            mNumVertices += chunk.vertices.size();
+            mNumFaces += chunk.indices.size() / 3;
+        }
+
+        void FileMeshSink::end()
+        {
+            if (!mFile || !mFaces)
+            {
+                return;
+            }
+
+            // Append the staged faces to the end of the file.
+            mFaces->close();
+            mGood = mGood && mFaces->good();
+            mFaces.reset();
+
+            std::FILE* faces = std::fopen(mFacesFilename.c_str(), "rb");
+            if (faces)
+            {
+                std::vector<char> buffer(atlas::utils::BlockWriter::DefaultBlockSize);
+                std::size_t read;
+                while ((read = std::fread(buffer.data(), 1, buffer.size(),
+                    faces)) > 0)
+                {
+                    mFile->write(buffer.data(), read);
+                }
+                std::fclose(faces);
+            }
+            else
+            {
+                mGood = false;
+            }
+            std::remove(mFacesFilename.c_str());
+
+            auto patch = [this](std::size_t offset, std::uint64_t count)
+            {
+                auto text = std::to_string(count);
+                std::string field(kCountWidth - text.size(), '0');
+                field += text;
+                mFile->writeAt(offset, field.data(), field.size());
+            };
+
+            patch(mVertexCountOffset, mNumVertices);
+            patch(mFaceCountOffset, mNumFaces);
+
+            mFile->close();
+            mGood = mGood && mFile->good();
+            mFile.reset();
+
+            if (!mGood)
+            {
+                ERROR_LOG_V("Could not write mesh to %s.", mFilename.c_str());
+            }
+        }
+
+        bool FileMeshSink::good() const
+        {
+            return mGood;
+        }
+
+        CallbackMeshSink::CallbackMeshSink(Callback const& callback) :
+            mCallback(callback)
+        { }
+
+        void CallbackMeshSink::write(MeshChunk const& chunk)
+        {
+            mCallback(chunk);
+        }
+
+        SimplifyMeshSink::SimplifyMeshSink(MeshSink& sink, float ratio,
+            float maxError) :
+            mSink(sink),
+            mRatio(ratio),
+            mMaxError(maxError),
+            mNumVertices(0)
+        { }
+
+        void SimplifyMeshSink::begin()
+        {
+            mNumVertices = 0;
+            mBorder.clear();
+            mStats = atlas::utils::SimplifyStats();
+            mSink.begin();
+        }
+
+        void SimplifyMeshSink::write(MeshChunk const& chunk)
+        {
+            using atlas::math::Point;
+            using atlas::math::Normal;
+            using atlas::utils::BBox;
+
+            // Gather the chunk into a standalone triangle list. Vertices from
+            // earlier chunks are always on the border, so they were kept.
+            std::unordered_map<std::uint32_t, std::uint32_t> localIndex;
+            std::vector<std::uint32_t> sourceIndex;
+            std::vector<Point> vertices;
+            std::vector<Normal> normals;
+            std::vector<GLuint> indices;
+            indices.reserve(chunk.indices.size());
+
+            for (auto index : chunk.indices)
+            {
+                auto entry = localIndex.find(index);
+                if (entry == localIndex.end())
+                {
+                    auto id = static_cast<std::uint32_t>(vertices.size());
+                    entry = localIndex.insert(
+                        std::pair<std::uint32_t, std::uint32_t>(index, id)).first;
+                    sourceIndex.push_back(index);
+
+                    if (index >= chunk.vertexOffset)
+                    {
+                        vertices.push_back(
+                            chunk.vertices[index - chunk.vertexOffset]);
+                        normals.push_back(
+                            chunk.normals[index - chunk.vertexOffset]);
+                    }
+                    else
+                    {
+                        auto const& border = mBorder.at(index);
+                        vertices.push_back(border.position);
+                        normals.push_back(border.normal);
+                    }
+                }
+                indices.push_back((*entry).second);
+            }
+
+            auto target = static_cast<std::size_t>(
+                std::ceil(mRatio * (indices.size() / 3)));
+            atlas::utils::SimplifyStats stats;
+            atlas::utils::simplifyTriangles(vertices, normals, indices, target,
+                mMaxError, &stats);
+            mStats += stats;
+            auto border = atlas::utils::findBorderVertices(indices,
+                vertices.size());
+
+            MeshChunk result;
+            result.id = chunk.id;
+            result.vertexOffset = mNumVertices;
+            result.indices.reserve(indices.size());
+
+            constexpr auto unused = std::numeric_limits<std::uint32_t>::max();
+            std::vector<std::uint32_t> outIndex(vertices.size(), unused);
+            for (auto index : indices)
+            {
+                if (outIndex[index] == unused)
+                {
+                    auto source = sourceIndex[index];
+                    if (source < chunk.vertexOffset)
+                    {
+                        outIndex[index] = mBorder.at(source).index;
+                    }
+                    else
+                    {
+                        outIndex[index] = mNumVertices++;
+                        result.vertices.push_back(vertices[index]);
+                        result.normals.push_back(normals[index]);
+                        if (border[index])
+                        {
+                            mBorder[source] = { outIndex[index],
+                                vertices[index], normals[index] };
+                        }
+                    }
+                    result.bounds = join(result.bounds, BBox(vertices[index]));
+                }
+                result.indices.push_back(outIndex[index]);
+            }
+
+            if (!result.indices.empty())
+            {
+                mSink.write(result);
+            }
+        }
+
+        void SimplifyMeshSink::end()
+        {
+            mBorder.clear();
+            if (mStats.inputTriangles > 0)
+            {
+                atlas::utils::logSimplifyStats(mStats);
+            }
+            mSink.end();
+        }
+
+        QueueMeshSink::QueueMeshSink(MeshSink& sink) :
+            mSink(sink),
+            mHead(new Node()),
+            mPadding(),
+            mTail(mHead)
+        { }
+
+        QueueMeshSink::~QueueMeshSink()
+        {
+            while (mHead)
+            {
+                auto next = mHead->next.load(std::memory_order_relaxed);
+                delete mHead;
+                mHead = next;
+            }
+        }
+
+        void QueueMeshSink::begin()
+        {
+            mSink.begin();
+        }
+
+        void QueueMeshSink::write(MeshChunk const& chunk)
+        {
+            mSink.write(chunk);
+
+            auto node = new Node();
+            node->chunk = chunk;
+            mTail->next.store(node, std::memory_order_release);
+            mTail = node;
+        }
+
+        void QueueMeshSink::end()
+        {
+            mSink.end();
+        }
+
+        bool QueueMeshSink::pop(MeshChunk& chunk)
+        {
+            auto next = mHead->next.load(std::memory_order_acquire);
+            if (!next)
+            {
+                return false;
+            }
+
+            chunk = std::move(next->chunk);
+            delete mHead;
+            mHead = next;
+            return true;
+        }
+
+        InterleavedMeshSink::InterleavedMeshSink(void* vertices,
+            std::size_t maxVertices, std::uint32_t* indices,
+            std::size_t maxIndices, NormalFormat format) :
+            mVertices(static_cast<unsigned char*>(vertices)),
+            mMaxVertices(maxVertices),
+            mIndices(indices),
+            mMaxIndices(maxIndices),
+            mFormat(format),
+            mNumVertices(0),
+            mNumIndices(0)
+        { }
+
+        void InterleavedMeshSink::begin()
+        {
+            mNumVertices = 0;
+            mNumIndices = 0;
+        }
+
+        void InterleavedMeshSink::write(MeshChunk const& chunk)
+        {
+            auto numVertices = chunk.vertices.size();
+            if (chunk.vertexOffset + numVertices <= mMaxVertices)
+            {
+                writeInterleaved(chunk.vertices.data(), chunk.normals.data(),
+                    numVertices, mFormat, mVertices +
+                    chunk.vertexOffset * getVertexStride(mFormat));
+            }
+
+            if (mNumIndices + chunk.indices.size() <= mMaxIndices)
+            {
+                std::copy(chunk.indices.begin(), chunk.indices.end(),
+                    mIndices + mNumIndices);
+            }
+
+            mNumVertices = std::max<std::size_t>(mNumVertices,
+                chunk.vertexOffset + numVertices);
+            mNumIndices += chunk.indices.size();
+        }
+
+        std::size_t InterleavedMeshSink::numVertices() const
+        {
+            return mNumVertices;
+        }
+
+        std::size_t InterleavedMeshSink::numIndices() const
+        {
+            return mNumIndices;
+        }
+
+        bool InterleavedMeshSink::overflowed() const
+        {
+            return mNumVertices > mMaxVertices || mNumIndices > mMaxIndices;
+        }
+
+        NullMeshSink::NullMeshSink() :
+            mNumVertices(0),
+            mNumTriangles(0),
+            mNumChunks(0)
+        { }
+
+        void NullMeshSink::begin()
+        {
+            mNumVertices = 0;
+            mNumTriangles = 0;
+            mNumChunks = 0;
+        }
+
+        void NullMeshSink::write(MeshChunk const& chunk)
+        {
+            mNumVertices += chunk.vertices.size();
+            mNumTriangles += chunk.indices.size() / 3;
+            mNumChunks++;
+        }
+
+        std::uint64_t NullMeshSink::numVertices() const
+        {
+            return mNumVertices;
+        }
+
+        std::uint64_t NullMeshSink::numTriangles() const
+        {
+            return mNumTriangles;
+        }
+
+        std::uint64_t NullMeshSink::numChunks() const
+        {
+            return mNumChunks;
+        }
+    }
+}
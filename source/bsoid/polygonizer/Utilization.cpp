@@ -0,0 +1,338 @@
+#include "bsoid/polygonizer/Utilization.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Written only by the thread itself, read by the observer once the
+    // phase is over.
+    struct ThreadCounters
+    {
+        ThreadCounters() :
+            id(0),
+            depth(0),
+            start(0),
+            parallelDepth(0),
+            parallelStart(0),
+            busy(0),
+            tasks(0),
+            parallel(0)
+        { }
+
+        std::uint32_t id;
+        std::uint32_t depth;
+        std::uint64_t start;
+        std::uint32_t parallelDepth;
+        std::uint64_t parallelStart;
+        std::atomic<std::uint64_t> busy;
+        std::atomic<std::uint64_t> tasks;
+        std::atomic<std::uint64_t> parallel;
+    };
+
+    // As with the profiler, the counters belong to the registry so threads
+    // that exit are still accounted for.
+    struct Registry
+    {
+        Registry() :
+            epoch(Clock::now()),
+            enabled(false)
+        { }
+
+        Clock::time_point epoch;
+        std::atomic<bool> enabled;
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadCounters>> threads;
+    };
+
+    Registry& getRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    ThreadCounters& getThreadCounters()
+    {
+        static thread_local ThreadCounters* counters = nullptr;
+        if (!counters)
+        {
+            auto& registry = getRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.threads.emplace_back(new ThreadCounters());
+            counters = registry.threads.back().get();
+            counters->id = static_cast<std::uint32_t>(
+                registry.threads.size() - 1);
+        }
+
+        return *counters;
+    }
+
+    std::uint64_t now()
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - getRegistry().epoch).count());
+    }
+
+    double toSeconds(std::uint64_t ns)
+    {
+        return static_cast<double>(ns) / 1e9;
+    }
+}
+
+namespace bsoid
+{
+    namespace polygonizer
+    {
+        namespace utilization
+        {
+            void setEnabled(bool enabled)
+            {
+                getRegistry().enabled.store(enabled,
+                    std::memory_order_relaxed);
+            }
+
+            bool isEnabled()
+            {
+                return getRegistry().enabled.load(std::memory_order_relaxed);
+            }
+
+            void beginTask()
+            {
+                auto& counters = getThreadCounters();
+                if (counters.depth++ == 0)
+                {
+                    counters.start = now();
+                }
+            }
+
+            void endTask()
+            {
+                auto& counters = getThreadCounters();
+                if (counters.depth == 0 || --counters.depth != 0)
+                {
+                    return;
+                }
+
+                auto elapsed = now() - counters.start;
+                counters.busy.store(counters.busy.load(
+                    std::memory_order_relaxed) + elapsed,
+                    std::memory_order_relaxed);
+                counters.tasks.store(counters.tasks.load(
+                    std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+            }
+
+            // Inside a task the thread is in the arena already, so only
+            // regions that start outside of one are timed.
+            void beginParallel()
+            {
+                auto& counters = getThreadCounters();
+                if (counters.depth == 0 && counters.parallelDepth++ == 0)
+                {
+                    counters.parallelStart = now();
+                }
+            }
+
+            void endParallel()
+            {
+                auto& counters = getThreadCounters();
+                if (counters.depth != 0 || counters.parallelDepth == 0 ||
+                    --counters.parallelDepth != 0)
+                {
+                    return;
+                }
+
+                auto elapsed = now() - counters.parallelStart;
+                counters.parallel.store(counters.parallel.load(
+                    std::memory_order_relaxed) + elapsed,
+                    std::memory_order_relaxed);
+            }
+        }
+
+        // The arena is attached by ObservedArena, which is constructed
+        // before the observer base.
+        UtilizationObserver::UtilizationObserver() :
+            ObservedArena(),
+            tbb::task_scheduler_observer(mArena),
+            mBegin(0)
+        {
+            observe(true);
+        }
+
+        UtilizationObserver::~UtilizationObserver()
+        {
+            observe(false);
+        }
+
+        void UtilizationObserver::beginPhase()
+        {
+            auto& master = getThreadCounters();
+            auto& registry = getRegistry();
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            mThreads.clear();
+            mBegin = now();
+
+            {
+                std::lock_guard<std::mutex> registryLock(registry.mutex);
+                for (auto& counters : registry.threads)
+                {
+                    auto& state = mThreads[counters->id];
+                    state.busy = counters->busy.load(
+                        std::memory_order_relaxed);
+                    state.tasks = counters->tasks.load(
+                        std::memory_order_relaxed);
+                    state.parallel = counters->parallel.load(
+                        std::memory_order_relaxed);
+                }
+            }
+
+            auto& state = mThreads[master.id];
+            state.master = true;
+            state.seen = true;
+            state.inside = true;
+            state.entered = mBegin;
+        }
+
+        void UtilizationObserver::endPhase(PhaseStats& phase)
+        {
+            auto end = now();
+            auto& registry = getRegistry();
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            std::lock_guard<std::mutex> registryLock(registry.mutex);
+            phase.workers.clear();
+            for (auto& counters : registry.threads)
+            {
+                auto& state = mThreads[counters->id];
+                auto busy = counters->busy.load(std::memory_order_relaxed) -
+                    state.busy;
+                auto tasks = counters->tasks.load(std::memory_order_relaxed) -
+                    state.tasks;
+                auto parallel = counters->parallel.load(
+                    std::memory_order_relaxed) - state.parallel;
+
+                auto active = state.active;
+                if (state.inside)
+                {
+                    active += end - state.entered;
+                }
+                else if (!state.seen && tasks != 0)
+                {
+                    active = end - mBegin;
+                }
+
+                if (!state.seen && tasks == 0)
+                {
+                    continue;
+                }
+
+                WorkerStats worker;
+                worker.master = state.master;
+                worker.active = toSeconds(active);
+                worker.busy = toSeconds(busy);
+
+                // The calling thread counts as active for the whole phase, but
+                // it only waits on the arena inside parallel algorithms.
+                // Outside of them it runs the serial part of the phase.
+                auto waiting = worker.active - worker.busy;
+                if (state.master)
+                {
+                    waiting = std::min(waiting,
+                        toSeconds(parallel) - worker.busy);
+                }
+                worker.idle = std::max(waiting, 0.0);
+                worker.serial = std::max(
+                    worker.active - worker.busy - worker.idle, 0.0);
+                worker.tasks = tasks;
+                worker.entries = state.entries;
+                worker.exits = state.exits;
+                phase.workers.push_back(worker);
+            }
+
+            std::stable_partition(phase.workers.begin(),
+                phase.workers.end(),
+                [](WorkerStats const& w) { return w.master; });
+        }
+
+        void UtilizationObserver::on_scheduler_entry(bool)
+        {
+            auto thread = getThreadCounters().id;
+            auto time = now();
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto& state = mThreads[thread];
+            state.seen = true;
+            state.inside = true;
+            state.entered = time;
+            ++state.entries;
+        }
+
+        void UtilizationObserver::on_scheduler_exit(bool)
+        {
+            auto thread = getThreadCounters().id;
+            auto time = now();
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto& state = mThreads[thread];
+            if (state.inside)
+            {
+                state.active += time - state.entered;
+            }
+            else if (!state.seen)
+            {
+                // In the arena since before the phase began.
+                state.active += time - mBegin;
+            }
+
+            state.seen = true;
+            state.inside = false;
+            ++state.exits;
+        }
+
+        void writeUtilization(PhaseStats const& phase, std::ostream& out)
+        {
+            if (phase.workers.empty())
+            {
+                return;
+            }
+
+            WorkerStats total;
+            for (auto& worker : phase.workers)
+            {
+                total.active += worker.active;
+                total.busy += worker.busy;
+                total.idle += worker.idle;
+                total.serial += worker.serial;
+                total.tasks += worker.tasks;
+                total.entries += worker.entries;
+                total.exits += worker.exits;
+            }
+
+            double percent = (total.active > 0.0) ?
+                100.0 * total.busy / total.active : 0.0;
+            out << "Utilization: " << phase.workers.size() << " threads, " <<
+                total.busy << " seconds busy, " << total.idle <<
+                " seconds idle, " << total.serial << " seconds serial (" <<
+                percent << "% busy), " << total.tasks <<
+                " tasks, " << total.entries << " arena entries, " <<
+                total.exits << " exits\n";
+
+            for (std::size_t i = 0; i < phase.workers.size(); ++i)
+            {
+                auto const& worker = phase.workers[i];
+                out << "  Thread " << i << (worker.master ? " (master)" : "") <<
+                    ": " << worker.active << " seconds active, " <<
+                    worker.busy << " busy, " << worker.idle << " idle, " <<
+                    worker.serial << " serial, " << worker.tasks << " tasks, " << worker.entries <<
+                    " entries, " << worker.exits << " exits\n";
+            }
+        }
+    }
+}
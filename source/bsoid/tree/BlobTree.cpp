@@ -1,6 +1,184 @@
 #include "bsoid/tree/BlobTree.hpp"
+#include "bsoid/tree/Snapshot.hpp"
 
+#include "bsoid/fields/Sphere.hpp"
+#include "bsoid/fields/Torus.hpp"
+#include "bsoid/operators/Blend.hpp"
+#include "bsoid/operators/Intersection.hpp"
+#include "bsoid/operators/Union.hpp"
+#include "bsoid/operators/Transform.hpp"
+
+#include <atlas/core/Log.hpp>
+#include <atlas/utils/BlockWriter.hpp>
+
+#include <cstring>
 #include <sstream>
+#include <unordered_map>
+
+namespace
+{
+    using bsoid::fields::FieldType;
+    using bsoid::fields::ImplicitField;
+    using bsoid::fields::ImplicitFieldPtr;
+    using bsoid::operators::ImplicitOperator;
+    using bsoid::tree::FieldRecord;
+
+    // Appends the fields reachable from root to the list, children first.
+    // Fields that are already in the list are skipped, so shared fields are
+    // only stored once.
+    void collectFields(ImplicitFieldPtr const& root,
+        std::unordered_map<ImplicitField const*, std::uint32_t>& index,
+        std::vector<ImplicitFieldPtr>& fields)
+    {
+        if (!root || index.find(root.get()) != index.end())
+        {
+            return;
+        }
+
+        // Deep trees (long chains of transforms for instance) are walked
+        // with an explicit stack.
+        std::vector<std::pair<ImplicitFieldPtr, bool>> stack;
+        stack.emplace_back(root, false);
+        while (!stack.empty())
+        {
+            auto entry = stack.back();
+            stack.pop_back();
+            auto field = entry.first.get();
+            if (index.find(field) != index.end())
+            {
+                continue;
+            }
+
+            if (entry.second)
+            {
+                index[field] = static_cast<std::uint32_t>(fields.size());
+                fields.push_back(entry.first);
+                continue;
+            }
+
+            stack.emplace_back(entry.first, true);
+            auto op = dynamic_cast<ImplicitOperator const*>(field);
+            if (op)
+            {
+                auto const& children = op->getFields();
+                for (auto it = children.rbegin(); it != children.rend(); ++it)
+                {
+                    stack.emplace_back(*it, false);
+                }
+            }
+        }
+    }
+
+    bool makeRecord(ImplicitField const& field, FieldRecord& record)
+    {
+        using bsoid::fields::Sphere;
+        using bsoid::fields::Torus;
+        using bsoid::operators::Transform;
+
+        record = {};
+        record.type = field.getType();
+        switch (record.type)
+        {
+        case FieldType::Sphere:
+        {
+            auto const& sphere = static_cast<Sphere const&>(field);
+            auto centre = sphere.getCentre();
+            record.params[0] = sphere.getRadius();
+            record.params[1] = centre.x;
+            record.params[2] = centre.y;
+            record.params[3] = centre.z;
+            return true;
+        }
+
+        case FieldType::Torus:
+        {
+            auto const& torus = static_cast<Torus const&>(field);
+            auto centre = torus.getCentre();
+            record.params[0] = torus.getInnerRadius();
+            record.params[1] = torus.getOuterRadius();
+            record.params[2] = centre.x;
+            record.params[3] = centre.y;
+            record.params[4] = centre.z;
+            return true;
+        }
+
+        case FieldType::Transform:
+        {
+            auto const& transform = static_cast<Transform const&>(field);
+            auto matrix = transform.getTransform();
+            for (int c = 0; c < 4; ++c)
+            {
+                for (int r = 0; r < 4; ++r)
+                {
+                    record.params[4 * c + r] = matrix[c][r];
+                }
+            }
+            return true;
+        }
+
+        case FieldType::Blend:
+        case FieldType::Union:
+        case FieldType::Intersection:
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    ImplicitFieldPtr makeField(FieldRecord const& record)
+    {
+        using atlas::math::Point;
+        using atlas::math::Matrix4;
+
+        auto const& p = record.params;
+        switch (record.type)
+        {
+        case FieldType::Sphere:
+            return std::make_shared<bsoid::fields::Sphere>(p[0],
+                Point(p[1], p[2], p[3]));
+
+        case FieldType::Torus:
+            return std::make_shared<bsoid::fields::Torus>(p[0], p[1],
+                Point(p[2], p[3], p[4]));
+
+        case FieldType::Blend:
+            return std::make_shared<bsoid::operators::Blend>();
+
+        case FieldType::Union:
+            return std::make_shared<bsoid::operators::Union>();
+
+        case FieldType::Intersection:
+            return std::make_shared<bsoid::operators::Intersection>();
+
+        case FieldType::Transform:
+        {
+            Matrix4 matrix;
+            for (int c = 0; c < 4; ++c)
+            {
+                for (int r = 0; r < 4; ++r)
+                {
+                    matrix[c][r] = p[4 * c + r];
+                }
+            }
+            return std::make_shared<bsoid::operators::Transform>(matrix);
+        }
+
+        default:
+            return nullptr;
+        }
+    }
+
+    void pad(atlas::utils::BlockWriter& writer)
+    {
+        static const char zeros[bsoid::tree::SnapshotAlignment] = {};
+        auto offset = writer.bytesWritten() % bsoid::tree::SnapshotAlignment;
+        if (offset != 0)
+        {
+            writer.write(zeros, bsoid::tree::SnapshotAlignment - offset);
+        }
+    }
+}
 
 namespace bsoid
 {
@@ -115,5 +293,278 @@ namespace bsoid
             summary << ".\n";
             return summary.str();
         }
+
+        std::uint64_t BlobTree::getEvaluationCount() const
+        {
+            std::uint64_t total = 0;
+            for (auto& field : mSkeletalFields)
+            {
+                total += field->getCount();
+            }
+            return total;
+        }
+
+        bool BlobTree::saveToFile(std::string const& filename) const
+        {
+            using atlas::utils::BlockWriter;
+
+            if (!mFieldTree || !mVolumeTree)
+            {
+                ERROR_LOG("Cannot save an empty tree.");
+                return false;
+            }
+
+            std::unordered_map<fields::ImplicitField const*, std::uint32_t>
+                fieldIndex;
+            std::vector<fields::ImplicitFieldPtr> fields;
+            collectFields(mFieldTree, fieldIndex, fields);
+            for (auto& node : mNodes)
+            {
+                collectFields(node->getField(), fieldIndex, fields);
+            }
+            for (auto& field : mSkeletalFields)
+            {
+                collectFields(field, fieldIndex, fields);
+            }
+
+            std::vector<FieldRecord> fieldRecords(fields.size());
+            std::vector<std::uint32_t> fieldChildren;
+            for (std::size_t i = 0; i < fields.size(); ++i)
+            {
+                auto& record = fieldRecords[i];
+                if (!makeRecord(*fields[i], record))
+                {
+                    ERROR_LOG_V("Cannot save field of unknown type %d.",
+                        static_cast<int>(fields[i]->getType()));
+                    return false;
+                }
+
+                auto op = std::dynamic_pointer_cast<operators::ImplicitOperator>(
+                    fields[i]);
+                record.firstChild =
+                    static_cast<std::uint32_t>(fieldChildren.size());
+                if (op)
+                {
+                    for (auto& child : op->getFields())
+                    {
+                        fieldChildren.push_back(fieldIndex[child.get()]);
+                    }
+                }
+                record.numChildren = static_cast<std::uint32_t>(
+                    fieldChildren.size() - record.firstChild);
+            }
+
+            std::unordered_map<Node const*, std::uint32_t> nodeIndex;
+            for (std::size_t i = 0; i < mNodes.size(); ++i)
+            {
+                nodeIndex[mNodes[i].get()] = static_cast<std::uint32_t>(i);
+            }
+
+            std::vector<NodeRecord> nodeRecords(mNodes.size());
+            std::vector<std::uint32_t> nodeChildren;
+            for (std::size_t i = 0; i < mNodes.size(); ++i)
+            {
+                auto& record = nodeRecords[i];
+                record = {};
+                record.field = fieldIndex[mNodes[i]->getField().get()];
+                record.firstChild =
+                    static_cast<std::uint32_t>(nodeChildren.size());
+                for (auto& child : mNodes[i]->getChildren())
+                {
+                    auto index = nodeIndex[child.get()];
+                    if (index >= i)
+                    {
+                        ERROR_LOG_V("Cannot save node %d, its children must " \
+                            "come before it.", static_cast<int>(i));
+                        return false;
+                    }
+                    nodeChildren.push_back(index);
+                }
+                record.numChildren = static_cast<std::uint32_t>(
+                    nodeChildren.size() - record.firstChild);
+            }
+
+            std::vector<std::uint32_t> skeletalFields;
+            for (auto& field : mSkeletalFields)
+            {
+                skeletalFields.push_back(fieldIndex[field.get()]);
+            }
+
+            BlockWriter writer(filename);
+            if (!writer.isOpen())
+            {
+                return false;
+            }
+
+            auto align = [](std::uint64_t offset)
+            {
+                return (offset + SnapshotAlignment - 1) /
+                    SnapshotAlignment * SnapshotAlignment;
+            };
+
+            SnapshotHeader header = {};
+            std::memcpy(header.magic, SnapshotMagic, sizeof(SnapshotMagic));
+            header.version = SnapshotVersion;
+            header.numFields = static_cast<std::uint32_t>(fieldRecords.size());
+            header.numFieldChildren =
+                static_cast<std::uint32_t>(fieldChildren.size());
+            header.numNodes = static_cast<std::uint32_t>(nodeRecords.size());
+            header.numNodeChildren =
+                static_cast<std::uint32_t>(nodeChildren.size());
+            header.numSkeletalFields =
+                static_cast<std::uint32_t>(skeletalFields.size());
+            header.fieldRoot = fieldIndex[mFieldTree.get()];
+            header.nodeRoot = nodeIndex[mVolumeTree.get()];
+            header.fieldsOffset = align(sizeof(SnapshotHeader));
+            header.fieldChildrenOffset = align(header.fieldsOffset +
+                fieldRecords.size() * sizeof(FieldRecord));
+            header.nodesOffset = align(header.fieldChildrenOffset +
+                fieldChildren.size() * sizeof(std::uint32_t));
+            header.nodeChildrenOffset = align(header.nodesOffset +
+                nodeRecords.size() * sizeof(NodeRecord));
+            header.skeletalFieldsOffset = align(header.nodeChildrenOffset +
+                nodeChildren.size() * sizeof(std::uint32_t));
+
+            auto writeSection = [&writer](auto const& data)
+            {
+                pad(writer);
+                writer.write(data.data(),
+                    data.size() * sizeof(typename std::decay_t<
+                        decltype(data)>::value_type));
+            };
+
+            writer.write(header);
+            writeSection(fieldRecords);
+            writeSection(fieldChildren);
+            writeSection(nodeRecords);
+            writeSection(nodeChildren);
+            writeSection(skeletalFields);
+            writer.close();
+
+            if (!writer.good())
+            {
+                ERROR_LOG_V("Could not write tree to %s.", filename.c_str());
+                return false;
+            }
+
+            return true;
+        }
+
+        bool BlobTree::fromFile(std::string const& filename, BlobTree& tree)
+        {
+            Snapshot snapshot(filename);
+            if (!snapshot.isValid())
+            {
+                return false;
+            }
+
+            auto const& header = snapshot.header();
+            auto fieldRecords = snapshot.fields();
+            auto fieldChildren = snapshot.fieldChildren();
+            auto nodeRecords = snapshot.nodes();
+            auto nodeChildren = snapshot.nodeChildren();
+            auto skeletalFields = snapshot.skeletalFields();
+
+            auto inRange = [](std::uint32_t first, std::uint32_t count,
+                std::uint32_t size)
+            {
+                return first <= size && count <= size - first;
+            };
+
+            // Children always come before their parents, so every field can
+            // be assembled as soon as its record is reached.
+            std::vector<fields::ImplicitFieldPtr> fields(header.numFields);
+            for (std::uint32_t i = 0; i < header.numFields; ++i)
+            {
+                auto const& record = fieldRecords[i];
+                fields[i] = makeField(record);
+                if (!fields[i] || !inRange(record.firstChild,
+                    record.numChildren, header.numFieldChildren))
+                {
+                    ERROR_LOG_V("Tree snapshot %s has an invalid field %d.",
+                        filename.c_str(), i);
+                    return false;
+                }
+
+                if (record.numChildren == 0)
+                {
+                    continue;
+                }
+
+                auto op = std::dynamic_pointer_cast<operators::ImplicitOperator>(
+                    fields[i]);
+                if (!op)
+                {
+                    ERROR_LOG_V("Tree snapshot %s has an invalid field %d.",
+                        filename.c_str(), i);
+                    return false;
+                }
+
+                for (std::uint32_t c = 0; c < record.numChildren; ++c)
+                {
+                    auto child = fieldChildren[record.firstChild + c];
+                    if (child >= i)
+                    {
+                        ERROR_LOG_V("Tree snapshot %s has an invalid field %d.",
+                            filename.c_str(), i);
+                        return false;
+                    }
+                    op->insertField(fields[child]);
+                }
+            }
+
+            BlobTree result;
+            result.mNodes.reserve(header.numNodes);
+            for (std::uint32_t i = 0; i < header.numNodes; ++i)
+            {
+                auto const& record = nodeRecords[i];
+                if (record.field >= header.numFields || !inRange(
+                    record.firstChild, record.numChildren,
+                    header.numNodeChildren))
+                {
+                    ERROR_LOG_V("Tree snapshot %s has an invalid node %d.",
+                        filename.c_str(), i);
+                    return false;
+                }
+                result.mNodes.push_back(
+                    std::make_shared<Node>(fields[record.field]));
+            }
+
+            // Same order as insertNodeTree, so the boxes come out the same.
+            // Children have to come before their parents, which also rules
+            // out cycles.
+            for (std::uint32_t i = 0; i < header.numNodes; ++i)
+            {
+                auto const& record = nodeRecords[i];
+                for (std::uint32_t c = 0; c < record.numChildren; ++c)
+                {
+                    auto child = nodeChildren[record.firstChild + c];
+                    if (child >= i)
+                    {
+                        ERROR_LOG_V("Tree snapshot %s has an invalid node %d.",
+                            filename.c_str(), i);
+                        return false;
+                    }
+                    result.mNodes[i]->addChild(result.mNodes[child]);
+                }
+            }
+
+            result.mSkeletalFields.reserve(header.numSkeletalFields);
+            for (std::uint32_t i = 0; i < header.numSkeletalFields; ++i)
+            {
+                if (skeletalFields[i] >= header.numFields)
+                {
+                    ERROR_LOG_V("Tree snapshot %s has an invalid skeletal "
+                        "field %d.", filename.c_str(), i);
+                    return false;
+                }
+                result.mSkeletalFields.push_back(fields[skeletalFields[i]]);
+            }
+
+            result.mVolumeTree = result.mNodes[header.nodeRoot];
+            result.mFieldTree = fields[header.fieldRoot];
+            tree = std::move(result);
+            return true;
+        }
     }
 }
\ No newline at end of file
@@ -19,6 +19,11 @@ namespace bsoid
             mBox = field->getBBox();
         }
 
+        fields::ImplicitFieldPtr Node::getField() const
+        {
+            return mField;
+        }
+
         atlas::utils::BBox Node::getBBox() const
         {
             return mBox;
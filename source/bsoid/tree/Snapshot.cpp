@@ -0,0 +1,106 @@
+#include "bsoid/tree/Snapshot.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <cstring>
+
+namespace bsoid
+{
+    namespace tree
+    {
+        Snapshot::Snapshot(std::string const& filename) :
+            mFile(filename),
+            mValid(false)
+        {
+            if (!mFile.isOpen())
+            {
+                return;
+            }
+
+            if (mFile.size() < sizeof(SnapshotHeader))
+            {
+                ERROR_LOG_V("File %s is too small to be a tree snapshot.",
+                    filename.c_str());
+                return;
+            }
+
+            auto const& h = header();
+            if (std::memcmp(h.magic, SnapshotMagic, sizeof(SnapshotMagic)) != 0)
+            {
+                ERROR_LOG_V("File %s is not a tree snapshot.", filename.c_str());
+                return;
+            }
+
+            if (h.version != SnapshotVersion)
+            {
+                ERROR_LOG_V("Tree snapshot %s has version %d, expected %d.",
+                    filename.c_str(), h.version, SnapshotVersion);
+                return;
+            }
+
+            auto fits = [this](std::uint64_t offset, std::uint64_t count,
+                std::uint64_t size)
+            {
+                return offset % SnapshotAlignment == 0 &&
+                    offset <= mFile.size() &&
+                    count <= (mFile.size() - offset) / size;
+            };
+
+            if (!fits(h.fieldsOffset, h.numFields, sizeof(FieldRecord)) ||
+                !fits(h.fieldChildrenOffset, h.numFieldChildren,
+                    sizeof(std::uint32_t)) ||
+                !fits(h.nodesOffset, h.numNodes, sizeof(NodeRecord)) ||
+                !fits(h.nodeChildrenOffset, h.numNodeChildren,
+                    sizeof(std::uint32_t)) ||
+                !fits(h.skeletalFieldsOffset, h.numSkeletalFields,
+                    sizeof(std::uint32_t)))
+            {
+                ERROR_LOG_V("Tree snapshot %s is truncated.", filename.c_str());
+                return;
+            }
+
+            if (h.fieldRoot >= h.numFields || h.nodeRoot >= h.numNodes)
+            {
+                ERROR_LOG_V("Tree snapshot %s has no root.", filename.c_str());
+                return;
+            }
+
+            mValid = true;
+        }
+
+        bool Snapshot::isValid() const
+        {
+            return mValid;
+        }
+
+        SnapshotHeader const& Snapshot::header() const
+        {
+            return *section<SnapshotHeader>(0);
+        }
+
+        FieldRecord const* Snapshot::fields() const
+        {
+            return section<FieldRecord>(header().fieldsOffset);
+        }
+
+        std::uint32_t const* Snapshot::fieldChildren() const
+        {
+            return section<std::uint32_t>(header().fieldChildrenOffset);
+        }
+
+        NodeRecord const* Snapshot::nodes() const
+        {
+            return section<NodeRecord>(header().nodesOffset);
+        }
+
+        std::uint32_t const* Snapshot::nodeChildren() const
+        {
+            return section<std::uint32_t>(header().nodeChildrenOffset);
+        }
+
+        std::uint32_t const* Snapshot::skeletalFields() const
+        {
+            return section<std::uint32_t>(header().skeletalFieldsOffset);
+        }
+    }
+}
@@ -0,0 +1,134 @@
+#include "bsoid/visualizer/ChunkCuller.hpp"
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define BSOID_CULL_SSE 1
+#endif
+
+namespace
+{
+    using atlas::math::Matrix4;
+    using atlas::math::Vector4;
+
+    // The planes of the clip volume -w <= x, y, z <= w, pointing inwards.
+    // They are not normalized, which does not matter for the sign test.
+    void getFrustumPlanes(Matrix4 const& clip, Vector4 planes[6])
+    {
+        auto row = [&clip](int i)
+        {
+            return Vector4(clip[0][i], clip[1][i], clip[2][i], clip[3][i]);
+        };
+
+        for (int i = 0; i < 3; ++i)
+        {
+            planes[2 * i + 0] = row(3) + row(i);
+            planes[2 * i + 1] = row(3) - row(i);
+        }
+    }
+}
+
+namespace bsoid
+{
+    namespace visualizer
+    {
+        void ChunkCuller::clear()
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                mMin[i].clear();
+                mMax[i].clear();
+            }
+        }
+
+        void ChunkCuller::addChunk(atlas::utils::BBox const& bounds)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                mMin[i].push_back(bounds.pMin[i]);
+                mMax[i].push_back(bounds.pMax[i]);
+            }
+        }
+
+        std::size_t ChunkCuller::size() const
+        {
+            return mMin[0].size();
+        }
+
+        void ChunkCuller::cull(atlas::math::Matrix4 const& clip,
+            std::vector<std::uint32_t>& visible) const
+        {
+            visible.clear();
+            Vector4 planes[6];
+            getFrustumPlanes(clip, planes);
+
+            // A box is outside as soon as the corner furthest along the
+            // normal of a plane is behind it. Which corner that is only
+            // depends on the plane, so it is chosen once per plane.
+            float const* corners[6][3];
+            for (int p = 0; p < 6; ++p)
+            {
+                for (int i = 0; i < 3; ++i)
+                {
+                    corners[p][i] = (planes[p][i] > 0.0f) ? mMax[i].data() :
+                        mMin[i].data();
+                }
+            }
+
+            std::size_t count = size();
+            std::size_t c = 0;
+#if defined(BSOID_CULL_SSE)
+            __m128 normals[6][4];
+            for (int p = 0; p < 6; ++p)
+            {
+                for (int i = 0; i < 4; ++i)
+                {
+                    normals[p][i] = _mm_set1_ps(planes[p][i]);
+                }
+            }
+
+            auto const zero = _mm_setzero_ps();
+            for (; c + 4 <= count; c += 4)
+            {
+                auto inside = _mm_cmpeq_ps(zero, zero);
+                for (int p = 0; p < 6; ++p)
+                {
+                    auto x = _mm_mul_ps(normals[p][0],
+                        _mm_loadu_ps(corners[p][0] + c));
+                    auto y = _mm_mul_ps(normals[p][1],
+                        _mm_loadu_ps(corners[p][1] + c));
+                    auto z = _mm_mul_ps(normals[p][2],
+                        _mm_loadu_ps(corners[p][2] + c));
+                    auto d = _mm_add_ps(_mm_add_ps(x, y),
+                        _mm_add_ps(z, normals[p][3]));
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(d, zero));
+                }
+
+                int mask = _mm_movemask_ps(inside);
+                for (int i = 0; i < 4; ++i)
+                {
+                    if (mask & (1 << i))
+                    {
+                        visible.push_back(static_cast<std::uint32_t>(c + i));
+                    }
+                }
+            }
+#endif
+
+            for (; c < count; ++c)
+            {
+                bool inside = true;
+                for (int p = 0; p < 6 && inside; ++p)
+                {
+                    inside = planes[p].x * corners[p][0][c] +
+                        planes[p].y * corners[p][1][c] +
+                        planes[p].z * corners[p][2][c] + planes[p].w >= 0.0f;
+                }
+
+                if (inside)
+                {
+                    visible.push_back(static_cast<std::uint32_t>(c));
+                }
+            }
+        }
+    }
+}
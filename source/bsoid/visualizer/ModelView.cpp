@@ -4,8 +4,12 @@
 
 #include <atlas/utils/GUI.hpp>
 #include <atlas/core/Enum.hpp>
-#include <ctime>
-#include<iostream>
+#include <atlas/core/Log.hpp>
+#include <atlas/core/Timer.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
 
 #if defined ATLAS_DEBUG
 #define ATHENA_DEBUG_CONTOURS 1 
@@ -21,6 +25,14 @@ enum class ShaderNames : int
 namespace gl = atlas::gl;
 namespace math = atlas::math;
 
+// Packed normals make a vertex 16 bytes instead of 24.
+static const auto NormalFormat = bsoid::polygonizer::NormalFormat::Packed;
+
+// The LOD pyramid has at most this many levels, and a level is only added if
+// it is still at least this many voxels across.
+static constexpr std::size_t MaxLodLevels = 3;
+static constexpr std::uint32_t MinLodVoxels = 16;
+
 namespace bsoid
 {
     namespace visualizer
@@ -35,17 +47,24 @@ namespace bsoid
         mMeshData(GL_ARRAY_BUFFER),
         mMeshIndices(GL_ELEMENT_ARRAY_BUFFER),
         mMeshNumIndices(0),
-        mMCData(GL_ARRAY_BUFFER),
-        mMCIndices(GL_ELEMENT_ARRAY_BUFFER),
-        mMCNumIndices(0),
+        mFinestLevel(0),
+        mLevelsUploaded(0),
+        mLodPixels(2.0f),
+        mCullChunks(true),
         mShowLattices(false),
         mShowMesh(false),
         mShowMCMesh(true),
         mHasMC(true),
         mRenderMode(0),
-        mSelectedSlice(0)
+        mSelectedSlice(0),
+        mMCReady(false),
+        mLevelsDone(0),
+        mProgressLevel(0),
+        mStreamVertexCapacity(0),
+        mStreamIndexCapacity(0)
         {
             initShaders();
+            startPolygonization();
         }
         
         ModelView::ModelView(polygonizer::Bsoid&& soid, polygonizer::MarchingCubes&& mc) :
@@ -57,17 +76,24 @@ namespace bsoid
         mMeshData(GL_ARRAY_BUFFER),
         mMeshIndices(GL_ELEMENT_ARRAY_BUFFER),
         mMeshNumIndices(0),
-        mMCData(GL_ARRAY_BUFFER),
-        mMCIndices(GL_ELEMENT_ARRAY_BUFFER),
-        mMCNumIndices(0),
+        mFinestLevel(0),
+        mLevelsUploaded(0),
+        mLodPixels(2.0f),
+        mCullChunks(true),
         mShowLattices(false),
         mShowMesh(false),
         mShowMCMesh(true),
         mHasMC(true),
         mRenderMode(0),
-        mSelectedSlice(0)
+        mSelectedSlice(0),
+        mMCReady(false),
+        mLevelsDone(0),
+        mProgressLevel(0),
+        mStreamVertexCapacity(0),
+        mStreamIndexCapacity(0)
         {
             initShaders();
+            startPolygonization();
         }
  
 
@@ -80,17 +106,24 @@ namespace bsoid
         mMeshData(GL_ARRAY_BUFFER),
         mMeshIndices(GL_ELEMENT_ARRAY_BUFFER),
         mMeshNumIndices(0),
-        mMCData(GL_ARRAY_BUFFER),
-        mMCIndices(GL_ELEMENT_ARRAY_BUFFER),
-        mMCNumIndices(0),
+        mFinestLevel(0),
+        mLevelsUploaded(0),
+        mLodPixels(2.0f),
+        mCullChunks(true),
         mShowLattices(false),
         mShowMesh(false),
         mShowMCMesh(true),
         mHasMC(true),
         mRenderMode(0),
-        mSelectedSlice(0)
+        mSelectedSlice(0),
+        mMCReady(false),
+        mLevelsDone(0),
+        mProgressLevel(0),
+        mStreamVertexCapacity(0),
+        mStreamIndexCapacity(0)
         {
             initShaders();
+            startPolygonization();
         }
 
         std::string ModelView::getModelName() const
@@ -102,32 +135,28 @@ namespace bsoid
         void ModelView::renderGeometry(atlas::math::Matrix4 const& projection,
                                        atlas::math::Matrix4 const& view)
         {
+            // Nothing to draw until the first chunks have been uploaded.
+            if (!pollPolygonization())
+            {
+                return;
+            }
+
             if(!mShaders[0].getShaderProgram())
             {
                 printf("Render ERROR\n");
 
             }
-            printf("\ninside render, print: %lu\n",mMCNumIndices);
-
-            printf("ha1");
-
                 mShaders[0].hotReloadShaders();
-            printf("ha2");
 
                 if (!mShaders[0].shaderProgramValid())
                 {
-                    printf("ha3");
                     return;
                 }
             
-            printf("ha");
             using atlas::core::enumToUnderlyingType;
 
             mShaders[0].enableShaders();
 
-                mMCVao.bindVertexArray();
-                mMCIndices.bindBuffer();
-
 //                    auto meshIndex = enumToUnderlyingType(ShaderNames::Mesh);
                     mShaders[0].enableShaders();
 
@@ -143,16 +172,10 @@ namespace bsoid
 //            mMCVao.bindVertexArray();
 //                    mMCIndices.bindBuffer();
 
-                    glDrawElements(GL_TRIANGLES, (GLsizei)mMCNumIndices,
-                        GL_UNSIGNED_INT, 0);
-
+            drawLevels(projection, view);
 
-                mMCIndices.unBindBuffer();
-                mMCVao.unBindVertexArray();
             mShaders[0].disableShaders();
 
-
-            printf("\ninside render, print: %lu\n",mMCNumIndices);
         }
 
         void ModelView::drawGui()
@@ -164,6 +187,28 @@ namespace bsoid
             ImGui::Dummy(ImVec2(0, 10));
             ImGui::Text("Generation controls");
             ImGui::Separator();
+            if (!mMCReady)
+            {
+                // Steps without a known total only show how much was done.
+                char overlay[64];
+                if (mProgress.total() == 0)
+                {
+                    std::snprintf(overlay, sizeof(overlay),
+                        "Level %zu, %s: %llu", mProgressLevel.load(),
+                        mProgress.step(),
+                        static_cast<unsigned long long>(mProgress.done()));
+                }
+                else
+                {
+                    std::snprintf(overlay, sizeof(overlay),
+                        "Level %zu, %s: %.0f%%", mProgressLevel.load(),
+                        mProgress.step(), 100.0f * mProgress.fraction());
+                }
+                ImGui::Text("Polygonizing... levels ready: %zu of %zu",
+                    mLevelsUploaded, mLevels.size());
+                ImGui::ProgressBar(mProgress.fraction(), ImVec2(-1, 0),
+                    overlay);
+            }
 //            if (mHasMC)
 //            {
 //                if (ImGui::Button("Construct MC mesh"))
@@ -183,6 +228,14 @@ namespace bsoid
             ImGui::Checkbox("Show lattices", &mShowLattices);
             ImGui::Checkbox("Show mesh", &mShowMesh);
             ImGui::Checkbox("Show MC mesh", &mShowMCMesh);
+            ImGui::Checkbox("Frustum culling", &mCullChunks);
+            ImGui::SliderFloat("LOD voxel size (pixels)", &mLodPixels, 0.5f,
+                16.0f);
+            for (std::size_t l = 0; l < mLevels.size(); ++l)
+            {
+                ImGui::Text("Level %zu chunks drawn: %zu of %zu", l,
+                    mLevels[l]->numDrawn, mLevels[l]->counts.size());
+            }
 
             ImGui::Dummy(ImVec2(0, 10));
             ImGui::Text("Log");
@@ -214,73 +267,7 @@ namespace bsoid
 //            auto normals = mMC.getMesh().normals();
 //            auto idx = mMC.getMesh().indices();
 //            mMC.saveMesh();
-       //bsoid test
-            using namespace std;
-            
-            clock_t start = clock();
-            mMC.polygonize();
-//            mSoid.polygonize();
-            clock_t end = clock();
-            cout << "花费了" << (double)(end - start) / CLOCKS_PER_SEC << "秒" << endl;
-
-            auto verts = mMC.getMesh().vertices();
-            auto normals = mMC.getMesh().normals();
-            auto idx = mMC.getMesh().indices();
-            mMC.saveMesh();
-            //=======
-            
-            mMCNumVertices = verts.size();
-            mMCNumIndices = idx.size();
-            printf("data!\n ");
-            
-            std::vector<float> data;
-            for (std::size_t i = 0; i < verts.size(); ++i)
-            {
-                data.push_back(verts[i].x);
-                data.push_back(verts[i].y);
-                data.push_back(verts[i].z);
-                
-                data.push_back(normals[i].x);
-                data.push_back(normals[i].y);
-                data.push_back(normals[i].z);
-                printf("%f-%f-%f\n",verts[i].x,verts[i].y,verts[i].z);
-            }
-            printf("size %lu %lu",verts.size(),mMCNumIndices);
-            
-            mMCVao.bindVertexArray();
-            mMCData.bindBuffer();
-            mMCData.bufferData(gl::size<float>(data.size()), data.data(),
-                               GL_STATIC_DRAW);
-            mMCData.vertexAttribPointer(VERTICES_LAYOUT_LOCATION, 3,
-                                        GL_FLOAT, GL_FALSE, gl::stride<float>(6),
-                                        gl::bufferOffset<float>(0));
-            mMCData.vertexAttribPointer(NORMALS_LAYOUT_LOCATION, 3,
-                                        GL_FLOAT, GL_FALSE, gl::stride<float>(6),
-                                        gl::bufferOffset<float>(3));
-            mMCVao.enableVertexAttribArray(VERTICES_LAYOUT_LOCATION);
-            mMCVao.enableVertexAttribArray(NORMALS_LAYOUT_LOCATION);
-            
-            mMCIndices.bindBuffer();
-            mMCIndices.bufferData(
-                                  gl::size<GLuint>(idx.size()), idx.data(), GL_STATIC_DRAW);
-            glDrawElements(GL_TRIANGLES, (GLsizei)mMCNumIndices,
-                           GL_UNSIGNED_INT, 0);
-            mMCIndices.unBindBuffer();
-            mMCData.unBindBuffer();
-            mMCVao.unBindVertexArray();
 
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
-            
 //            mMCVao.bindVertexArray();
 //            mMCIndices.bindBuffer();
 //            
@@ -456,53 +443,448 @@ namespace bsoid
 
    
 
-        void ModelView::constructMCMesh()
+        ModelView::LodLevel::LodLevel() :
+            data(GL_ARRAY_BUFFER),
+            indices(GL_ELEMENT_ARRAY_BUFFER),
+            numIndices(0),
+            numVertices(0),
+            numDrawn(0)
+        { }
+
+        void ModelView::startPolygonization()
         {
-            mMC.polygonize();
-
-            auto verts = mMC.getMesh().vertices();
-            auto normals = mMC.getMesh().normals();
-            auto idx = mMC.getMesh().indices();
-            mMC.saveMesh();
-            mMCNumVertices = verts.size();
-            mMCNumIndices = idx.size();
-            printf("data!\n ");
-
-            std::vector<float> data;
-            for (std::size_t i = 0; i < verts.size(); ++i)
+            // Everything but the upload runs on the worker, the GL context
+            // stays on this thread.
+            mMCReady = false;
+            mLevels.clear();
+            mCoarseMC.clear();
+            mFinestLevel = 0;
+            mLevelsUploaded = 0;
+            mLevelsDone = 0;
+            mStreamVertices.clear();
+            mStreamIndices.clear();
+            mStreamVertexCapacity = 0;
+            mStreamIndexCapacity = 0;
+
+            if (!mMC.tree())
+            {
+                mMCReady = true;
+                return;
+            }
+
+            // Each level halves the resolution of the one below it, so that
+            // a block of a level covers exactly 2x2x2 blocks of the one
+            // below. The resolution is rounded up to make the halving exact.
+            std::uint32_t res = mMC.getResolution().x;
+            std::size_t numLevels = 1;
+            while (numLevels < MaxLodLevels &&
+                ((res - 1) >> numLevels) >= MinLodVoxels)
+            {
+                ++numLevels;
+            }
+            std::uint32_t step = 1u << (numLevels - 1);
+            res = ((res - 1 + step - 1) / step) * step + 1;
+            mMC.setResolution(res);
+            for (std::size_t l = 1; l < numLevels; ++l)
+            {
+                auto mc = std::make_unique<polygonizer::MarchingCubes>(
+                    *mMC.tree(), mMC.getName(), mMC.getIsoValue());
+                mc->setResolution(((res - 1) >> l) + 1);
+                mCoarseMC.push_back(std::move(mc));
+            }
+
+            for (std::size_t l = 0; l < numLevels; ++l)
             {
-                data.push_back(verts[i].x);
-                data.push_back(verts[i].y);
-                data.push_back(verts[i].z);
-
-                data.push_back(normals[i].x);
-                data.push_back(normals[i].y);
-                data.push_back(normals[i].z);
-                printf("%f-%f-%f\n",verts[i].x,verts[i].y,verts[i].z);
+                mLevels.push_back(std::make_unique<LodLevel>());
             }
-            printf("size %lu %lu",verts.size(),mMCNumIndices);
 
-            mMCVao.bindVertexArray();
-            mMCData.bindBuffer();
-            mMCData.bufferData(gl::size<float>(data.size()), data.data(),
+            auto box = mMC.tree()->getTreeBox();
+            mGridOrigin = box.pMin;
+            mVoxelSize = glm::abs(box.pMax - box.pMin) /
+                static_cast<float>(res - 1);
+
+            // Only the coarsest level is streamed, the finer ones take long
+            // enough that a finished coarse level is shown in the meantime.
+            auto& coarsest = getPolygonizer(numLevels - 1);
+            mMemorySink = std::make_unique<polygonizer::MemoryMeshSink>(
+                coarsest.getMesh(), coarsest.getChunks());
+            mStream = std::make_unique<polygonizer::QueueMeshSink>(
+                *mMemorySink);
+            mJob = std::async(std::launch::async, [this]()
+            {
+                // Wall time, the polygonizers run on every TBB thread.
+                atlas::core::Timer<float> global;
+                global.start();
+                for (std::size_t l = mLevels.size(); l-- > 0;)
+                {
+                    atlas::core::Timer<float> level;
+                    level.start();
+                    auto& mc = getPolygonizer(l);
+                    mProgressLevel.store(l, std::memory_order_relaxed);
+                    mc.setProgress(&mProgress);
+                    if (l + 1 == mLevels.size())
+                    {
+                        mc.polygonize(*mStream);
+                    }
+                    else
+                    {
+                        polygonizer::MemoryMeshSink sink(mc.getMesh(),
+                            mc.getChunks());
+                        mc.polygonize(sink);
+                    }
+                    mc.optimizeMesh();
+                    mc.setProgress(nullptr);
+                    INFO_LOG_V("ModelView: Level %zu done in %f seconds.", l,
+                        level.elapsed());
+                    mLevelsDone.fetch_add(1, std::memory_order_release);
+                }
+                INFO_LOG_V("ModelView: Polygonization done in %f seconds.",
+                    global.elapsed());
+                mMC.saveMesh();
+            });
+        }
+
+        bool ModelView::pollPolygonization()
+        {
+            if (mMCReady)
+            {
+                return !mLevels.empty();
+            }
+
+            // Levels are finished coarsest first. The optimized coarsest
+            // level replaces whatever was streamed of it.
+            auto done = mLevelsDone.load(std::memory_order_acquire);
+            while (mLevelsUploaded < done)
+            {
+                auto level = mLevels.size() - 1 - mLevelsUploaded;
+                if (mLevelsUploaded == 0)
+                {
+                    mStream.reset();
+                    mMemorySink.reset();
+                    std::vector<unsigned char>().swap(mStreamVertices);
+                    std::vector<GLuint>().swap(mStreamIndices);
+                }
+
+                constructMCMesh(level);
+                mFinestLevel = level;
+                ++mLevelsUploaded;
+            }
+
+            if (mLevelsUploaded == 0)
+            {
+                streamChunks();
+                return mLevels.back()->numIndices != 0;
+            }
+
+            // The worker still saves the mesh after the last level.
+            if (mLevelsUploaded == mLevels.size() &&
+                mJob.wait_for(std::chrono::seconds(0)) ==
+                std::future_status::ready)
+            {
+                mJob.get();
+                mMCReady = true;
+            }
+            return true;
+        }
+
+        void ModelView::streamChunks()
+        {
+            // Limits the vertices and indices taken per frame so a burst of
+            // chunks does not stall the frame.
+            constexpr std::size_t budget = 1 << 18;
+
+            auto& level = *mLevels.back();
+            auto stride = polygonizer::getVertexStride(NormalFormat);
+            auto vertexStart = mStreamVertices.size();
+            auto indexStart = mStreamIndices.size();
+            std::size_t taken = 0;
+            polygonizer::MeshChunk chunk;
+            while (taken < budget && mStream->pop(chunk))
+            {
+                addChunk(level, chunk.id, chunk.bounds, mStreamIndices.size(),
+                    chunk.indices.size());
+                auto offset = mStreamVertices.size();
+                mStreamVertices.resize(offset +
+                    chunk.vertices.size() * stride);
+                polygonizer::writeInterleaved(chunk.vertices.data(),
+                    chunk.normals.data(), chunk.vertices.size(), NormalFormat,
+                    mStreamVertices.data() + offset);
+                mStreamIndices.insert(mStreamIndices.end(),
+                    chunk.indices.begin(), chunk.indices.end());
+                taken += chunk.vertices.size() + chunk.indices.size();
+            }
+
+            if (taken == 0)
+            {
+                return;
+            }
+
+            // The buffers grow geometrically. Growing orphans the old store
+            // and uploads everything again, otherwise only the new data is
+            // written. Capacities are in bytes and elements.
+            level.vao.bindVertexArray();
+            level.data.bindBuffer();
+            if (mStreamVertices.size() > mStreamVertexCapacity)
+            {
+                mStreamVertexCapacity = std::max(2 * mStreamVertexCapacity,
+                    mStreamVertices.size());
+                level.data.bufferData(mStreamVertexCapacity, nullptr,
+                    GL_DYNAMIC_DRAW);
+                vertexStart = 0;
+                setVertexLayout(level);
+            }
+            level.data.bufferSubData(vertexStart,
+                mStreamVertices.size() - vertexStart,
+                mStreamVertices.data() + vertexStart);
+
+            level.indices.bindBuffer();
+            if (mStreamIndices.size() > mStreamIndexCapacity)
+            {
+                mStreamIndexCapacity = std::max(2 * mStreamIndexCapacity,
+                    mStreamIndices.size());
+                level.indices.bufferData(
+                    gl::size<GLuint>(mStreamIndexCapacity), nullptr,
+                    GL_DYNAMIC_DRAW);
+                indexStart = 0;
+            }
+            level.indices.bufferSubData(gl::size<GLuint>(indexStart),
+                gl::size<GLuint>(mStreamIndices.size() - indexStart),
+                mStreamIndices.data() + indexStart);
+
+            level.vao.unBindVertexArray();
+            level.indices.unBindBuffer();
+            level.data.unBindBuffer();
+
+            level.numVertices = mStreamVertices.size() / stride;
+            level.numIndices = mStreamIndices.size();
+        }
+
+        void ModelView::setVertexLayout(LodLevel& level)
+        {
+            auto stride = static_cast<GLsizei>(
+                polygonizer::getVertexStride(NormalFormat));
+            level.data.vertexAttribPointer(VERTICES_LAYOUT_LOCATION, 3,
+                GL_FLOAT, GL_FALSE, stride, gl::bufferOffset<float>(0));
+            if (NormalFormat == polygonizer::NormalFormat::Packed)
+            {
+                level.data.vertexAttribPointer(NORMALS_LAYOUT_LOCATION, 4,
+                    GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+                    gl::bufferOffset<float>(3));
+            }
+            else
+            {
+                level.data.vertexAttribPointer(NORMALS_LAYOUT_LOCATION, 3,
+                    GL_FLOAT, GL_FALSE, stride, gl::bufferOffset<float>(3));
+            }
+            level.vao.enableVertexAttribArray(VERTICES_LAYOUT_LOCATION);
+            level.vao.enableVertexAttribArray(NORMALS_LAYOUT_LOCATION);
+        }
+
+        polygonizer::MarchingCubes& ModelView::getPolygonizer(
+            std::size_t level)
+        {
+            return (level == 0) ? mMC : *mCoarseMC[level - 1];
+        }
+
+        void ModelView::constructMCMesh(std::size_t level)
+        {
+            auto& lod = *mLevels[level];
+            auto& mc = getPolygonizer(level);
+            auto& mesh = mc.getMesh();
+            auto const& verts = mesh.vertices();
+            auto const& normals = mesh.normals();
+            auto const& idx = mesh.indices();
+            lod.numVertices = verts.size();
+            lod.numIndices = idx.size();
+
+            // The optimized mesh keeps the chunks contiguous, but they may
+            // not be in the order they were streamed in. Without them the
+            // level cannot be mixed with the others.
+            lod.culler.clear();
+            lod.blocks.clear();
+            lod.counts.clear();
+            lod.firsts.clear();
+            lod.visible.clear();
+            auto const& chunks = mc.getChunks();
+            if (!polygonizer::getChunkOffsets(chunks, idx.size()).empty())
+            {
+                for (auto& chunk : chunks)
+                {
+                    addChunk(lod, chunk.id, chunk.bounds, chunk.firstIndex,
+                        chunk.numIndices);
+                }
+            }
+            else
+            {
+                WARN_LOG_V("Level %zu has no chunks, it is drawn whole.",
+                    level);
+            }
+
+            // The vertices are interleaved straight into the new store and
+            // the indices are uploaded from the mesh itself.
+            auto size = static_cast<GLsizeiptr>(verts.size() *
+                polygonizer::getVertexStride(NormalFormat));
+            lod.vao.bindVertexArray();
+            lod.data.bindBuffer();
+            lod.data.bufferData(size, nullptr, GL_STATIC_DRAW);
+            if (size != 0)
+            {
+                auto data = lod.data.mapBufferRange(0, size,
+                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+                if (data)
+                {
+                    polygonizer::writeInterleaved(verts.data(),
+                        normals.data(), verts.size(), NormalFormat, data);
+                    lod.data.unMapBuffer();
+                }
+                else
+                {
+                    ERROR_LOG("Could not map the vertex buffer.");
+                    lod.numIndices = 0;
+                }
+            }
+            setVertexLayout(lod);
+
+            lod.indices.bindBuffer();
+            lod.indices.bufferData(gl::size<GLuint>(idx.size()), idx.data(),
                 GL_STATIC_DRAW);
-            mMCData.vertexAttribPointer(VERTICES_LAYOUT_LOCATION, 3,
-                GL_FLOAT, GL_FALSE, gl::stride<float>(6),
-                gl::bufferOffset<float>(0));
-            mMCData.vertexAttribPointer(NORMALS_LAYOUT_LOCATION, 3,
-                GL_FLOAT, GL_FALSE, gl::stride<float>(6), 
-                gl::bufferOffset<float>(3));
-            mMCVao.enableVertexAttribArray(VERTICES_LAYOUT_LOCATION);
-            mMCVao.enableVertexAttribArray(NORMALS_LAYOUT_LOCATION);
-
-            mMCIndices.bindBuffer();
-            mMCIndices.bufferData(
-                gl::size<GLuint>(idx.size()), idx.data(), GL_STATIC_DRAW);
-            glDrawElements(GL_TRIANGLES, (GLsizei)mMCNumIndices,
-                           GL_UNSIGNED_INT, 0);
-            mMCIndices.unBindBuffer();
-            mMCData.unBindBuffer();
-            mMCVao.unBindVertexArray();
+            lod.vao.unBindVertexArray();
+            lod.indices.unBindBuffer();
+            lod.data.unBindBuffer();
+        }
+
+        void ModelView::addChunk(LodLevel& level, std::uint64_t id,
+            atlas::utils::BBox const& bounds, std::size_t firstIndex,
+            std::size_t numIndices)
+        {
+            level.culler.addChunk(bounds);
+            level.blocks.push_back(
+                polygonizer::MarchingCubes::getChunkBlock(id));
+            level.counts.push_back(static_cast<GLsizei>(numIndices));
+            level.firsts.push_back(firstIndex);
+        }
+
+        bool ModelView::isCoarseEnough(std::size_t level,
+            glm::u32vec3 const& block, math::Point const& eye,
+            float pixelScale) const
+        {
+            auto voxel = mVoxelSize * static_cast<float>(1u << level);
+            auto extent = voxel * static_cast<float>(
+                polygonizer::MarchingCubes::ChunkSize);
+            auto pMin = mGridOrigin + glm::vec3(block) * extent;
+            auto pMax = pMin + extent;
+
+            // The distance to the closest point of the block, so that the
+            // blocks inside it are never closer to the eye than it is.
+            auto distance = glm::length(glm::max(glm::max(pMin - eye,
+                eye - pMax), glm::vec3(0.0f)));
+            float size = std::max(voxel.x, std::max(voxel.y, voxel.z));
+            return size * pixelScale <= mLodPixels * distance;
+        }
+
+        void ModelView::drawLevels(atlas::math::Matrix4 const& projection,
+            atlas::math::Matrix4 const& view)
+        {
+            if (mLevels.empty())
+            {
+                return;
+            }
+
+            // The eye is taken to model space, where the blocks are.
+            auto clip = projection * view * mModel;
+            math::Point eye(glm::inverse(view * mModel)[3]);
+            GLint viewport[4];
+            glGetIntegerv(GL_VIEWPORT, viewport);
+            float pixelScale = projection[1][1] * viewport[3] / 2.0f;
+
+            // Until the coarsest level is done only its streamed chunks are
+            // drawn.
+            std::size_t coarsest = mLevels.size() - 1;
+            std::size_t finest = (mLevelsUploaded == 0) ? coarsest :
+                mFinestLevel;
+            for (std::size_t l = finest; l <= coarsest; ++l)
+            {
+                auto& level = *mLevels[l];
+                level.numDrawn = 0;
+                if (level.numIndices == 0)
+                {
+                    continue;
+                }
+
+                level.vao.bindVertexArray();
+                level.indices.bindBuffer();
+
+                // Without chunks the whole mesh is drawn, which can only
+                // happen with a single level.
+                if (level.counts.empty())
+                {
+                    if (l == finest)
+                    {
+                        glDrawElements(GL_TRIANGLES,
+                            (GLsizei)level.numIndices, GL_UNSIGNED_INT, 0);
+                    }
+                    level.indices.unBindBuffer();
+                    level.vao.unBindVertexArray();
+                    continue;
+                }
+
+                if (mCullChunks)
+                {
+                    level.culler.cull(clip, level.visible);
+                }
+                else
+                {
+                    level.visible.resize(level.counts.size());
+                    std::iota(level.visible.begin(), level.visible.end(), 0u);
+                }
+
+                // A chunk is drawn at the coarsest level whose voxels are
+                // small enough on screen, or at the finest level there is.
+                // The blocks of a level nest inside those of the next, so
+                // every part of the surface is drawn at exactly one level.
+                // Chunks that follow each other in the index buffer are
+                // merged into a single draw.
+                mDrawCounts.clear();
+                mDrawOffsets.clear();
+                std::size_t end = 0;
+                for (auto c : level.visible)
+                {
+                    auto const& block = level.blocks[c];
+                    if (l != finest &&
+                        !isCoarseEnough(l, block, eye, pixelScale))
+                    {
+                        continue;
+                    }
+                    if (l != coarsest &&
+                        isCoarseEnough(l + 1, block / 2u, eye, pixelScale))
+                    {
+                        continue;
+                    }
+
+                    ++level.numDrawn;
+                    if (!mDrawCounts.empty() && level.firsts[c] == end)
+                    {
+                        mDrawCounts.back() += level.counts[c];
+                    }
+                    else
+                    {
+                        mDrawCounts.push_back(level.counts[c]);
+                        mDrawOffsets.push_back(
+                            gl::bufferOffset<GLuint>(level.firsts[c]));
+                    }
+                    end = level.firsts[c] + level.counts[c];
+                }
+
+                if (!mDrawCounts.empty())
+                {
+                    glMultiDrawElements(GL_TRIANGLES, mDrawCounts.data(),
+                        GL_UNSIGNED_INT, mDrawOffsets.data(),
+                        static_cast<GLsizei>(mDrawCounts.size()));
+                }
+
+                level.indices.unBindBuffer();
+                level.vao.unBindVertexArray();
+            }
         }
     }
 }
@@ -3,6 +3,7 @@
 #include "bsoid/visualizer/ModelView.hpp"
 #include "bsoid/visualizer/ModelVisualizer.hpp"
 #include "bsoid/models/Models.hpp"
+#include "bsoid/driver/Driver.hpp"
 
 #include <atlas/core/Log.hpp>
 #include <atlas/utils/Application.hpp>
@@ -145,86 +146,11 @@ int main()
 
 #else
 
-int main()
+// Without the GUI the executable is the headless benchmark driver, see
+// Driver.hpp for its options.
+int main(int argc, char** argv)
 {
-    INFO_LOG_V("Welcome to Bsoid %s", BSOID_VERSION_STRING);
-
-    constexpr auto TestMode = 0;
-
-    if (TestMode == 0)
-    {
-        std::fstream soidFile("bsoid_performance_summary.txt", 
-            std::fstream::out);
-        std::size_t res = 0;
-        for (std::size_t i = 12; i < 253; i++)
-        {
-            res = 8 + (2 * i);
-            INFO_LOG_V("Starting Bsoid run %d.", (i + 1));
-            auto modelFns = getModels({ res, res / 4 });
-            for (auto& modelFn : modelFns)
-            {
-                auto soid = modelFn();
-                soid.polygonize();
-                std::string log = soid.getLog();
-                soidFile << log;
-                soidFile << "\n\n";
-            }
-        }
-        soidFile.flush();
-
-        // Now run MC
-        res = 0;
-        std::fstream mcFile("mc_performance_summary.txt", std::fstream::out);
-        for (std::size_t i = 12; i < 253; i++)
-        {
-            res = 8 + (2 * i);
-            INFO_LOG_V("Staring MC run %d.", (i + 1));
-            auto modelFns = getMCModels({ res, res / 4 });
-            for (auto& modelFn : modelFns)
-            {
-                auto mc = modelFn();
-                mc.polygonize();
-                std::string log = mc.getLog();
-                mcFile << log;
-                mcFile << "\n\n";
-            }
-        }
-        mcFile.flush();
-    }
-    else
-    {
-        auto modelFns = getModels({ 178, 45 });
-        auto mcModelFns = getMCModels();
-
-        std::fstream file("summary.txt", std::fstream::out);
-
-        for (std::size_t i = 0; i < modelFns.size(); ++i)
-        {
-            {
-                auto soid = modelFns[i]();
-                INFO_LOG_V("Polygonizing model %s", soid.getName().c_str());
-                soid.polygonize();
-                std::string log = soid.getLog();
-                file << log;
-            }
-
-            //INFO_LOG_V("Finished Bsoid, starting MC.");
-            //{
-            //    auto mc = mcModelFns[i]();
-            //    mc.polygonize();
-            //    std::string log = mc.getLog();
-            //    file << "\n";
-            //    file << log;
-            //}
-            
-            file << "\n\n";
-            INFO_LOG("");
-            INFO_LOG("");
-
-        }
-    }
-
-    return 0;
+    return bsoid::driver::run(argc, argv);
 }
 
 #endif